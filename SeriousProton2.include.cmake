@@ -3,6 +3,7 @@ cmake_minimum_required(VERSION 3.10.0)
 set(SP2_SINGLE_EXECUTABLE OFF CACHE BOOL "Pack the result as a single executable, which is staticly linked and contains resources files appended as zip format.")
 set(SP2_STATIC_LINK OFF CACHE BOOL "Link SDL and mingw DLLs static, so you do not need a copy of these.")
 set(SP2_OPTIMIZE_LIBS ON CACHE BOOL "Optimize extlibs and seriousproton2 library")
+set(SP2_NULL_OPENGL OFF CACHE BOOL "Replace OpenGL with a recording stub, to run and benchmark rendering without a GPU.")
 
 if(NOT SP2_RESOURCE_PATHS)
     # Default resource path, main cmake file can customize this to include one or more paths.
@@ -136,6 +137,9 @@ else()
     add_library(seriousproton2 OBJECT ${SP2_SOURCES})
 endif()
 target_compile_options(seriousproton2 PUBLIC ${WARNING_FLAGS})
+if(SP2_NULL_OPENGL)
+    target_compile_definitions(seriousproton2 PUBLIC SP2_NULL_OPENGL)
+endif()
 target_link_libraries(seriousproton2 PUBLIC box2d bullet lua nlohmann_json::nlohmann_json miniz sp2freetype)
 target_include_directories(seriousproton2 PUBLIC "${SERIOUS_PROTON2_BASE_DIR}/include" "${SERIOUS_PROTON2_BASE_DIR}/extlibs/bullet")
 target_link_libraries(seriousproton2 PUBLIC ${SDL2_LIBRARIES})
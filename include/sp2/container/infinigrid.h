@@ -66,6 +66,26 @@ public:
         T data[chunk_size][chunk_size];
     };
 
+    static Vector2i chunkPosition(Vector2i position)
+    {
+        return {position.x >> CHUNK_SIZE_SHIFT, position.y >> CHUNK_SIZE_SHIFT};
+    }
+
+    //Returns nullptr when nothing was set in this chunk. Data is indexed as [x][y] within the chunk.
+    const Chunk* getChunk(Vector2i chunk_position)
+    {
+        auto it = chunks.find(chunk_position);
+        if (it == chunks.end())
+            return nullptr;
+        return &it->second;
+    }
+
+    template<typename F> void forEachChunk(F&& callback)
+    {
+        for(auto& it : chunks)
+            callback(it.first, it.second);
+    }
+
     class Iterator {
     public:
         bool operator!=(const Iterator& other) { return chunk_it != other.chunk_it; }
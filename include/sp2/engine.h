@@ -36,6 +36,11 @@ public:
     bool getPause();
     void shutdown();
 
+    // When enabled, scenes marked as independent are updated at the same time on the job system.
+    // See sp::Scene::setIndependentUpdate
+    void setParallelSceneUpdate(bool enabled) { parallel_scene_update = enabled; }
+    bool getParallelSceneUpdate() { return parallel_scene_update; }
+
     // Check if we are currently calling onUpdateFixed.
     bool isInFixedUpdate() { return in_fixed_update; }
 
@@ -58,6 +63,7 @@ private:
 
     float game_speed;
     bool paused;
+    bool parallel_scene_update = false;
 
     bool in_fixed_update;
     float update_delta;
@@ -0,0 +1,72 @@
+#ifndef SP2_GRAPHICS_GL_STATE_H
+#define SP2_GRAPHICS_GL_STATE_H
+
+namespace sp {
+
+/** Cache in front of the OpenGL state changes that are done for every draw call.
+
+    Calls that would set the state to what it already is are skipped.
+    All engine code changes this state trough here, custom OpenGL code that changes this state directly needs to call \ref invalidate afterwards.
+    The render queue does this after every function it calls.
+ */
+class GLState
+{
+public:
+    class Statistics
+    {
+    public:
+        int issued = 0;
+        int elided = 0;
+    };
+
+    static void useProgram(unsigned int program);
+    static void activeTexture(int unit);
+    //Bind a texture on the active texture unit.
+    static void bindTexture(unsigned int target, unsigned int texture);
+    //Bind a vertex or index buffer.
+    static void bindBuffer(unsigned int target, unsigned int buffer);
+    static void blendFunc(unsigned int source, unsigned int destination);
+    static void depthMask(bool enabled);
+    static void enable(unsigned int capability);
+    static void disable(unsigned int capability);
+
+    //Forget a deleted texture, OpenGL unbinds it, and the handle can be reused for a new texture.
+    static void forgetTexture(unsigned int texture);
+    //Forget a deleted buffer, for the same reason.
+    static void forgetBuffer(unsigned int buffer);
+    //Forget all cached state, the next call for everything is send to OpenGL.
+    static void invalidate();
+
+    //Uniform uploads are counted here as well, as the shader skips uploading values that did not change.
+    static void countCall(bool issued) { if (issued) statistics.issued++; else statistics.elided++; }
+    //Counted since the start of the last frame rendered by a render queue.
+    static const Statistics& getStatistics() { return statistics; }
+    static void resetStatistics() { statistics = Statistics(); }
+private:
+    static constexpr int texture_unit_count = 8;
+    static constexpr int capability_count = 4;
+
+    static int findCapability(unsigned int capability);
+    static void setCapability(unsigned int capability, bool enabled);
+
+    static Statistics statistics;
+    static bool valid_program;
+    static unsigned int program;
+    static int active_texture_unit;
+    static bool valid_textures[texture_unit_count];
+    static unsigned int textures[texture_unit_count];
+    //Bound GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER.
+    static bool valid_buffers[2];
+    static unsigned int buffers[2];
+    static bool valid_blend;
+    static unsigned int blend_source;
+    static unsigned int blend_destination;
+    static bool valid_depth_mask;
+    static bool depth_mask;
+    //State of the capabilities that are toggled by the engine, -1 when unknown.
+    static int capabilities[capability_count];
+};
+
+}//namespace sp
+
+#endif//SP2_GRAPHICS_GL_STATE_H
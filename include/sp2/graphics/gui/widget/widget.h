@@ -102,7 +102,7 @@ public:
         position = sp::Vector2d(getLocalTransform().inverse() * sp::Vector2f(position));
         if (position.x >= 0 && position.x <= render_size.x && position.y >= 0 && position.y <= render_size.y)
         {
-            for(PList<Node>::ReverseIterator it = getChildren().rbegin(); it != getChildren().rend(); ++it)
+            for(PVector<Node>::ReverseIterator it = getChildren().rbegin(); it != getChildren().rend(); ++it)
             {
                 P<Widget> w = P<Node>(*it);
                 if (w && w->isVisible())
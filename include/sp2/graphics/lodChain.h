@@ -0,0 +1,56 @@
+#ifndef SP2_GRAPHICS_LODCHAIN_H
+#define SP2_GRAPHICS_LODCHAIN_H
+
+#include <sp2/graphics/meshdata.h>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace sp {
+
+/** Versions of a mesh with decreasing detail, for RenderData::lod.
+    Level 0 is the full detail mesh, which should also be set as the mesh of the RenderData, as culling and static merging use that mesh.
+    The render pass switches to a lower level when the projected size of the object drops below the threshold of that level.
+    The projected size is the diameter of the bounding sphere as part of the view height, so 1.0 fills the view vertically.
+ */
+class LodChain : NonCopyable
+{
+public:
+    LodChain(std::shared_ptr<MeshData> mesh);
+
+    //Add the next level, used below the given projected size. Thresholds need to decrease with every level.
+    void addLevel(std::shared_ptr<MeshData> mesh, float max_screen_size);
+    int getLevelCount() const { return int(levels.size()); }
+    const std::shared_ptr<MeshData>& getMesh(int level) const { return levels[level].mesh; }
+
+    //Projected sizes need to be this fraction past a threshold before switching level, so objects at the threshold do not keep switching.
+    void setHysteresis(float fraction) { hysteresis = fraction; }
+    int selectLevel(float screen_size, int current_level) const;
+
+    //Generate the lower levels by simplifying the mesh, every level with reduction times the triangles of the previous level.
+    //The first lower level is used below first_threshold, every next level below half the threshold of the previous one.
+    static std::shared_ptr<LodChain> generate(std::shared_ptr<MeshData> mesh, int level_count=4, float reduction=0.5f, float first_threshold=0.25f);
+    //Generate (and cache) a chain for an .obj or .glb resource.
+    static std::shared_ptr<LodChain> get(const string& resource_name);
+private:
+    class Level
+    {
+    public:
+        std::shared_ptr<MeshData> mesh;
+        float max_screen_size;
+    };
+    std::vector<Level> levels;
+    float hysteresis = 0.1f;
+
+    static std::unordered_map<string, std::shared_ptr<LodChain>> cache;
+};
+
+/** Reduce the triangle count of a mesh with quadric error metric edge collapses.
+    Vertices at the same position are treated as one, so uv and normal seams stay closed, and open borders are kept in place.
+    The result keeps the type and layout of the source mesh. Simplification stops earlier when no edge can collapse without flipping triangles.
+ */
+std::shared_ptr<MeshData> simplifyMesh(MeshData& mesh, int target_triangle_count);
+
+}//namespace sp
+
+#endif//SP2_GRAPHICS_LODCHAIN_H
@@ -11,7 +11,7 @@ public:
     void addQuad(Vector3f p0, Vector3f p1, Vector3f p2, Vector3f p3);
     void addQuad(Vector3f p0, Vector3f p1, Vector3f p2, Vector3f p3, Vector3f normal);
 
-    std::shared_ptr<MeshData> create();
+    std::shared_ptr<MeshData> create(MeshData::Layout layout=MeshData::Layout::Full);
 private:
     MeshData::Vertices vertices;
     MeshData::Indices indices;
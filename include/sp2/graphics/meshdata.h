@@ -5,6 +5,7 @@
 #include <sp2/math/vector.h>
 #include <sp2/string.h>
 #include <memory>
+#include <atomic>
 
 namespace sp {
 
@@ -14,7 +15,8 @@ public:
     enum class Type
     {
         Static,
-        Dynamic
+        Dynamic,    //Updated now and then, updates of a small part of the vertices only upload the changed range.
+        Stream      //Replaced every frame, uploads rotate over multiple buffers so they do not wait for the GPU to finish drawing the previous frame.
     };
     class Vertex
     {
@@ -41,35 +43,153 @@ public:
         Vector3f position;
         Vector3f normal;
         Vector2f uv;
+        //Atlas tile as tile x, tile y, tile count x and tile count y, for shaders that repeat a tile over a quad with the uv.
+        uint8_t tile[4] = {0, 0, 0, 0};
     };
     typedef std::vector<Vertex> Vertices;
-    typedef std::vector<uint16_t> Indices;
+    //Meshes with up to 65536 vertices are drawn with 16 bit indices. Larger meshes use 32 bit indices when OpenGL supports them,
+    //and are split into multiple draws of at most 65536 vertices when it does not.
+    typedef std::vector<uint32_t> Indices;
 
-    MeshData(Vertices&& vertices, Indices&& indices, Type type=Type::Static);
+    //Format the vertices are uploaded to the GPU in. The mesh always keeps the float vertices on the CPU side.
+    //Attributes that are not in the layout are read as zero by the shader.
+    enum class Layout
+    {
+        Full,               //36 bytes: the vertex as is, float position, normal and uv, and the tile.
+        Position,           //12 bytes: float position only.
+        Position2DUV,       //16 bytes: float x and y position and uv, for flat unlit meshes like gui elements.
+        Position2DUVColor,  //20 bytes: Position2DUV, and the normal packed as an 8 bit per channel color, clamped to 0-1. For text, which colors glyphs with the normal.
+        PackedNormal,       //24 bytes: float position and uv, and the normal packed as normalized 8 bit integers.
+        PackedNormalUV,     //20 bytes: PackedNormal, with the uv packed as normalized 16 bit integers, for uvs that are between 0 and 1.
+        PackedNormalTile,   //28 bytes: PackedNormal and the tile.
+    };
+    //Description of where each vertex attribute is stored for a layout, used for packing the vertices and pointing the shader attributes at them.
+    class VertexLayout
+    {
+    public:
+        enum class Attribute
+        {
+            Position,
+            Normal,
+            UV,
+            Tile
+        };
+        class Element
+        {
+        public:
+            Attribute attribute;
+            int components;
+            unsigned int gl_type;
+            bool normalized;
+            int offset;
+        };
+
+        int stride;
+        std::vector<Element> elements;
+
+        void pack(const Vertex& vertex, uint8_t* target) const;
+        Vertex unpack(const uint8_t* source) const;
+
+        static const VertexLayout& get(Layout layout);
+    };
+
+    MeshData(Vertices&& vertices, Indices&& indices, Type type=Type::Static, Layout layout=Layout::Full);
     ~MeshData();
     
     void render();
+    //Replace the mesh. When the indices and vertex count stay the same, only the range of changed vertices is uploaded again.
     void update(Vertices&& vertices, Indices&& indices);
+    //Replace the vertices starting at the given index, without changing the vertex count or indices.
+    void updateVertices(size_t first, const Vertices& new_vertices);
 
     int getRevision() { return revision; }
+    Type getType() const { return type; }
+    Layout getLayout() const { return layout; }
+    //Unique number for this mesh, used to group render items with the same mesh.
+    unsigned int getId() const { return id; }
     const Vertices& getVertices() { return vertices; }
     const Indices& getIndices() { return indices; }
+
+    //Bounds of all vertex positions, calculated when the mesh is created or updated. The radius is negative for an empty mesh.
+    const Vector3f& getBoundsMin() const { return bounds_min; }
+    const Vector3f& getBoundsMax() const { return bounds_max; }
+    const Vector3f& getBoundingSphereCenter() const { return bounds_center; }
+    float getBoundingSphereRadius() const { return bounds_radius; }
     
-    static std::shared_ptr<MeshData> create(Vertices&& vertices, Indices&& indices, Type type=Type::Static);
+    static std::shared_ptr<MeshData> create(Vertices&& vertices, Indices&& indices, Type type=Type::Static, Layout layout=Layout::Full);
     static std::shared_ptr<MeshData> createQuad(Vector2f size, Vector2f uv0=Vector2f(0, 0), Vector2f uv1=Vector2f(1, 1));
     static std::shared_ptr<MeshData> createDoubleSidedQuad(Vector2f size, Vector2f uv0=Vector2f(0, 0), Vector2f uv1=Vector2f(1, 1));
     static std::shared_ptr<MeshData> createCircle(float radius, int point_count, bool double_sided=false);
+
+    //Point the attributes of the bound shader at the bound vertex buffer, which has to contain vertices in the given layout starting at the given byte offset.
+    static void setVertexAttributes(Layout layout=Layout::Full, size_t offset=0);
+    //Number of draw calls render() uses, more than 1 when the mesh needs to be split because 32 bit indices are not supported.
+    int getDrawCount() const { return parts.empty() ? 1 : int(parts.size()); }
+
+    class UploadStats
+    {
+    public:
+        int64_t bytes = 0;          //Bytes of vertex and index data sent to the GPU
+        int full_uploads = 0;       //Uploads of the whole mesh
+        int partial_uploads = 0;    //Uploads of only a changed range of vertices
+    };
+    //Totals over the lifetime of the mesh.
+    const UploadStats& getUploadStats() const { return upload_stats; }
 private:
     Vertices vertices;
     Indices indices;
-    unsigned int vertices_vbo;
-    unsigned int indices_vbo;
 
+    class Buffers
+    {
+    public:
+        unsigned int vertices_vbo;
+        unsigned int indices_vbo;
+        //Allocated size in bytes, kept when new data fits in it, so the buffer can be orphaned instead of reallocated.
+        size_t vertices_size;
+        size_t indices_size;
+    };
+    static constexpr int stream_buffer_count = 3;
+    //Only Stream meshes use more than the first entry.
+    Buffers buffers[stream_buffer_count];
+    int buffer_index;
+    unsigned int index_type;
+
+    //Ranges of the uploaded buffers that are drawn separately, when the mesh was split. Empty otherwise.
+    class Part
+    {
+    public:
+        int vertex_offset;
+        int index_offset;
+        int index_count;
+    };
+    std::vector<Part> parts;
+
+    //Set when everything needs to be uploaded again. Otherwise only the vertices from dirty_begin to dirty_end are uploaded.
     bool dirty;
+    size_t dirty_begin;
+    size_t dirty_end;
     int revision;
     Type type;
+    Layout layout;
+    unsigned int id;
+
+    Vector3f bounds_min;
+    Vector3f bounds_max;
+    Vector3f bounds_center;
+    float bounds_radius;
+    UploadStats upload_stats;
+
+    MeshData(Type type, Layout layout);
+    void updateBounds();
+    void upload(Buffers& buffer);
+    void uploadRange(Buffers& buffer);
+    void markDirtyRange(size_t first, size_t last);
+    void uploadBuffer(unsigned int target, size_t& allocated_size, size_t size, const void* data);
+    //Vertices in the upload layout, either the given vertices or a shared buffer with the packed vertices.
+    const void* packVertices(const Vertex* source, size_t count);
 
-    MeshData(Type type);
+    //Meshes can be build on worker threads, so the id counter needs to be atomic.
+    static std::atomic<unsigned int> next_id;
 };
 
 }//namespace sp
@@ -0,0 +1,75 @@
+#ifndef SP2_GRAPHICS_NULL_OPENGL_H
+#define SP2_GRAPHICS_NULL_OPENGL_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace sp {
+
+/** Recording stand-in for OpenGL, to run and benchmark the render code without a GPU.
+
+    When build with SP2_NULL_OPENGL, \ref sp::initOpenGL installs this instead of the real OpenGL functions,
+    and the Window does not create an OpenGL context. Tests can call \ref install directly.
+
+    Objects get fake ids, status queries report success, and every call is counted.
+    Calls are only kept in the command stream when recording is enabled, as that grows every frame.
+ */
+class NullOpenGL
+{
+public:
+    enum class Category
+    {
+        Draw,
+        State,
+        Uniform,
+        Buffer,
+        Texture,
+        Other
+    };
+
+    class Statistics
+    {
+    public:
+        int calls = 0;
+        int draw_calls = 0;
+        int64_t vertices = 0;
+        int state_changes = 0;
+        int uniform_uploads = 0;
+        int buffer_uploads = 0;
+        int64_t buffer_bytes = 0;
+        int texture_uploads = 0;
+        int64_t texture_bytes = 0;
+    };
+
+    class Command
+    {
+    public:
+        const char* function;
+        Category category;
+        //The first integer arguments of the call, floats and pointers are not recorded.
+        int64_t arguments[4];
+    };
+
+    static void install();
+    static bool isInstalled() { return installed; }
+
+    static const Statistics& getStatistics() { return statistics; }
+    static void resetStatistics() { statistics = Statistics(); }
+
+    static void setRecording(bool enabled) { recording = enabled; }
+    static const std::vector<Command>& getCommands() { return commands; }
+    static void clearCommands() { commands.clear(); }
+    //Number of recorded calls to a function, for example "glDrawElements".
+    static int countCommands(const char* function);
+private:
+    static bool installed;
+    static bool recording;
+    static Statistics statistics;
+    static std::vector<Command> commands;
+
+    friend class NullOpenGLRecorder;
+};
+
+}//namespace sp
+
+#endif//SP2_GRAPHICS_NULL_OPENGL_H
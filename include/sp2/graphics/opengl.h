@@ -12,6 +12,10 @@
 
 namespace sp {
 void initOpenGL();
+
+//Set by initOpenGL when glDrawElements accepts GL_UNSIGNED_INT indices.
+//Desktop OpenGL always does, OpenGL ES 2 needs the GL_OES_element_index_uint extension.
+extern bool opengl_element_index_uint;
 }//namespace sp
 
 
@@ -4,8 +4,11 @@
 #include <sp2/graphics/scene/renderpass.h>
 #include <sp2/graphics/scene/renderqueue.h>
 #include <sp2/math/ray.h>
+#include <sp2/math/frustum.h>
 #include <sp2/pointerList.h>
+#include <sp2/threading/jobSystem.h>
 #include <list>
+#include <memory>
 
 namespace sp {
 class Scene;
@@ -29,11 +32,39 @@ public:
     virtual void onTextInput(TextInputEvent e) override;
     
     void addCamera(P<Camera> camera);
+
+    class CullingStats
+    {
+    public:
+        int visible = 0;            //Nodes with a mesh that were passed to addNodeToRenderQueue
+        int culled = 0;             //Nodes with a mesh that were outside of the view
+        int culled_subtrees = 0;    //Nodes with children that were skipped together with all their children, without visiting them
+        int triangles = 0;          //Triangles of the visible meshes, after selecting the level of detail
+    };
+    //Nodes outside of the view of the camera are not added to the render queue, based on the bounds of their mesh.
+    //Disable this when addNodeToRenderQueue is overridden to render nodes in a way that does not match their mesh.
+    void setCulling(bool enabled) { culling = enabled; }
+    //Statistics of the last call to render(), where every merged mesh of a static subtree counts as a single node.
+    const CullingStats& getCullingStats() const { return culling_stats; }
+    //Split the node tree into parts that are culled and added to worker queues of the render queue on the job system.
+    //The parts are merged in tree order, so the result is exactly the same as rendering from a single thread.
+    //addNodeToRenderQueue is called from worker threads then, so overrides should only use the node and queue they are given.
+    void setThreaded(bool enabled) { threaded = enabled; }
 protected:
+    //Of static subtrees (see Node::setRenderStatic) only the nodes that could not be merged are passed to this function.
     virtual void addNodeToRenderQueue(RenderQueue& queue, P<Node>& node);
 
     PList<Camera> cameras;
 private:
+    bool culling = true;
+    bool threaded = false;
+    CullingStats culling_stats;
+    Frustumf frustum;
+    //Projection and camera transform of the scene being rendered, for the projected size of nodes with a lod chain.
+    Matrix4x4f view_projection;
+    float lod_scale;
+    Camera* lod_camera;
+
     std::map<int, P<Scene>> pointer_scene;
     std::map<int, P<Camera>> pointer_camera;
     P<Scene> focus_scene;
@@ -41,8 +72,29 @@ private:
     bool privateOnPointerMove(P<Scene> scene, P<Camera> camera, Vector2d position, int id);
     bool privateOnPointerDown(P<Scene> scene, P<Camera> camera, io::Pointer::Button button, Vector2d position, int id);
     bool privateOnWheelMove(P<Scene> scene, P<Camera> camera, Vector2d position, io::Pointer::Wheel direction);
+    //Part of the node tree for threaded rendering, either nodes added by the main thread, or a list of subtrees for a job.
+    class Segment
+    {
+    public:
+        bool job;
+        bool inside_view;
+        std::vector<Node*> nodes;
+        CullingStats stats;
+    };
+    //Segments are kept between frames, only the first segment_count are used in the current frame.
+    std::vector<std::unique_ptr<Segment>> segments;
+    size_t segment_count = 0;
+    std::vector<threading::JobSystem::Handle> jobs;
+
     void renderScene(RenderQueue& queue, P<Scene> scene, P<Camera> camera);
-    void recursiveNodeRender(RenderQueue& queue, P<Node> node);
+    //Cull and add the node itself. Returns false when its children do not need to be visited.
+    bool renderNode(RenderQueue& queue, Node* node, bool& inside_view, CullingStats& stats);
+    void recursiveNodeRender(RenderQueue& queue, Node* node, bool inside_view, CullingStats& stats);
+    void renderStaticNode(RenderQueue& queue, P<Node> node, bool inside_view, CullingStats& stats);
+    void threadedNodeRender(RenderQueue& queue, P<Node> root);
+    void splitNodeRender(RenderQueue& queue, P<Node> node, bool inside_view, int depth, int job_target);
+    Segment& addSegment(bool job, bool inside_view);
+    void selectLod(RenderData& data, const Matrix4x4f& transform);
 };
 
 }//namespace sp
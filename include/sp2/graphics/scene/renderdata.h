@@ -11,6 +11,8 @@
 namespace sp {
 
 class MeshData;
+class LodChain;
+class Camera;
 class RenderData
 {
 public:
@@ -36,10 +38,30 @@ public:
     Color color;
     Texture* texture;
     Vector3f scale;
+    //Optional lower detail versions of the mesh, selected by the render pass based on the projected size.
+    std::shared_ptr<LodChain> lod;
+    //Level of the lod chain selected for the camera that is currently rendering.
+    int lod_level;
+    //Level selected per camera, kept between frames so levels only switch after passing the hysteresis margin.
+    //Every camera has its own, so cameras at different distances do not push each other past the margin.
+    class LodCameraLevel
+    {
+    public:
+        const Camera* camera;
+        int level;
+    };
+    std::vector<LodCameraLevel> lod_camera_levels;
+    //Select the level for the given camera and make it the current lod_level, starting from the level the camera selected before.
+    void selectLodLevel(const Camera* camera, float screen_size);
     
     RenderData();
     
+    //The mesh that is rendered: the mesh of the selected lod level, or the mesh itself.
+    const std::shared_ptr<MeshData>& getLodMesh() const;
+    
     bool operator<(const RenderData& data) const;
+    //Bounding sphere of the mesh with the scale applied, in object space. The radius is negative without a mesh.
+    void getBoundingSphere(Vector3f& center, float& radius) const;
 };
 
 }//namespace sp
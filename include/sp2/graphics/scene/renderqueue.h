@@ -2,10 +2,14 @@
 #define SP2_GRAPHICS_SCENE_RENDERQUEUE_H
 
 #include <sp2/graphics/scene/renderdata.h>
+#include <sp2/graphics/meshdata.h>
 #include <sp2/math/matrix4x4.h>
 #include <sp2/pointer.h>
+#include <sp2/linearArena.h>
 #include <vector>
-#include <functional>
+#include <cstdint>
+#include <memory>
+#include <utility>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
@@ -23,11 +27,40 @@ public:
     void setAspectRatio(float aspect_ratio);
     void setCamera(P<Camera> camera);
     void setCamera(const Matrix4x4f& camera_projection, const Matrix4x4f& camera_transform);
-    void add(std::function<void()> function);
-    void add(const Matrix4x4f& transform, const RenderData& data);
-    void add(const Matrix4x4f& transform, const RenderData& data, std::function<void()> function);
+    //Functions are stored in the frame arena of the queue, so any callable can be added without allocating memory.
+    template<typename F> void add(F&& function)
+    {
+        bindFunction(addFunctionCall(), std::forward<F>(function));
+    }
+    void add(const Matrix4x4f& transform, const RenderData& data)
+    {
+        addRenderItem(transform, data);
+    }
+    template<typename F> void add(const Matrix4x4f& transform, const RenderData& data, F&& function)
+    {
+        Item* item = addRenderItem(transform, data);
+        if (item)
+            bindFunction(item, std::forward<F>(function));
+    }
+    /** Consecutive items with the same shader, texture, color and type are merged into a single draw call,
+        when their meshes are static and have at most max_item_vertices vertices, and they are scaled the same along every axis.
+        The vertices of merged items are transformed on the CPU and streamed into a buffer of at most max_batch_vertices vertices.
+        Setting max_item_vertices to 0 disables batching. Changes apply to items added after this call.
+     */
+    void setBatching(int max_item_vertices, int max_batch_vertices);
     void render();
+
+    /** Queue to fill from another thread, for building a frame in parallel. Worker queues are kept and reused every frame.
+        They use the camera and batching settings this queue has when the worker queue is requested, so request them after setCamera.
+        Items of a worker queue show up after passing it to merge, which sorts them the same as when they were added to this queue directly.
+        Requesting and merging worker queues is done from the thread that owns this queue.
+     */
+    RenderQueue& getWorkerQueue(int index);
+    void merge(RenderQueue& worker_queue);
 private:
+    explicit RenderQueue(RenderQueue* parent);
+
+    //Plain draw record, allocated in the frame arena. The mesh is kept alive by the pinned meshes of the frame.
     class Item
     {
     public:
@@ -38,48 +71,78 @@ private:
             RenderItem,
             FunctionCall,
         };
-    
-        Item(Type type, const Matrix4x4f& transform)
-        : type(type), transform(transform)
-        {
-        }
-
-        Item(const Matrix4x4f& transform, const RenderData& data)
-        : type(Type::RenderItem), transform(transform), data(data)
-        {
-        }
-
-        Item(const Matrix4x4f& transform, const RenderData& data, std::function<void()> function)
-        : type(Type::RenderItem), transform(transform), data(data), function(function)
-        {
-        }
-
-        Item(std::function<void()> function)
-        : type(Type::FunctionCall), function(function)
-        {
-        }
-
-        bool operator<(const Item& other) const
-        {
-            return data < other.data;
-        }
 
         Type type;
+        RenderData::Type render_type;
         Matrix4x4f transform;
-        RenderData data;
-        std::function<void()> function;
+        Shader* shader;
+        MeshData* mesh;
+        Texture* texture;
+        Color color;
+        Vector3f scale;
+        void (*function)(void*);
+        void* function_data;
+        //Maximum vertex count of a batch starting with this item, 0 when the item cannot be batched.
+        int batch_limit;
     };
 
-    void render(std::vector<Item>& list);
+    //Items are never moved after they are added, only these small entries that point to them are sorted.
+    class SortEntry
+    {
+    public:
+        uint64_t key;
+        Item* item;
+    };
+
+    //Sort key with the order in the highest bits, followed by the type, and then the state changes and depth.
+    uint64_t buildSortKey(const Matrix4x4f& transform, const RenderData& data);
+    void sortItems();
+    Item* addItem(Item::Type type);
+    Item* addFunctionCall();
+    Item* addRenderItem(const Matrix4x4f& transform, const RenderData& data);
+    void pinMesh(const std::shared_ptr<MeshData>& mesh);
+    void callFunction(Item& item, bool& depth_write_disabled);
+    size_t findBatchEnd(const std::vector<SortEntry>& sort_list, size_t start);
+    void renderBatch(const std::vector<SortEntry>& sort_list, size_t start, size_t end);
+    void render(std::vector<SortEntry>& sort_list, LinearArena& arena, std::vector<std::shared_ptr<MeshData>>& pinned_meshes, std::vector<std::unique_ptr<LinearArena>>& merged_arenas);
+
+    template<typename F> void bindFunction(Item* item, F&& function)
+    {
+        typedef typename std::decay<F>::type Function;
+        item->function_data = arena.create<Function>(std::forward<F>(function));
+        item->function = [](void* function) { (*static_cast<Function*>(function))(); };
+    }
 
     Matrix4x4f camera_projection;
     Matrix4x4f camera_transform;
-    std::vector<Item> render_list;
+    //Camera transform as given to setCamera, used to calculate the depth part of the sort key while adding items.
+    Matrix4x4f submit_camera_transform;
+    LinearArena arena;
+    std::vector<SortEntry> sort_list;
+    std::vector<SortEntry> sort_buffer;
     int render_list_sort_start;
+    //Meshes used this frame, so they stay alive until rendered. Small cache so meshes used many times are only pinned once.
+    std::vector<std::shared_ptr<MeshData>> pinned_meshes;
+    static constexpr int pin_cache_size = 256;
+    MeshData* pin_cache[pin_cache_size];
     
     float target_aspect_ratio;
     float aspect_ratio;
 
+    std::vector<std::unique_ptr<RenderQueue>> worker_queues;
+    //Set for worker queues, which never render and leave sorting to the queue they are merged into.
+    bool worker;
+    //Positions of function calls in the sort list of a worker queue, the items before them are sorted when merging.
+    std::vector<size_t> sort_barriers;
+    //Arenas taken over from merged worker queues, as the items in them need to stay alive until this queue has rendered them.
+    std::vector<std::unique_ptr<LinearArena>> merged_arenas;
+    size_t merged_arena_count;
+
+    int batch_max_item_vertices;
+    int batch_max_vertices;
+    //Stream mesh that the merged vertices of every batch are uploaded to. Only used by the thread that renders.
+    std::shared_ptr<MeshData> batch_mesh;
+
 #ifdef SP2_USE_RENDER_THREAD
     void renderThread();
 
@@ -87,7 +150,10 @@ private:
     std::mutex render_mutex;
     std::condition_variable render_trigger;
     bool render_data_ready;
-    std::vector<Item> ready_render_list;
+    LinearArena ready_arena;
+    std::vector<SortEntry> ready_sort_list;
+    std::vector<std::shared_ptr<MeshData>> ready_pinned_meshes;
+    std::vector<std::unique_ptr<LinearArena>> ready_merged_arenas;
 #endif
 };
 
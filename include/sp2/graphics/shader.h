@@ -6,6 +6,8 @@
 #include <sp2/math/matrix4x4.h>
 #include <sp2/graphics/color.h>
 #include <sp2/nonCopyable.h>
+#include <vector>
+#include <map>
 
 namespace sp {
 
@@ -14,27 +16,65 @@ class Texture;
 class Shader : public NonCopyable
 {
 public:    
+    //Uniform name resolved to a small number once, so setting the uniform does not need to lookup the name every time.
+    class Uniform
+    {
+    public:
+        explicit Uniform(const string& name);
+
+        int id;
+    };
+
     bool bind();
-    void setUniform(const string& s, const Matrix4x4f& matrix);
-    void setUniform(const string& s, const Vector2f& v);
-    void setUniform(const string& s, const Vector3f& v);
-    void setUniform(const string& s, const Color& v);
-    void setUniform(const string& s, float v);
-    void setUniform(const string& s, Texture* v, int texture_index=0);
+    //These lookup the name on every call, keep a Uniform for uniforms that are set every frame.
+    void setUniform(const string& s, const Matrix4x4f& matrix) { setUniform(Uniform(s), matrix); }
+    void setUniform(const string& s, const Vector2f& v) { setUniform(Uniform(s), v); }
+    void setUniform(const string& s, const Vector3f& v) { setUniform(Uniform(s), v); }
+    void setUniform(const string& s, const Color& v) { setUniform(Uniform(s), v); }
+    void setUniform(const string& s, float v) { setUniform(Uniform(s), v); }
+    void setUniform(const string& s, Texture* v, int texture_index=0) { setUniform(Uniform(s), v, texture_index); }
 
+    //Values are remembered per shader, setting a uniform to the value it already has is skipped.
+    void setUniform(Uniform uniform, const Matrix4x4f& matrix);
+    void setUniform(Uniform uniform, const Vector2f& v);
+    void setUniform(Uniform uniform, const Vector3f& v);
+    void setUniform(Uniform uniform, const Color& v);
+    void setUniform(Uniform uniform, float v);
+    void setUniform(Uniform uniform, Texture* v, int texture_index=0);
+
+    //Unique number for this shader, used to group render items with the same shader.
+    unsigned int getId() const { return id; }
+    //Render items with this shader can be merged by the render queue, with their transforms applied on the CPU.
+    //Only shader files with a [BATCHING] line allow this, they must use object_scale and object_matrix only to transform positions and normals.
+    bool allowsBatching() const { return batching; }
 private:
     Shader(const string& name);
     Shader(const string& name, string&& vertex_shader, string&& fragment_shader);
     ~Shader();
     
+    class UniformState
+    {
+    public:
+        //-2 when the location was not requested yet, -1 when the shader does not have this uniform.
+        int location = -2;
+        int size = 0;
+        float value[16];
+    };
+
     unsigned int compileShader(const char* code, int type);
-    int getUniformLocation(const string& s);
+    //Returns nullptr when the uniform does not exist, or the value is the same as the last upload.
+    UniformState* updateUniform(Uniform uniform, const float* value, int size);
 
     unsigned int program;
+    unsigned int id;
     int vertex_attribute = -1;
     int normal_attribute = -1;
     int uv_attribute = -1;
-    std::map<string, int> uniform_mapping;
+    int tile_attribute = -1;
+    //Bitmask of the attribute arrays that are enabled (vertex, normal, uv, tile), MeshData disables the ones a vertex layout does not have.
+    int enabled_attributes = 0;
+    bool batching = false;
+    std::vector<UniformState> uniforms;
 
     string name;
     string vertex_shader;
@@ -46,6 +86,7 @@ public:
 private:
     static std::map<string, Shader*> cached_shaders;
     static Shader* bound_shader;
+    static unsigned int next_id;
     
     friend class MeshData;
 };
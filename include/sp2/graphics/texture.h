@@ -6,6 +6,7 @@
 #include <sp2/graphics/image.h>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 
 namespace sp {
@@ -21,16 +22,22 @@ public:
     virtual void bind() = 0;
     int getRevision() { return revision; }
     const string& getName() { return name; }
+    //Unique number for this texture, used to group render items with the same texture.
+    unsigned int getId() const { return id; }
 protected:
     Texture(Type type, const string& name)
-    : type(type), name(name), revision(0) {}
+    : type(type), name(name), revision(0), id(next_id++) {}
     virtual ~Texture() {}
 
     Type type;
     string name;
     int revision;
+    unsigned int id;
     bool smooth = false;
     bool repeat = false;
+
+private:
+    static std::atomic<unsigned int> next_id;
 };
 
 class OpenGLTexture : public Texture
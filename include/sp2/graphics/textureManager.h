@@ -18,6 +18,7 @@ public:
     
     //In case a texture is changed on disk, you can call this function to forcefully reload the texture.
     //Note that the loading still happens in the background, and the old texture will be shown till load is done.
+    //Refreshing a texture that is still loading reloads it once after the running load, instead of loading it twice at the same time.
     void forceRefresh(const string& name);
 protected:
     virtual Texture* prepare(const string& name) override;
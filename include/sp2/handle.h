@@ -0,0 +1,172 @@
+#ifndef SP2_HANDLE_H
+#define SP2_HANDLE_H
+
+#include <sp2/pointer.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace sp {
+
+class _HandleTable
+{
+public:
+    class Slot
+    {
+    public:
+        //Written under the table lock, but read without it by handles.
+        std::atomic<AutoPointerObject*> object;
+        std::atomic<uint32_t> generation;
+        uint32_t next_free;
+    };
+
+    static constexpr uint32_t page_shift = 12;
+    static constexpr uint32_t page_size = 1 << page_shift;
+    static constexpr uint32_t page_count = 4096;
+
+    //Get the slot for an object, creating one if the object did not have a slot yet.
+    static uint32_t acquire(AutoPointerObject* object);
+    static void release(uint32_t index);
+
+    static const Slot& get(uint32_t index)
+    {
+        return pages[index >> page_shift][index & (page_size - 1)];
+    }
+private:
+    //Pages are never moved or freed, so reading a slot does not need any locking.
+    //A page is published by the release store of the handle_index that first uses it.
+    static Slot* pages[page_count];
+};
+
+/** Light weight weak reference to an AutoPointerObject.
+
+    A \ref sp::Handle<T> is an index and generation into a global slot table.
+    Copying a handle does not touch the object it points to, unlike \ref sp::P<T>,
+    which links itself into a list on the object for every copy.
+    Checking if the object still exists is a single compare with the generation in the slot table.
+
+    The object gets a slot the first time a handle to it is created. When the object is deleted,
+    the generation of the slot is increased, and all handles to it will return nullptr.
+
+    Handles convert to and from \ref sp::P<T>, so they can be used in any place where a temporary reference is stored.
+    Example:
+    \code
+    sp::Handle<sp::Node> handle = node;
+    if (handle)
+        handle->setPosition(...);
+    sp::P<sp::Node> p = handle;
+    \endcode
+ */
+template<class T> class Handle
+{
+public:
+    Handle()
+    : index(0), generation(0)
+    {
+    }
+
+    Handle(T* ptr)
+    {
+        set(ptr);
+    }
+
+    Handle(const P<T>& p)
+    {
+        set(*p);
+    }
+
+    Handle& operator=(T* ptr)
+    {
+        set(ptr);
+        return *this;
+    }
+
+    Handle& operator=(const P<T>& p)
+    {
+        set(*p);
+        return *this;
+    }
+
+    T* get() const
+    {
+        if (!index)
+            return nullptr;
+        const _HandleTable::Slot& slot = _HandleTable::get(index);
+        if (slot.generation.load(std::memory_order_acquire) != generation)
+            return nullptr;
+        return static_cast<T*>(slot.object.load(std::memory_order_relaxed));
+    }
+
+    T* operator->() const
+    {
+        return get();
+    }
+
+    T* operator*() const
+    {
+        return get();
+    }
+
+    explicit operator bool() const
+    {
+        return get() != nullptr;
+    }
+
+    operator P<T>() const
+    {
+        return get();
+    }
+
+    template<class T2> operator Handle<T2>() const
+    {
+        return dynamic_cast<T2*>(get());
+    }
+
+    //Delete the object this handle points to, if it still exists.
+    void destroy()
+    {
+        T* ptr = get();
+        if (ptr)
+            delete ptr;
+    }
+
+    bool operator==(const Handle<T>& other) const
+    {
+        return get() == other.get();
+    }
+
+    bool operator!=(const Handle<T>& other) const
+    {
+        return get() != other.get();
+    }
+
+    bool operator==(const T* other) const
+    {
+        return get() == other;
+    }
+
+    bool operator!=(const T* other) const
+    {
+        return get() != other;
+    }
+private:
+    uint32_t index;
+    uint32_t generation;
+
+    void set(T* ptr)
+    {
+        if (ptr)
+        {
+            index = _HandleTable::acquire(ptr);
+            generation = _HandleTable::get(index).generation.load(std::memory_order_acquire);
+        }
+        else
+        {
+            index = 0;
+            generation = 0;
+        }
+    }
+};
+
+}//namespace sp
+
+#endif//SP2_HANDLE_H
@@ -3,9 +3,9 @@
 
 #include <sp2/io/resourceProvider.h>
 #include <sp2/logging.h>
-#include <sp2/threading/queue.h>
-#include <thread>
+#include <sp2/threading/jobSystem.h>
 #include <unordered_map>
+#include <mutex>
 
 namespace sp {
 namespace io {
@@ -13,8 +13,6 @@ namespace io {
 class LazyLoaderManager
 {
 private:
-    static std::thread* thread;
-    static sp::threading::Queue<std::function<void()>> queue;
     static void addWork(std::function<void()> f);
     
     template<class T> friend class LazyLoader;
@@ -42,23 +40,51 @@ protected:
     {
         io::ResourceStreamPtr stream;
         stream = io::ResourceProvider::get(name);
-        if (stream)
+        if (!stream)
         {
-            LazyLoaderManager::addWork([this, ptr, stream]()
-            {
-                this->backgroundLoader(ptr, stream);
-            });
+            LOG(Warning, "Failed to load", name);
+            return;
         }
-        else
         {
-            LOG(Warning, "Failed to load", name);
+            std::lock_guard<std::mutex> lock(loading_mutex);
+            auto it = loading.find(name);
+            if (it != loading.end())
+            {
+                //Already loading, the running load picks up the newest stream when it is done, instead of starting a second load.
+                it->second = stream;
+                return;
+            }
+            loading[name] = nullptr;
         }
+        LazyLoaderManager::addWork([this, ptr, name, stream]()
+        {
+            io::ResourceStreamPtr next = stream;
+            while(next)
+            {
+                this->backgroundLoader(ptr, next);
+                std::lock_guard<std::mutex> lock(loading_mutex);
+                auto it = loading.find(name);
+                next = std::move(it->second);
+                if (!next)
+                    loading.erase(it);
+            }
+        });
+    }
+
+    //True while a load of the name is queued or running.
+    bool isLoading(const string& name)
+    {
+        std::lock_guard<std::mutex> lock(loading_mutex);
+        return loading.find(name) != loading.end();
     }
 
     virtual T prepare(const string& name) = 0;
     virtual void backgroundLoader(T ptr, io::ResourceStreamPtr stream) = 0;
 private:
     std::unordered_map<string, T> cached_items;
+    //Names with a load running, with the stream of a refresh that was requested while it runs.
+    std::mutex loading_mutex;
+    std::unordered_map<string, io::ResourceStreamPtr> loading;
 };
 
 }//namespace io
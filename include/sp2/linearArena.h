@@ -0,0 +1,72 @@
+#ifndef SP2_LINEAR_ARENA_H
+#define SP2_LINEAR_ARENA_H
+
+#include <sp2/nonCopyable.h>
+#include <vector>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+
+namespace sp {
+
+/** Bump allocator for short lived objects, such as everything that is build up during a single frame.
+
+    Allocations are taken from large blocks, and are all released together by \ref reset.
+    Blocks are kept after a reset, so once the arena has grown to the size needed for a frame, no more memory is allocated.
+    Objects made with \ref create have their destructor called on reset, in reverse order of creation.
+ */
+class LinearArena : NonCopyable
+{
+public:
+    LinearArena(size_t block_size=64 * 1024);
+    ~LinearArena();
+
+    void* allocate(size_t size, size_t alignment=alignof(std::max_align_t));
+
+    template<typename T, typename... ARGS> T* create(ARGS&&... args)
+    {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<ARGS>(args)...);
+        if (!std::is_trivially_destructible<T>::value)
+            addDestructor([](void* object) { static_cast<T*>(object)->~T(); }, object);
+        return object;
+    }
+
+    //Release all allocations, and destroy all objects made with create.
+    void reset();
+    void swap(LinearArena& other);
+
+    size_t getBlockCount() const { return blocks.size(); }
+    //Number of blocks allocated from the heap by all arenas together, to check that frames stop allocating once the arenas have grown.
+    static size_t getHeapAllocationCount() { return heap_allocation_count; }
+private:
+    class Destructor
+    {
+    public:
+        void (*function)(void*);
+        void* object;
+        Destructor* next;
+    };
+    class Block
+    {
+    public:
+        char* data;
+        size_t size;
+    };
+
+    void addDestructor(void (*function)(void*), void* object);
+    void nextBlock(size_t minimal_size);
+
+    size_t block_size;
+    std::vector<Block> blocks;
+    size_t block_index;
+    size_t block_used;
+    Destructor* destructors;
+
+    static std::atomic<size_t> heap_allocation_count;
+};
+
+}//namespace sp
+
+#endif//SP2_LINEAR_ARENA_H
@@ -0,0 +1,65 @@
+#ifndef SP2_MATH_FRUSTUM_H
+#define SP2_MATH_FRUSTUM_H
+
+#include <sp2/math/plane.h>
+#include <sp2/math/matrix4x4.h>
+
+namespace sp {
+
+/** View volume of a camera, as 6 planes facing inwards.
+    Build from projection * camera_transform, where camera_transform is the inverse of the camera its global transform.
+ */
+template<typename T> class Frustum
+{
+public:
+    enum class Result
+    {
+        Outside,
+        Intersect,
+        Inside
+    };
+
+    Frustum() {}
+    Frustum(const Matrix4x4<T>& m)
+    {
+        //Gribb/Hartmann plane extraction, every plane is the 4th row plus or minus one of the other rows of the matrix.
+        for(int n=0; n<3; n++)
+        {
+            setPlane(n * 2, m.data[3] + m.data[n], m.data[7] + m.data[n + 4], m.data[11] + m.data[n + 8], m.data[15] + m.data[n + 12]);
+            setPlane(n * 2 + 1, m.data[3] - m.data[n], m.data[7] - m.data[n + 4], m.data[11] - m.data[n + 8], m.data[15] - m.data[n + 12]);
+        }
+    }
+
+    Result test(const Vector3<T>& center, T radius) const
+    {
+        Result result = Result::Inside;
+        for(const auto& plane : planes)
+        {
+            T distance = plane.normal.dot(center) - plane.distance;
+            if (distance < -radius)
+                return Result::Outside;
+            if (distance < radius)
+                result = Result::Intersect;
+        }
+        return result;
+    }
+
+    Plane3<T> planes[6];
+private:
+    void setPlane(int index, T a, T b, T c, T d)
+    {
+        Vector3<T> normal(a, b, c);
+        T length = normal.length();
+        if (length > 0.0)
+            planes[index] = Plane3<T>(normal / length, -d / length);
+        else
+            planes[index] = Plane3<T>(normal, -d);
+    }
+};
+
+typedef Frustum<float> Frustumf;
+typedef Frustum<double> Frustumd;
+
+}//namespace sp
+
+#endif//SP2_MATH_FRUSTUM_H
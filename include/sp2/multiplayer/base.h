@@ -2,8 +2,10 @@
 #define SP2_MULTIPLAYER_BASE_H
 
 #include <sp2/pointer.h>
+#include <sp2/handle.h>
 #include <stdint.h>
 #include <unordered_map>
+#include <mutex>
 
 namespace sp {
 class Node;
@@ -31,8 +33,9 @@ protected:
     void addNode(P<Node> node);    
     void cleanDeletedNodes();
     
-    std::unordered_map<uint64_t, P<Node>>::iterator nodeBegin();
-    std::unordered_map<uint64_t, P<Node>>::iterator nodeEnd();
+    //Iterating is not locked, only do this from onUpdate, which never runs at the same time as a parallel scene update.
+    std::unordered_map<uint64_t, Handle<Node>>::iterator nodeBegin();
+    std::unordered_map<uint64_t, Handle<Node>>::iterator nodeEnd();
     
     float network_delay = 0.0;
 private:
@@ -40,7 +43,9 @@ private:
     //Called when a node that was added is deleted now and removed from the registry.
     virtual void onDeleted(uint64_t id);
     
-    std::unordered_map<uint64_t, P<Node>> node_by_id;
+    //getNode can be called from scenes with independent update, while the registry is changed.
+    std::mutex node_by_id_mutex;
+    std::unordered_map<uint64_t, Handle<Node>> node_by_id;
 };
 
 }//namespace multiplayer
@@ -5,9 +5,13 @@
 #include <sp2/pointerBase.h>
 #include <ostream>
 #include <typeinfo>
+#include <atomic>
+#include <stdint.h>
 
 namespace sp {
 
+class _PVectorStorage;
+
 /** Base class for objects that can be used in \ref sp::P<T>
 
     Any AutoPointerObject that is deleted will set all the \ref sp::P<T> that point to this object to nullptr.
@@ -20,17 +24,27 @@ class AutoPointerObject : NonCopyable
 private:
     _PBase* pointer_list_start;
     _PListEntry* pointer_list_entry_list_start;
+    //First entry in the chain of sp::PVector<T> entries that point to this object.
+    _PVectorStorage* pointer_vector_storage;
+    uint32_t pointer_vector_index;
+    //Slot in the handle table, 0 when no sp::Handle<T> was ever made to this object.
+    std::atomic<uint32_t> handle_index;
 public:
     AutoPointerObject()
     {
         pointer_list_start = nullptr;
         pointer_list_entry_list_start = nullptr;
+        pointer_vector_storage = nullptr;
+        pointer_vector_index = 0;
+        handle_index = 0;
     }
     
     virtual ~AutoPointerObject();
     
     friend class _PBase;
     friend class _PListBase;
+    friend class _PVectorStorage;
+    friend class _HandleTable;
 };
 
 /** Smart pointer with reference clearing on deletion.
@@ -0,0 +1,287 @@
+#ifndef SP2_POINTER_VECTOR_H
+#define SP2_POINTER_VECTOR_H
+
+#include <sp2/pointer.h>
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+
+namespace sp {
+
+class _PVectorStorage : NonCopyable
+{
+public:
+    /* Every object keeps a chain of the vector entries that point to it, so deleting it can clear those entries.
+       The chain starts at the pointer_vector_storage and pointer_vector_index of the object, and continues with the next_storage and next_index of each entry.
+     */
+    class Entry
+    {
+    public:
+        AutoPointerObject* object;
+        _PVectorStorage* next_storage;
+        uint32_t next_index;
+    };
+
+    std::vector<Entry> items;
+    //Number of entries that are not a hole.
+    int count = 0;
+    //Number of iterators using this storage. As long as this is not zero, items can be added, but never moved.
+    int iterators = 0;
+    bool has_holes = false;
+    //Set when the owning container is destroyed while iterators still use the storage, the last iterator deletes it.
+    bool orphaned = false;
+
+    void compact();
+    void add(AutoPointerObject* item);
+    void remove(AutoPointerObject* item);
+    void clear();
+    //Sort the entries, with holes moved to the end.
+    void sort(const std::function<bool(AutoPointerObject* a, AutoPointerObject* b)>& less);
+    void releaseIterator();
+
+    //Called when an object is deleted, clears all entries that point to it.
+    static void clearObject(AutoPointerObject* object);
+private:
+    //Find the fields in the chain of the object of the entry that point at the entry.
+    void findLink(uint32_t index, _PVectorStorage**& link_storage, uint32_t*& link_index);
+    //Take the entry out of the chain of its object, or add it at the start of the chain.
+    void unlink(uint32_t index);
+    void relink(uint32_t index);
+};
+
+class _PVectorIteratorBase
+{
+public:
+    _PVectorIteratorBase()
+    : storage(nullptr), index(0)
+    {
+    }
+
+    _PVectorIteratorBase(_PVectorStorage* storage, int index)
+    : storage(storage), index(index)
+    {
+        if (storage)
+            storage->iterators++;
+    }
+
+    _PVectorIteratorBase(const _PVectorIteratorBase& other)
+    : _PVectorIteratorBase(other.storage, other.index)
+    {
+    }
+
+    ~_PVectorIteratorBase()
+    {
+        if (storage)
+            storage->releaseIterator();
+    }
+
+    _PVectorIteratorBase& operator=(const _PVectorIteratorBase& other)
+    {
+        if (other.storage)
+            other.storage->iterators++;
+        if (storage)
+            storage->releaseIterator();
+        storage = other.storage;
+        index = other.index;
+        return *this;
+    }
+protected:
+    _PVectorStorage* storage;
+    int index;
+
+    bool isValid() const
+    {
+        //Negative indexes wrap to large unsigned values, so this also ends reverse iteration.
+        return storage && size_t(index) < storage->items.size();
+    }
+
+    //Skip over deleted and removed entries, in the given direction.
+    void skipHoles(int direction)
+    {
+        if (!storage)
+            return;
+        auto& items = storage->items;
+        while(size_t(index) < items.size() && !items[index].object)
+        {
+            storage->has_holes = true;
+            index += direction;
+        }
+    }
+};
+
+/** Vector backed list of pointers to AutoPointerObjects.
+
+    Functions the same as \ref sp::PList<T>: objects are removed from the list when they are deleted,
+    and objects can be added, removed or deleted while iterating.
+
+    Entries are plain pointers in a single array, so iterating runs over contiguous memory, without taking a \ref sp::P<T> to every object.
+    Iterators return T*, which stays valid till the object is deleted.
+    Deleted and removed objects leave a hole in the array, which is compacted when no iterator is using the list anymore.
+    Objects added while iterating are visited by running iterators.
+ */
+template<class T> class PVector : NonCopyable
+{
+public:
+    class Iterator : public _PVectorIteratorBase
+    {
+    public:
+        Iterator()
+        {
+        }
+
+        Iterator(_PVectorStorage* storage)
+        : _PVectorIteratorBase(storage, 0)
+        {
+            skipHoles(1);
+        }
+
+        T* operator*() const
+        {
+            return static_cast<T*>(storage->items[index].object);
+        }
+
+        void operator++()
+        {
+            index++;
+            skipHoles(1);
+        }
+
+        //Only compares to the end iterator, the end of the list can change while iterating.
+        bool operator==(const Iterator& other) const
+        {
+            return isValid() == other.isValid() && (!isValid() || index == other.index);
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    class ReverseIterator : public _PVectorIteratorBase
+    {
+    public:
+        ReverseIterator()
+        {
+        }
+
+        ReverseIterator(_PVectorStorage* storage)
+        : _PVectorIteratorBase(storage, int(storage->items.size()) - 1)
+        {
+            skipHoles(-1);
+        }
+
+        T* operator*() const
+        {
+            return static_cast<T*>(storage->items[index].object);
+        }
+
+        void operator++()
+        {
+            index--;
+            skipHoles(-1);
+        }
+
+        bool operator==(const ReverseIterator& other) const
+        {
+            return isValid() == other.isValid() && (!isValid() || index == other.index);
+        }
+
+        bool operator!=(const ReverseIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    PVector()
+    : storage(nullptr)
+    {
+    }
+
+    ~PVector()
+    {
+        if (!storage)
+            return;
+        storage->clear();
+        if (storage->iterators > 0)
+            storage->orphaned = true;
+        else
+            delete storage;
+    }
+
+    void add(P<T> item)
+    {
+        if (!item)
+            return;
+        if (!storage)
+            storage = new _PVectorStorage();
+        storage->add(*item);
+    }
+
+    void remove(P<T> item)
+    {
+        if (item && storage)
+            storage->remove(*item);
+    }
+
+    void clear()
+    {
+        if (storage)
+            storage->clear();
+    }
+
+    Iterator begin() const
+    {
+        if (!storage)
+            return Iterator();
+        return Iterator(storage);
+    }
+
+    const Iterator end() const
+    {
+        return Iterator();
+    }
+
+    ReverseIterator rbegin() const
+    {
+        if (!storage)
+            return ReverseIterator();
+        return ReverseIterator(storage);
+    }
+
+    const ReverseIterator rend() const
+    {
+        return ReverseIterator();
+    }
+
+    int size() const
+    {
+        if (!storage)
+            return 0;
+        return storage->count;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Sort the list, with the same compare function as \ref sp::PList<T>::sort. Sorting while iterating can cause iterators to skip or repeat entries.
+    void sort(std::function<int(const P<T>& a, const P<T>& b)> compare_function)
+    {
+        if (!storage)
+            return;
+        storage->sort([&compare_function](AutoPointerObject* a, AutoPointerObject* b)
+        {
+            return compare_function(static_cast<T*>(a), static_cast<T*>(b)) < 0;
+        });
+    }
+private:
+    _PVectorStorage* storage;
+};
+
+}//namespace sp
+
+#endif//SP2_POINTER_VECTOR_H
@@ -2,10 +2,13 @@
 #define SP2_RANDOM_H
 
 #include <iterator>
+#include <type_traits>
 #include <sp2/pointerList.h>
+#include <sp2/pointerVector.h>
 
 namespace sp {
 
+//The shared random engine is locked, so these can be called from scenes that are updated in parallel.
 float random(float fmin, float fmax);
 int irandom(int imin, int imax);
 bool chance(float percentage);
@@ -26,7 +29,8 @@ template<typename Container> typename Container::const_iterator randomSelect(con
     return randomSelect(container.begin(), container.end());
 }
 
-template<typename T> P<T> randomSelect(PList<T>& container)
+//PList<T> and PVector<T> have no random access, so walk the list up to the selected object.
+template<template<class> class Container, typename T, typename = typename std::enable_if<std::is_same<Container<T>, PList<T>>::value || std::is_same<Container<T>, PVector<T>>::value>::type> P<T> randomSelect(Container<T>& container)
 {
     auto n = irandom(0, container.size() - 1);
     for(auto t : container) {
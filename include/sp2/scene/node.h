@@ -5,9 +5,11 @@
 #include <sp2/math/quaternion.h>
 #include <sp2/script/bindingObject.h>
 #include <sp2/pointerList.h>
+#include <sp2/pointerVector.h>
 #include <sp2/graphics/scene/renderdata.h>
 #include <sp2/graphics/animation.h>
 #include <sp2/multiplayer/replication.h>
+#include <atomic>
 
 class b2Body;
 class btRigidBody;
@@ -49,7 +51,8 @@ public:
 
     P<Node> getParent() const;
     P<Scene> getScene() const;
-    const PList<Node>& getChildren();
+    //Iterating the children gives Node*, use P<Node> as loop variable when the loop can delete nodes.
+    const PVector<Node>& getChildren();
     void setParent(P<Node> new_parent);
     
     void setPosition(Vector2d position);
@@ -82,8 +85,14 @@ public:
     Vector3d getLinearVelocity3D() const;
     Vector3d getAngularVelocity3D() const;
     
-    const Matrix4x4f& getGlobalTransform() const { return global_transform; }
-    const Matrix4x4f& getLocalTransform() const { return local_transform; }
+    //Transforms are calculated lazily, so moving a node multiple times per frame only costs a single matrix calculation.
+    //Resolving an outdated global transform writes to the transform store of the scene. Other threads, like render jobs,
+    //may only call this after updateGlobalTransforms, while no node of the scene is moved, so the transforms are only read.
+    const Matrix4x4f& getGlobalTransform() const;
+    const Matrix4x4f& getLocalTransform() const;
+    //Calculate all outdated global transforms of the scene this node is in, in a single batched pass.
+    //Called by the scene once per frame, but can be called manually before touching many global transforms.
+    void updateGlobalTransforms();
 
     //Set or replace the current collision shape on this body.
     //If you want to shape change, you do not need to call removeCollisionShape() before calling setCollisionShape (doing so will reset the velocity)
@@ -109,12 +118,42 @@ public:
     virtual void onUpdate(float delta) {}
     //Event called 60 times per second. Not called when the game is paused.
     virtual void onFixedUpdate() {}
+    //A node only gets onUpdate and onFixedUpdate calls after it enables them, subclasses that override them call these from their constructor.
+    //Nodes are ticked in the order they enabled the event, a node moves to the end when it is reparented, so parents are ticked before their children.
+    //Every node is ticked at most once per frame, also when it is reparented during the tick. Animations are updated after all onUpdate calls.
+    void setUpdateEnabled(bool enabled);
+    void setFixedUpdateEnabled(bool enabled);
     //Event called when 2 nodes collide. Not called when the game is paused.
     virtual void onCollision(CollisionInfo& info) {}
     virtual void onCollision(CollisionInfo3D& info) {}
     
     RenderData render_data;
 
+    //Bounding sphere of the meshes of this node and all its children, relative to this node. Used by render passes to skip whole subtrees.
+    //The radius is negative when nothing in the subtree has a mesh, and infinite when culling is disabled somewhere in the subtree.
+    void getRenderBounds(Vector3f& center, float& radius);
+    //Moving, adding and removing nodes, and changes to the mesh of rendered nodes, update the bounds automatically.
+    //Call this after changing render_data.mesh or render_data.scale of a node that is currently culled.
+    void invalidateRenderBounds();
+    //Disable culling for nodes where the shader does not render the mesh at the position of the node, like particles in world space.
+    void setRenderCulling(bool enabled);
+
+    class StaticRenderData
+    {
+    public:
+        //Meshes of the subtree merged per material, relative to the static node.
+        std::vector<RenderData> merged;
+        //Nodes that render but could not be merged, because their mesh is dynamic, they have a lod chain, or their shader does not allow batching.
+        PVector<Node> unmerged;
+    };
+    //Merge the meshes of this node and all its children into a few large meshes, drawn with the transform of this node.
+    //Moving this node is free, while moving, adding or destroying a node in the subtree merges the meshes again.
+    //Call invalidateRenderBounds after changing the render_data of a node in a static subtree.
+    void setRenderStatic(bool enabled);
+    bool isRenderStatic() const { return render_static; }
+    //Merged meshes of a static subtree, merged again first when the subtree changed.
+    const StaticRenderData& getStaticRenderData();
+
     class Multiplayer
     {
     public:
@@ -204,19 +243,36 @@ private:
 
     P<Scene> scene;
     P<Node> parent;
-    PList<Node> children;
+    PVector<Node> children;
     void* collision_body = nullptr;
     
-    Vector3d translation;
-    Quaterniond rotation;
-    
-    Matrix4x4f global_transform;
-    Matrix4x4f local_transform;
+    //Slot of this node in the TransformStore of the scene, which holds the translation, rotation and matrices.
+    int transform_slot;
+    //Position of this node in the tick lists of the scene, -1 when not in the list.
+    int tick_list_index[3] = {-1, -1, -1};
+    //Tick of the scene this node was last updated in, per tick list.
+    uint32_t last_tick[3] = {0, 0, 0};
 
     std::unique_ptr<Animation> animation;
+
+    //Cached result of getRenderBounds, together with the mesh state it was calculated from.
+    //Only written by the thread that renders this node. Threaded render passes give every job its own subtrees,
+    //and a job only sets the dirty flags of the parents above its subtrees, which were already rendered this frame.
+    Vector3f render_bounds_center;
+    float render_bounds_radius = -1.0f;
+    //Atomic, as threaded render passes can invalidate the bounds of shared parents from several jobs.
+    std::atomic<bool> render_bounds_dirty{true};
+    bool render_culling = true;
+    const MeshData* render_bounds_mesh = nullptr;
+    int render_bounds_mesh_revision = 0;
+    Vector3f render_bounds_scale;
+
+    //Merged meshes when this node is the root of a static subtree. Marked dirty together with the render bounds.
+    bool render_static = false;
+    std::atomic<bool> render_static_dirty{true};
+    std::unique_ptr<StaticRenderData> static_render_data;
     
-    void updateLocalTransform();
-    void updateGlobalTransform();
+    void reattach(Scene* old_scene);
     
     void modifyPositionByPhysics(sp::Vector2d position, double rotation);
     void modifyPositionByPhysics(sp::Vector3d position, Quaterniond rotation);
@@ -3,6 +3,7 @@
 
 #include <sp2/pointer.h>
 #include <sp2/pointerList.h>
+#include <sp2/pointerVector.h>
 #include <sp2/string.h>
 #include <sp2/math/vector.h>
 #include <sp2/math/ray.h>
@@ -11,6 +12,7 @@
 #include <sp2/io/textinput.h>
 #include <sp2/script/bindingObject.h>
 #include <sp2/collision/backend.h>
+#include <sp2/scene/transformStore.h>
 
 #include <unordered_map>
 
@@ -46,6 +48,24 @@ public:
     void postFixedUpdate(float delta);
     void update(float delta);
 
+    /** Mark this scene as independent from all other scenes.
+        When the engine has parallel scene updates enabled, independent scenes are updated on the job system at the same time as other scenes.
+        Nodes in an independent scene should not access nodes or data of other scenes from their update functions.
+        sp::random and multiplayer getNode are locked and safe to use, but creating or destroying Updatables is not, scenes that do so must stay serial.
+     */
+    void setIndependentUpdate(bool independent) { independent_update = independent; }
+    bool isIndependentUpdate() { return independent_update; }
+
+    class UpdateTiming
+    {
+    public:
+        //Time spend in all fixed updates of the last frame.
+        float fixed_update = 0.0f;
+        float update = 0.0f;
+    } last_update_timing;
+    //Number of node global transforms calculated in this scene so far.
+    size_t getTransformUpdateCount() const { return transforms.getGlobalUpdateCount(); }
+
     virtual bool onPointerMove(Ray3d ray, int id);
     virtual void onPointerLeave(int id);
     virtual bool onPointerDown(io::Pointer::Button button, Ray3d ray, int id);
@@ -92,20 +112,38 @@ private:
     P<Node> root;
     P<Camera> camera;
     collision::Backend* collision_backend = nullptr;
+    TransformStore transforms;
     uint32_t enable_flags;
     int priority;
-
-    void updateNode(float delta, P<Node> node);
-    void fixedUpdateNode(P<Node> node);
+    bool independent_update = false;
+    float fixed_update_time_accumulator = 0.0f;
+
+    //Flat lists of the nodes that need an update, fixed update or animation tick.
+    //Removed nodes leave a nullptr behind, which is cleaned up after the next tick of that list.
+    enum TickList
+    {
+        TickUpdate,
+        TickFixedUpdate,
+        TickAnimation,
+        TickListCount
+    };
+    std::vector<Node*> tick_lists[TickListCount];
+    bool tick_list_has_holes[TickListCount] = {false, false, false};
+    //Counts the ticks of each list, nodes remember the last tick they got, so nodes that move to the end of a list while it is ticking are not ticked twice.
+    uint32_t tick_counter[TickListCount] = {0, 0, 0};
+
+    void addToTickList(TickList list, Node* node);
+    void removeFromTickList(TickList list, Node* node);
+    void compactTickList(TickList list);
 
     static std::unordered_map<string, P<Scene>> scene_mapping;
 
 public:
     static P<Scene> get(const string& name) { return scene_mapping[name]; }
 
-    static const PList<Scene>& all() { return scenes; }
+    static const PVector<Scene>& all() { return scenes; }
 private:
-    static PList<Scene> scenes;
+    static PVector<Scene> scenes;
 };
 
 }//namespace sp
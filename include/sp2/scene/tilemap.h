@@ -3,9 +3,16 @@
 
 #include <sp2/scene/node.h>
 #include <sp2/container/infinigrid.h>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace sp {
 
+/** Grid of tiles, meshed per 64x64 chunk of the InfiniGrid.
+    Every chunk gets a child node with its own mesh, so a tile edit only remeshes its own chunk,
+    and the render pass can cull chunks that are out of view.
+    The shader, texture, type, order and color of the render_data of the tilemap are applied to all chunk nodes.
+ */
 class Tilemap : public Node
 {
 public:
@@ -46,10 +53,16 @@ private:
     Vector2f texture_spacing;
     Vector2f texture_margin;
     InfiniGrid<Tile> tiles;
-    bool dirty;
-    
-    void updateMesh();
+    std::unordered_map<Vector2i, P<Node>> chunk_nodes;
+    std::unordered_set<Vector2i> dirty_chunks;
+    bool collision_dirty;
+    //Render settings last applied to the chunk nodes.
+    RenderData chunk_render_data;
+
+    void markAllChunksDirty();
+    void updateChunkMesh(Vector2i chunk_position);
     void updateCollision();
+    void applyRenderData(RenderData& data);
     
     friend class TilemapCollisionBuilder;
 };
@@ -0,0 +1,106 @@
+#ifndef SP2_SCENE_TRANSFORM_STORE_H
+#define SP2_SCENE_TRANSFORM_STORE_H
+
+#include <sp2/nonCopyable.h>
+#include <sp2/math/matrix4x4.h>
+#include <sp2/math/quaternion.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace sp {
+
+/** Storage of all node transforms of a single scene.
+
+    Transforms are stored in flat arrays indexed by a slot number instead of inside the nodes,
+    so updating the transforms of a scene runs over contiguous memory.
+    The batched update processes the changed slots level by level, and builds the local matrices of 4 nodes at once with SIMD instructions.
+    Children are only visited when the global transform of their parent changed, so a frame in which nothing moved costs nothing.
+
+    Global transforms are tracked with version numbers, so a single transform can also be resolved on demand.
+
+    This is used internally by sp::Node and sp::Scene, nodes act as a facade on top of this store.
+ */
+class TransformStore : NonCopyable
+{
+public:
+    // Create a new slot, with -1 as parent_slot for nodes at the top of the hierarchy.
+    int create(int parent_slot);
+    void destroy(int slot);
+    void setParent(int slot, int parent_slot);
+
+    void setTranslation(int slot, const Vector3d& translation);
+    void setRotation(int slot, const Quaterniond& rotation);
+    const Vector3d& getTranslation(int slot) const { return translation[slot]; }
+    const Quaterniond& getRotation(int slot) const { return rotation[slot]; }
+
+    const Matrix4x4f& getLocalTransform(int slot);
+    // Returns the stored matrix without writing anything when nothing changed since the last update, otherwise resolves the transform on demand.
+    const Matrix4x4f& getGlobalTransform(int slot);
+
+    // Bring all global transforms up to date in a single pass, only visiting the changed parts of the hierarchy.
+    void update();
+
+    // Number of global transforms calculated so far.
+    size_t getGlobalUpdateCount() const { return global_update_count; }
+
+private:
+    static constexpr uint8_t FlagLocalDirty = 0x01;
+    static constexpr uint8_t FlagGlobalDirty = 0x02;
+    // The slot is in the dirty list of its level.
+    static constexpr uint8_t FlagQueued = 0x04;
+
+    //Matrices are stored in chunks that never move, so references to them stay valid when slots are added.
+    class MatrixArray
+    {
+    public:
+        Matrix4x4f& operator[](int index) { return chunks[index >> chunk_shift][index & chunk_mask]; }
+        void emplace_back();
+    private:
+        static constexpr int chunk_shift = 8;
+        static constexpr int chunk_mask = (1 << chunk_shift) - 1;
+        std::vector<std::unique_ptr<Matrix4x4f[]>> chunks;
+        int count = 0;
+    };
+
+    std::vector<Vector3d> translation;
+    std::vector<Quaterniond> rotation;
+
+    //Single precision copies of the translation and rotation, one array per component, as input for the SIMD kernel.
+    std::vector<float> tx, ty, tz;
+    std::vector<float> qx, qy, qz, qw;
+
+    MatrixArray local_transform;
+    MatrixArray global_transform;
+
+    std::vector<int> parent;
+    std::vector<int> first_child;
+    std::vector<int> next_sibling;
+    std::vector<int> previous_sibling;
+    std::vector<int> depth;
+    std::vector<uint8_t> flags;
+    //Global transform version, and the version of the parent it was calculated from.
+    std::vector<uint32_t> version;
+    std::vector<uint32_t> parent_version;
+
+    //Slots per hierarchy depth that changed, or have a parent that changed, since the last update.
+    std::vector<std::vector<int>> dirty_levels;
+    std::vector<int> free_slots;
+    std::vector<int> local_update_list;
+    std::vector<int> global_update_list;
+    size_t global_update_count = 0;
+    //Set by update and cleared when a slot is queued. While set, every global transform is current and can be returned as is.
+    bool all_clean = true;
+
+    void link(int slot, int parent_slot);
+    void unlink(int slot);
+    void updateDepth(int slot);
+    void queue(int slot);
+    void updateLocalTransforms(const int* slots, int count);
+    //Returns true when the global transform was recalculated.
+    bool updateGlobalTransform(int slot);
+};
+
+}//namespace sp
+
+#endif//SP2_SCENE_TRANSFORM_STORE_H
@@ -2,12 +2,21 @@
 #define SP2_SCENE_VOXELMAP_NODE_H
 
 #include <sp2/scene/node.h>
+#include <sp2/graphics/meshdata.h>
+#include <memory>
 
 namespace sp {
 
+/** Grid of voxels, meshed per chunk of chunk_size^3 voxels.
+    Every chunk with voxels gets a child node with its own mesh, so only chunks touched by an edit are meshed again,
+    and the render pass can cull chunks that are out of view.
+    The shader, texture, type, order and color of the render_data of the voxelmap are applied to all chunk nodes.
+ */
 class Voxelmap : public Node
 {
 public:
+    static constexpr int chunk_size = 16;
+
     enum class Face
     {
         Up, Down, Left, Right, Front, Back,
@@ -30,17 +39,47 @@ public:
         bool solid = true;
     };
 
+    enum class Meshing
+    {
+        PerFace,    //A quad for every visible voxel face.
+        Greedy,     //Neighbouring faces with the same tile are merged into rectangles, which need a shader that repeats the tile.
+    };
+
     Voxelmap(P<Node> parent, const string& texture, float voxel_size, int texture_tile_count);
     Voxelmap(P<Node> parent, const string& texture, float voxel_size, int texture_tile_count_x, int texture_tile_count_y);
 
     void setVoxel(sp::Vector3i position, int index);
     void setVoxelData(int index, const Data& data);
+    //Greedy meshes encode the tile in the uv and normal, for internal:voxelmap_greedy.shader, which replaces the default shader when switching.
+    void setMeshing(Meshing meshing);
+    //Build chunk meshes on the job system, from a copy of the chunk and its border. Finished meshes replace the old ones in a later onFixedUpdate.
+    void setBackgroundMeshing(bool enabled);
+    //Limit the vertices of the finished background meshes that are applied per onFixedUpdate, the rest waits for the next update. 0 for no limit.
+    void setMeshUploadBudget(int max_vertices);
+    //Build and apply all outstanding chunk meshes right away, for example after generating a level.
+    void finishMeshing();
 
     Vector3i getSize();
     bool isSolid(sp::Vector3i position);
     int getVoxel(sp::Vector3i position);
     
+    class RayHit
+    {
+    public:
+        Vector3i voxel;
+        Face face;
+        //Normal of the face that was hit and distance from the start of the ray, in world coordinates.
+        Vector3d normal;
+        double distance;
+    };
+    //Find the first solid voxel along a ray in world coordinates. The voxel the ray starts in is skipped.
+    bool raycast(const Ray3d& ray, RayHit& hit);
+    //Call the callback with every voxel that the ray enters, and the face it enters through, till the callback returns false.
     void trace(const sp::Ray3d& ray, std::function<bool(sp::Vector3i, Face)> callback);
+    //Call the callback for every solid voxel that overlaps a box or sphere in world coordinates, till the callback returns false.
+    //For a rotated voxelmap the box is tested as its bounding box in voxelmap space.
+    void queryBox(Vector3d min, Vector3d max, std::function<bool(Vector3i)> callback);
+    void querySphere(Vector3d center, double radius, std::function<bool(Vector3i)> callback);
 
     virtual void onFixedUpdate() override;
 private:
@@ -51,15 +90,48 @@ private:
 
         int index;
     };
+    class Chunk
+    {
+    public:
+        Voxel voxels[chunk_size * chunk_size * chunk_size];
+        //Number of voxels that are not empty.
+        int count = 0;
+        bool dirty = false;
+        //Number of the last mesh build that was started and that was applied, so older background results are dropped.
+        int generation = 0;
+        int applied_generation = 0;
+        P<Node> node;
+    };
+    class MeshSettings;
+    class ChunkSnapshot;
+    class MeshJob;
 
     float voxel_size;
     int texture_tile_count_x;
     int texture_tile_count_y;
-    std::vector<std::vector<std::vector<Voxel>>> voxels;
+    Vector3i size;
+    Meshing meshing = Meshing::PerFace;
+    //Flat grid of chunk_count chunks, chunks without any voxels are not allocated.
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    Vector3i chunk_count;
+    std::vector<Vector3i> dirty_chunks;
     std::vector<Data> voxel_data;
-    bool dirty;
-    
-    void updateMesh();
+    //Render settings last applied to the chunk nodes.
+    RenderData chunk_render_data;
+    std::shared_ptr<const MeshSettings> mesh_settings;
+    bool background_meshing = false;
+    int upload_budget = 0;
+    std::vector<std::shared_ptr<MeshJob>> mesh_jobs;
+
+    Chunk* getChunk(Vector3i chunk_position);
+    void markChunkDirty(Vector3i chunk_position);
+    //Call the callback with the solid voxels in the given range of voxel coordinates, skipping chunks without voxels.
+    template<typename F> void queryRange(Vector3i min, Vector3i max, F&& callback);
+    void meshDirtyChunks();
+    std::unique_ptr<ChunkSnapshot> createSnapshot(Vector3i chunk_position, Chunk& chunk);
+    void applyMeshJobs(bool wait);
+    void applyChunkMesh(MeshJob& job, Chunk& chunk);
+    void applyRenderData(RenderData& data);
 };
 
 }//namespace sp
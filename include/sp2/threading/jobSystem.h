@@ -0,0 +1,57 @@
+#ifndef SP2_THREADING_JOB_SYSTEM_H
+#define SP2_THREADING_JOB_SYSTEM_H
+
+#include <sp2/nonCopyable.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sp {
+namespace threading {
+
+/** Engine wide pool of worker threads.
+
+    Jobs are small functions that are run on one of the worker threads.
+    The pool is sized to the number of cores, and every worker has its own queue of jobs.
+    Idle workers steal jobs from the queues of other workers, so work is spread over all cores.
+
+    A job can depend on other jobs, in which case it will not be started before all those jobs are finished.
+
+    Example:
+    \code
+    auto decode = sp::threading::JobSystem::submit([](){ ... });
+    auto upload = sp::threading::JobSystem::submit([](){ ... }, {decode});
+    sp::threading::JobSystem::wait(upload);
+    \endcode
+
+    Jobs should not touch OpenGL or scene objects, as those are only safe to use from the main thread.
+ */
+class JobSystem : NonCopyable
+{
+public:
+    enum class Priority
+    {
+        High,
+        Normal,
+        Low
+    };
+    class Job;
+    using Handle = std::shared_ptr<Job>;
+
+    static Handle submit(std::function<void()> function, Priority priority=Priority::Normal);
+    static Handle submit(std::function<void()> function, const std::vector<Handle>& dependencies, Priority priority=Priority::Normal);
+
+    static bool isDone(const Handle& handle);
+    // Wait till the job is finished. The calling thread will help running jobs while it is waiting, except for Low priority jobs when called outside of a worker.
+    static void wait(const Handle& handle);
+    static void wait(const std::vector<Handle>& handles);
+
+    static int getWorkerCount();
+    // Returns true when called from one of the worker threads.
+    static bool isWorkerThread();
+};
+
+}//namespace threading
+}//namespace sp
+
+#endif//SP2_THREADING_JOB_SYSTEM_H
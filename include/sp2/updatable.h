@@ -1,13 +1,14 @@
 #ifndef SP2_UPDATABLE_H
 #define SP2_UPDATABLE_H
 
-#include <sp2/pointerList.h>
+#include <sp2/pointerVector.h>
 
 namespace sp {
 
 /**
     An updatable is an object that gets an update callback every tick and is not attached to any scene.
     General use of this is global object that needs to handle some global resource, like network communication.
+    Updatables are registered in a global list without locking, so create and destroy them from the main thread or serially updated scenes, never from a scene with independent update.
  */
 class Updatable : public AutoPointerObject
 {
@@ -17,7 +18,7 @@ public:
     virtual void onUpdate(float delta) = 0;
 
 private:
-    static PList<Updatable> updatables;
+    static PVector<Updatable> updatables;
     
     friend class Engine;
 };
@@ -10,6 +10,7 @@ void createDefaultBuildinResources()
     if (buildinResources) return;
     buildinResources = new io::InternalResourceProvider({
     {"basic.shader", R"EOS(
+[BATCHING]
 [VERTEX]
 attribute vec3 a_vertex;
 attribute vec3 a_normal;
@@ -82,6 +83,7 @@ void main()
 )EOS"},
 
     {"basic_shaded.shader", R"EOS(
+[BATCHING]
 [VERTEX]
 attribute vec3 a_vertex;
 attribute vec3 a_normal;
@@ -119,9 +121,58 @@ void main()
     if (gl_FragColor.a == 0.0)
         discard;
 }
+)EOS"},
+
+    {"voxelmap_greedy.shader", R"EOS(
+[VERTEX]
+attribute vec3 a_vertex;
+attribute vec3 a_normal;
+attribute vec2 a_uv;
+attribute vec4 a_tile;
+
+uniform mat4 projection_matrix;
+uniform mat4 camera_matrix;
+uniform mat4 object_matrix;
+uniform vec3 object_scale;
+
+varying vec2 v_tile;
+varying vec2 v_repeat;
+varying vec2 v_tile_size;
+varying vec3 v_offset;
+varying vec3 v_normal;
+
+void main()
+{
+    gl_Position = projection_matrix * camera_matrix * object_matrix * vec4(a_vertex.xyz * object_scale, 1.0);
+    //The tile attribute holds the tile and the tile count of the texture, the uv is the position on the quad in tiles.
+    v_tile = a_tile.xy;
+    v_repeat = a_uv;
+    v_tile_size = 1.0 / a_tile.zw;
+    v_normal = (camera_matrix * object_matrix * vec4(a_normal, 0.0)).xyz;
+    v_offset = (camera_matrix * object_matrix * vec4(a_vertex.xyz * object_scale, 1.0)).xyz;
+}
+
+[FRAGMENT]
+uniform sampler2D texture_map;
+uniform vec4 color;
+
+varying vec2 v_tile;
+varying vec2 v_repeat;
+varying vec2 v_tile_size;
+varying vec3 v_offset;
+varying vec3 v_normal;
+
+void main()
+{
+    gl_FragColor = texture2D(texture_map, (v_tile + fract(v_repeat)) * v_tile_size) * color;
+    gl_FragColor.rgb = gl_FragColor.rgb * -dot(normalize(v_normal), normalize(v_offset));
+    if (gl_FragColor.a == 0.0)
+        discard;
+}
 )EOS"},
 
     {"color.shader", R"EOS(
+[BATCHING]
 [VERTEX]
 attribute vec3 a_vertex;
 attribute vec3 a_normal;
@@ -150,6 +201,7 @@ void main()
 )EOS"},
 
     {"color_shaded.shader", R"EOS(
+[BATCHING]
 [VERTEX]
 attribute vec3 a_vertex;
 attribute vec3 a_normal;
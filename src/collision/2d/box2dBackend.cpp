@@ -1,6 +1,7 @@
 #include <sp2/collision/2d/box2dBackend.h>
 #include <sp2/collision/2d/joint.h>
 #include <sp2/graphics/meshdata.h>
+#include <sp2/handle.h>
 
 #include <private/collision/box2dVector.h>
 #include <private/collision/box2d.h>
@@ -158,13 +159,13 @@ namespace {
     class Collision
     {
     public:
-        P<Node> node_a;
-        P<Node> node_b;
+        Handle<Node> node_a;
+        Handle<Node> node_b;
         float force;
         sp::Vector2d position;
         sp::Vector2d normal;
 
-        Collision(P<Node> node_a, P<Node> node_b, float force, sp::Vector2d position, sp::Vector2d normal)
+        Collision(Node* node_a, Node* node_b, float force, sp::Vector2d position, sp::Vector2d normal)
         : node_a(node_a), node_b(node_b), force(force), position(position), normal(normal)
         {}
     };
@@ -266,7 +267,7 @@ void Box2DBackend::getDebugRenderMesh(std::vector<std::shared_ptr<MeshData>>& me
     world->SetDebugDraw(nullptr);
     
     if (meshes.size() < 1)
-        meshes.push_back(MeshData::create(std::move(debug_renderer.vertices), std::move(debug_renderer.indices), MeshData::Type::Dynamic));
+        meshes.push_back(MeshData::create(std::move(debug_renderer.vertices), std::move(debug_renderer.indices), MeshData::Type::Stream));
     else
         meshes[0]->update(std::move(debug_renderer.vertices), std::move(debug_renderer.indices));
 }
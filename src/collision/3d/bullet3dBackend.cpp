@@ -1,5 +1,6 @@
 #include <sp2/collision/3d/bullet3dBackend.h>
 #include <sp2/graphics/meshdata.h>
+#include <sp2/handle.h>
 #include <sp2/scene/node.h>
 
 #include <private/collision/bulletVector.h>
@@ -47,9 +48,6 @@ public:
         indices.emplace_back(index);
         indices.emplace_back(index + 1);
         indices.emplace_back(index + 3);
-
-        if (index > 65000)
-            addToMeshes();
     }
 
     virtual void drawContactPoint(const btVector3& PointOnB,const btVector3& normalOnB,btScalar distance,int lifeTime,const btVector3& color) override
@@ -79,7 +77,7 @@ private:
         if (mesh_index < meshes.size())
             meshes[mesh_index]->update(std::move(vertices), std::move(indices));
         else
-            meshes.push_back(MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic));
+            meshes.push_back(MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Stream));
         mesh_index++;
     }
 
@@ -112,13 +110,13 @@ namespace {
     class Collision
     {
     public:
-        P<Node> node_a;
-        P<Node> node_b;
+        Handle<Node> node_a;
+        Handle<Node> node_b;
         float force;
         sp::Vector3d position;
         sp::Vector3d normal;
 
-        Collision(P<Node> node_a, P<Node> node_b, float force, sp::Vector3d position, sp::Vector3d normal)
+        Collision(Node* node_a, Node* node_b, float force, sp::Vector3d position, sp::Vector3d normal)
         : node_a(node_a), node_b(node_b), force(force), position(position), normal(normal)
         {}
     };
@@ -171,7 +171,7 @@ void Simple2DBackend::getDebugRenderMesh(std::vector<std::shared_ptr<MeshData>>&
     query_callback = nullptr;
 
     if (meshes.size() < 1)
-        meshes.push_back(MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic));
+        meshes.push_back(MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Stream));
     else
         meshes[0]->update(std::move(vertices), std::move(indices));
 }
@@ -11,6 +11,7 @@
 #include <sp2/multiplayer/registry.h>
 #include <sp2/io/keybinding.h>
 #include <sp2/io/internalResourceProvider.h>
+#include <sp2/threading/jobSystem.h>
 
 #include <SDL.h>
 #ifdef __EMSCRIPTEN__
@@ -252,6 +253,27 @@ void Engine::processEvents()
     }
 }
 
+template<typename F> static void updateScenes(bool parallel, const F& function)
+{
+    std::vector<threading::JobSystem::Handle> jobs;
+    for(P<Scene> scene : Scene::all())
+    {
+        if (!scene->isEnabled(Scene::FlagEnableUpdate))
+            continue;
+        if (parallel && scene->isIndependentUpdate())
+        {
+            Scene* s = *scene;
+            jobs.push_back(threading::JobSystem::submit([s, &function]() { function(s); }, threading::JobSystem::Priority::High));
+        }
+        else
+        {
+            function(*scene);
+        }
+    }
+    //All scenes need to be done before we continue, as the next step can touch any scene.
+    threading::JobSystem::wait(jobs);
+}
+
 void Engine::update(float time_delta)
 {
     UpdateTiming timing;
@@ -278,27 +300,14 @@ void Engine::update(float time_delta)
     while(fixed_update_accumulator > fixed_update_delta)
     {
         fixed_update_accumulator -= fixed_update_delta;
-        for(P<Scene> scene : Scene::all())
-        {
-            if (scene->isEnabled(Scene::FlagEnableUpdate))
-            {
-                scene->fixedUpdate();
-            }
-        }
+        updateScenes(parallel_scene_update, [](Scene* scene) { scene->fixedUpdate(); });
         io::Keybinding::allPostFixedUpdate();
     }
     in_fixed_update = false;
-    for(P<Scene> scene : Scene::all())
-    {
-        if (scene->isEnabled(Scene::FlagEnableUpdate))
-            scene->postFixedUpdate(fixed_update_accumulator);
-    }
+    float accumulator = fixed_update_accumulator;
+    updateScenes(parallel_scene_update, [accumulator](Scene* scene) { scene->postFixedUpdate(accumulator); });
     timing.fixed_update = timing_clock.restart();
-    for(P<Scene> scene : Scene::all())
-    {
-        if (scene->isEnabled(Scene::FlagEnableUpdate))
-            scene->update(time_delta);
-    }
+    updateScenes(parallel_scene_update, [time_delta](Scene* scene) { scene->update(time_delta); });
     for(P<Updatable> updatable : Updatable::updatables)
     {
         updatable->onUpdate(time_delta);
@@ -293,7 +293,7 @@ std::shared_ptr<MeshData> Font::PreparedFontString::create()
         }
     }
 
-    return std::make_shared<MeshData>(std::move(vertices), std::move(indices));
+    return std::make_shared<MeshData>(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::Position2DUVColor);
 }
 
 float Font::PreparedFontString::getMaxLineWidth() const
@@ -0,0 +1,185 @@
+#include <sp2/graphics/glState.h>
+#include <sp2/graphics/opengl.h>
+
+namespace sp {
+
+static const unsigned int cached_capabilities[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST};
+
+GLState::Statistics GLState::statistics;
+bool GLState::valid_program = false;
+unsigned int GLState::program;
+int GLState::active_texture_unit = -1;
+bool GLState::valid_textures[texture_unit_count];
+unsigned int GLState::textures[texture_unit_count];
+bool GLState::valid_buffers[2];
+unsigned int GLState::buffers[2];
+bool GLState::valid_blend = false;
+unsigned int GLState::blend_source;
+unsigned int GLState::blend_destination;
+bool GLState::valid_depth_mask = false;
+bool GLState::depth_mask;
+int GLState::capabilities[capability_count] = {-1, -1, -1, -1};
+
+void GLState::useProgram(unsigned int program)
+{
+    if (valid_program && GLState::program == program)
+    {
+        statistics.elided++;
+        return;
+    }
+    valid_program = true;
+    GLState::program = program;
+    statistics.issued++;
+    glUseProgram(program);
+}
+
+void GLState::activeTexture(int unit)
+{
+    if (active_texture_unit == unit)
+    {
+        statistics.elided++;
+        return;
+    }
+    active_texture_unit = unit;
+    statistics.issued++;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(unsigned int target, unsigned int texture)
+{
+    //Only 2D textures on the first units are tracked, anything else is always send.
+    if (target != GL_TEXTURE_2D || active_texture_unit < 0 || active_texture_unit >= texture_unit_count)
+    {
+        //Without knowing the active unit, any of the tracked bindings could be changed by this.
+        if (active_texture_unit < 0)
+            for(int n=0; n<texture_unit_count; n++)
+                valid_textures[n] = false;
+        statistics.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+    int unit = active_texture_unit;
+    if (valid_textures[unit] && textures[unit] == texture)
+    {
+        statistics.elided++;
+        return;
+    }
+    valid_textures[unit] = true;
+    textures[unit] = texture;
+    statistics.issued++;
+    glBindTexture(target, texture);
+}
+
+void GLState::bindBuffer(unsigned int target, unsigned int buffer)
+{
+    int index = target == GL_ELEMENT_ARRAY_BUFFER ? 1 : 0;
+    if (target != GL_ARRAY_BUFFER && index == 0)
+    {
+        statistics.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (valid_buffers[index] && buffers[index] == buffer)
+    {
+        statistics.elided++;
+        return;
+    }
+    valid_buffers[index] = true;
+    buffers[index] = buffer;
+    statistics.issued++;
+    glBindBuffer(target, buffer);
+}
+
+void GLState::blendFunc(unsigned int source, unsigned int destination)
+{
+    if (valid_blend && blend_source == source && blend_destination == destination)
+    {
+        statistics.elided++;
+        return;
+    }
+    valid_blend = true;
+    blend_source = source;
+    blend_destination = destination;
+    statistics.issued++;
+    glBlendFunc(source, destination);
+}
+
+void GLState::depthMask(bool enabled)
+{
+    if (valid_depth_mask && depth_mask == enabled)
+    {
+        statistics.elided++;
+        return;
+    }
+    valid_depth_mask = true;
+    depth_mask = enabled;
+    statistics.issued++;
+    glDepthMask(enabled);
+}
+
+void GLState::enable(unsigned int capability)
+{
+    setCapability(capability, true);
+}
+
+void GLState::disable(unsigned int capability)
+{
+    setCapability(capability, false);
+}
+
+void GLState::forgetTexture(unsigned int texture)
+{
+    for(int n=0; n<texture_unit_count; n++)
+        if (textures[n] == texture)
+            valid_textures[n] = false;
+}
+
+void GLState::forgetBuffer(unsigned int buffer)
+{
+    for(int n=0; n<2; n++)
+        if (buffers[n] == buffer)
+            valid_buffers[n] = false;
+}
+
+void GLState::invalidate()
+{
+    valid_program = false;
+    active_texture_unit = -1;
+    for(int n=0; n<texture_unit_count; n++)
+        valid_textures[n] = false;
+    for(int n=0; n<2; n++)
+        valid_buffers[n] = false;
+    valid_blend = false;
+    valid_depth_mask = false;
+    for(int n=0; n<capability_count; n++)
+        capabilities[n] = -1;
+}
+
+int GLState::findCapability(unsigned int capability)
+{
+    for(int n=0; n<capability_count; n++)
+        if (cached_capabilities[n] == capability)
+            return n;
+    return -1;
+}
+
+void GLState::setCapability(unsigned int capability, bool enabled)
+{
+    int index = findCapability(capability);
+    if (index != -1)
+    {
+        if (capabilities[index] == int(enabled))
+        {
+            statistics.elided++;
+            return;
+        }
+        capabilities[index] = int(enabled);
+    }
+    statistics.issued++;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+}//namespace sp
@@ -8,8 +8,9 @@ void GridLayout::update(P<Widget> container, Rect2d rect)
 {
     Vector2i grid_size;
     int max_span = 1;
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
         Vector2i position = Vector2i(w->layout.position);
@@ -31,8 +32,9 @@ void GridLayout::update(P<Widget> container, Rect2d rect)
 
     for(int span_size = 1; span_size <= max_span; span_size += 1)
     {
-        for(P<Widget> w : container->getChildren())
+        for(Node* child : container->getChildren())
         {
+            Widget* w = dynamic_cast<Widget*>(child);
             if (!w || !w->isVisible())
                 continue;
             Vector2i position = Vector2i(w->layout.position);
@@ -94,8 +96,9 @@ void GridLayout::update(P<Widget> container, Rect2d rect)
             row_y[n] += row_height[m];
     }
     
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
         Vector2i position = Vector2i(w->layout.position);
@@ -110,7 +113,7 @@ void GridLayout::update(P<Widget> container, Rect2d rect)
         auto old_position = w->layout.position;
         w->layout.position.x = w->layout.position.y = 0.0;
         cell_pos.y = rect.position.y + rect.size.y - cell_pos.y - cell_size.y;
-        basicLayout(Rect2d(cell_pos, cell_size), *w);
+        basicLayout(Rect2d(cell_pos, cell_size), w);
         w->layout.position = old_position;
     }
 }
@@ -8,8 +8,9 @@ void HorizontalLayout::update(P<Widget> container, Rect2d rect)
 {
     float total_width = 0.0f;
     float fill_width = 0.0f;
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
         float width = w->layout.size.x + w->layout.margin.left + w->layout.margin.right;
@@ -19,14 +20,15 @@ void HorizontalLayout::update(P<Widget> container, Rect2d rect)
     }
     float remaining_width = rect.size.x - total_width;
     float x = rect.position.x;
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
         float width = w->layout.size.x + w->layout.margin.left + w->layout.margin.right;
         if (w->layout.fill_width && fill_width > 0.0f)
             width += remaining_width * w->layout.size.x / fill_width;
-        basicLayout(Rect2d(x, rect.position.y, width, rect.size.y), *w);
+        basicLayout(Rect2d(x, rect.position.y, width, rect.size.y), w);
         x = w->getPosition2D().x + w->getRenderSize().x + w->layout.margin.right;
     }
 }
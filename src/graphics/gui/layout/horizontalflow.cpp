@@ -9,8 +9,9 @@ void HorizontalFlowLayout::update(P<Widget> container, Rect2d rect)
     double x = rect.position.x;
     double y0 = rect.position.y + rect.size.y;
     double y1 = rect.position.y + rect.size.y;
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
         double width = w->layout.size.x + w->layout.margin.left + w->layout.margin.right;
@@ -20,7 +21,7 @@ void HorizontalFlowLayout::update(P<Widget> container, Rect2d rect)
             x = rect.position.x;
         }
         double height = y0 - rect.position.y;
-        basicLayout(Rect2d(x, y0 - height, width, height), *w);
+        basicLayout(Rect2d(x, y0 - height, width, height), w);
         y1 = std::min(y1, y0 - w->getRenderSize().y - w->layout.margin.bottom);
         x += width;
     }
@@ -22,11 +22,12 @@ void Layout::updateLoop(P<Widget> container, Rect2d rect)
 
 void Layout::update(P<Widget> container, Rect2d rect)
 {
-    for(P<Widget> w : container->getChildren())
+    for(Node* child : container->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w || !w->isVisible())
             continue;
-        basicLayout(rect, *w);
+        basicLayout(rect, w);
     }
 }
 
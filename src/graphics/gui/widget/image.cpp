@@ -79,7 +79,7 @@ void Image::updateRenderData()
             vertices.emplace_back(Vector3f(p0.x, p1.y, 0.0f), Vector2f(uv.position.x, uv.position.y));
             vertices.emplace_back(Vector3f(p1.x, p1.y, 0.0f), Vector2f(uv.position.x + uv.size.x, uv.position.y));
 
-            render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic);
+            render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic, MeshData::Layout::Position2DUV);
         }
         else
         {
@@ -97,7 +97,7 @@ void Image::updateRenderData()
                     float y1 = std::min(y0 + tile_size.y, getRenderSize().y);
                     float u = uv.size.x * (x1 - x0) / tile_size.x;
                     float v = uv.size.y * (y1 - y0) / tile_size.y;
-                    uint16_t idx = vertices.size();
+                    uint32_t idx = vertices.size();
                     vertices.emplace_back(Vector3f(x0, y0, 0.0f), Vector2f(uv.position.x, uv.position.y + v));
                     vertices.emplace_back(Vector3f(x1, y0, 0.0f), Vector2f(uv.position.x + u, uv.position.y + v));
                     vertices.emplace_back(Vector3f(x0, y1, 0.0f), Vector2f(uv.position.x, uv.position.y));
@@ -111,7 +111,7 @@ void Image::updateRenderData()
                 }
             }
 
-            render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic);
+            render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic, MeshData::Layout::Position2DUV);
         }
 
         render_data.shader = Shader::get("internal:basic.shader");
@@ -152,9 +152,9 @@ P<Widget> KeyNavigator::findFirstTarget(P<Widget> w)
     if (!w) return nullptr;
     if (canTarget(w))
         return w;
-    for(auto child : w->getChildren())
+    for(Node* child : w->getChildren())
     {
-        auto result = findFirstTarget(child);
+        auto result = findFirstTarget(dynamic_cast<Widget*>(child));
         if (result)
             return result;
     }
@@ -171,8 +171,9 @@ P<Widget> KeyNavigator::findNextTarget(P<Widget> w, P<Widget> after)
         return findFirstTarget(w);
     }
     bool found = !after;
-    for(auto child : w->getChildren())
+    for(Node* node : w->getChildren())
     {
+        P<Widget> child = P<Node>(node);
         if (child == after)
             found = true;
         else if (found && canTarget(child))
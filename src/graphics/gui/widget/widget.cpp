@@ -21,12 +21,14 @@ Widget::Widget(P<Widget> parent)
     theme_name = parent->theme_name;
     render_data.type = parent->render_data.type;
     render_order = 0;
+    setUpdateEnabled(true);
 }
 
 Widget::Widget(P<Node> parent)
 : Node(parent)
 {
     render_data.type = RenderData::Type::Normal;
+    setUpdateEnabled(true);
 }
 
 Widget::~Widget()
@@ -143,8 +145,9 @@ void Widget::setSize(Vector2d v)
 static void recursiveSetRenderType(P<Widget> widget, RenderData::Type type)
 {
     widget->render_data.type = type;
-    for(P<Widget> w : widget->getChildren())
+    for(Node* child : widget->getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w)
             continue;
         if (w->isVisible())
@@ -386,13 +389,14 @@ P<Widget> Widget::getWidgetWithID(const string& id)
 {
     if (this->id == id)
         return this;
-    for(P<Widget> w : getChildren())
+    for(Node* child : getChildren())
     {
+        Widget* w = dynamic_cast<Widget*>(child);
         if (!w)
             continue;
-        w = w->getWidgetWithID(id);
-        if (w)
-            return w;
+        P<Widget> result = w->getWidgetWithID(id);
+        if (result)
+            return result;
     }
     return nullptr;
 }
@@ -436,8 +440,9 @@ void Widget::updateLayout(Vector2d position, Vector2d size)
         {
             Vector2d content_size_min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
             Vector2d content_size_max(std::numeric_limits<float>::min(), std::numeric_limits<float>::min());
-            for(P<Widget> w : getChildren())
+            for(Node* child : getChildren())
             {
+                Widget* w = dynamic_cast<Widget*>(child);
                 if (w && w->isVisible())
                 {
                     Vector2d p0 = w->getPosition2D();
@@ -550,7 +555,7 @@ void Widget::updateRenderDataToThemeImage(Rect2f rect, Rect2f clip, int flags)
         vertices.emplace_back(Vector3f(v2.x, v3.y, 0), Vector2f(uv2.x, uv3.y));
         vertices.emplace_back(Vector3f(v3.x, v3.y, 0), Vector2f(uv3.x, uv3.y));
 
-        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices));
+        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::Position2DUV);
     }
     else
     {
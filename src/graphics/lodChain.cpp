@@ -0,0 +1,325 @@
+#include <sp2/graphics/lodChain.h>
+#include <sp2/graphics/mesh/obj.h>
+#include <sp2/graphics/mesh/glb.h>
+#include <sp2/logging.h>
+#include <sp2/assert.h>
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <map>
+#include <tuple>
+#include <string.h>
+
+namespace sp {
+
+std::unordered_map<string, std::shared_ptr<LodChain>> LodChain::cache;
+
+LodChain::LodChain(std::shared_ptr<MeshData> mesh)
+{
+    levels.push_back({mesh, std::numeric_limits<float>::infinity()});
+}
+
+void LodChain::addLevel(std::shared_ptr<MeshData> mesh, float max_screen_size)
+{
+    sp2assert(max_screen_size < levels.back().max_screen_size, "LOD thresholds need to decrease with every level");
+    levels.push_back({mesh, max_screen_size});
+}
+
+int LodChain::selectLevel(float screen_size, int current_level) const
+{
+    int level = std::min(std::max(current_level, 0), int(levels.size()) - 1);
+    while(level > 0 && screen_size >= levels[level].max_screen_size * (1.0f + hysteresis))
+        level--;
+    while(level + 1 < int(levels.size()) && screen_size < levels[level + 1].max_screen_size * (1.0f - hysteresis))
+        level++;
+    return level;
+}
+
+std::shared_ptr<LodChain> LodChain::generate(std::shared_ptr<MeshData> mesh, int level_count, float reduction, float first_threshold)
+{
+    auto chain = std::make_shared<LodChain>(mesh);
+    int triangles = int(mesh->getIndices().size() / 3);
+    float threshold = first_threshold;
+    for(int n=1; n<level_count; n++)
+    {
+        int target = int(float(triangles) * reduction);
+        if (target < 1)
+            break;
+        //Every level is simplified from the previous one, which is a lot cheaper than starting from the full mesh every time.
+        auto level = simplifyMesh(*chain->levels.back().mesh, target);
+        int level_triangles = int(level->getIndices().size() / 3);
+        if (level_triangles >= triangles)
+            break;
+        chain->addLevel(level, threshold);
+        triangles = level_triangles;
+        threshold *= 0.5f;
+    }
+    return chain;
+}
+
+std::shared_ptr<LodChain> LodChain::get(const string& resource_name)
+{
+    auto it = cache.find(resource_name);
+    if (it != cache.end())
+        return it->second;
+
+    std::shared_ptr<MeshData> mesh;
+    if (resource_name.endswith(".glb"))
+        mesh = GLBLoader::getMesh(resource_name);
+    else
+        mesh = obj_loader.get(resource_name);
+    std::shared_ptr<LodChain> chain;
+    if (mesh)
+        chain = generate(mesh);
+    else
+        LOG(Warning, "Failed to load mesh for LOD chain:", resource_name);
+    cache[resource_name] = chain;
+    return chain;
+}
+
+//Symmetric 4x4 matrix that sums the squared distances to a set of planes.
+class SimplifyQuadric
+{
+public:
+    double m[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    void addPlane(const Vector3d& normal, double d, double weight)
+    {
+        double a = normal.x, b = normal.y, c = normal.z;
+        m[0] += weight * a * a; m[1] += weight * a * b; m[2] += weight * a * c; m[3] += weight * a * d;
+        m[4] += weight * b * b; m[5] += weight * b * c; m[6] += weight * b * d;
+        m[7] += weight * c * c; m[8] += weight * c * d;
+        m[9] += weight * d * d;
+    }
+
+    void add(const SimplifyQuadric& other)
+    {
+        for(int n=0; n<10; n++)
+            m[n] += other.m[n];
+    }
+
+    double error(const Vector3d& p) const
+    {
+        return m[0] * p.x * p.x + 2 * m[1] * p.x * p.y + 2 * m[2] * p.x * p.z + 2 * m[3] * p.x
+            + m[4] * p.y * p.y + 2 * m[5] * p.y * p.z + 2 * m[6] * p.y
+            + m[7] * p.z * p.z + 2 * m[8] * p.z
+            + m[9];
+    }
+};
+
+class SimplifyCollapse
+{
+public:
+    double cost;
+    int a, b;
+    int version_a, version_b;
+    Vector3d position;
+
+    bool operator<(const SimplifyCollapse& other) const { return cost > other.cost; }
+};
+
+std::shared_ptr<MeshData> simplifyMesh(MeshData& mesh, int target_triangle_count)
+{
+    const MeshData::Vertices& source_vertices = mesh.getVertices();
+    const MeshData::Indices& source_indices = mesh.getIndices();
+
+    //Weld the vertices by position, the collapses work on the welded points, the original vertices keep their own normal and uv.
+    std::vector<int> weld(source_vertices.size());
+    std::vector<Vector3d> positions;
+    std::vector<std::vector<int>> members;
+    {
+        std::map<std::tuple<float, float, float>, int> lookup;
+        for(size_t n=0; n<source_vertices.size(); n++)
+        {
+            const Vector3f& p = source_vertices[n].position;
+            auto result = lookup.emplace(std::make_tuple(p.x, p.y, p.z), int(positions.size()));
+            if (result.second)
+            {
+                positions.emplace_back(p.x, p.y, p.z);
+                members.emplace_back();
+            }
+            weld[n] = result.first->second;
+            members[weld[n]].push_back(int(n));
+        }
+    }
+
+    int triangle_count = int(source_indices.size() / 3);
+    std::vector<bool> triangle_removed(triangle_count, false);
+    std::vector<std::vector<int>> point_triangles(positions.size());
+    std::vector<SimplifyQuadric> quadrics(positions.size());
+    std::vector<int> versions(positions.size(), 0);
+    std::vector<bool> point_removed(positions.size(), false);
+    auto corner = [&](int triangle, int n) { return weld[source_indices[triangle * 3 + n]]; };
+
+    int live_triangles = 0;
+    std::map<std::pair<int, int>, int> edge_use;
+    for(int t=0; t<triangle_count; t++)
+    {
+        int p0 = corner(t, 0), p1 = corner(t, 1), p2 = corner(t, 2);
+        if (p0 == p1 || p1 == p2 || p2 == p0)
+        {
+            triangle_removed[t] = true;
+            continue;
+        }
+        live_triangles++;
+        Vector3d normal = (positions[p1] - positions[p0]).cross(positions[p2] - positions[p0]);
+        double area = normal.length();
+        if (area > 0.0)
+            normal = normal / area;
+        SimplifyQuadric q;
+        q.addPlane(normal, -normal.dot(positions[p0]), area);
+        for(int n=0; n<3; n++)
+        {
+            int p = corner(t, n);
+            quadrics[p].add(q);
+            point_triangles[p].push_back(t);
+            int next = corner(t, (n + 1) % 3);
+            edge_use[std::make_pair(std::min(p, next), std::max(p, next))]++;
+        }
+    }
+    //Open borders get a heavy plane perpendicular to their triangle, so collapses keep the outline of the mesh in place.
+    for(int t=0; t<triangle_count; t++)
+    {
+        if (triangle_removed[t])
+            continue;
+        int p0 = corner(t, 0), p1 = corner(t, 1), p2 = corner(t, 2);
+        Vector3d face_normal = (positions[p1] - positions[p0]).cross(positions[p2] - positions[p0]);
+        for(int n=0; n<3; n++)
+        {
+            int a = corner(t, n);
+            int b = corner(t, (n + 1) % 3);
+            if (edge_use[std::make_pair(std::min(a, b), std::max(a, b))] != 1)
+                continue;
+            Vector3d edge = positions[b] - positions[a];
+            Vector3d normal = edge.cross(face_normal);
+            double length = normal.length();
+            if (length <= 0.0)
+                continue;
+            normal = normal / length;
+            SimplifyQuadric q;
+            q.addPlane(normal, -normal.dot(positions[a]), edge.dot(edge) * 1000.0);
+            quadrics[a].add(q);
+            quadrics[b].add(q);
+        }
+    }
+
+    std::priority_queue<SimplifyCollapse> heap;
+    auto pushCollapse = [&](int a, int b)
+    {
+        SimplifyQuadric q = quadrics[a];
+        q.add(quadrics[b]);
+        Vector3d options[3] = {positions[a], positions[b], (positions[a] + positions[b]) * 0.5};
+        SimplifyCollapse collapse{std::numeric_limits<double>::infinity(), a, b, versions[a], versions[b], options[0]};
+        for(const auto& option : options)
+        {
+            double cost = q.error(option);
+            if (cost < collapse.cost)
+            {
+                collapse.cost = cost;
+                collapse.position = option;
+            }
+        }
+        heap.push(collapse);
+    };
+    for(auto& it : edge_use)
+        pushCollapse(it.first.first, it.first.second);
+
+    //Moving a point should not turn any of its remaining triangles around.
+    auto flips = [&](int point, int other, const Vector3d& position)
+    {
+        for(int t : point_triangles[point])
+        {
+            if (triangle_removed[t])
+                continue;
+            Vector3d p[3];
+            bool shared = false;
+            for(int n=0; n<3; n++)
+            {
+                int c = corner(t, n);
+                shared = shared || c == other;
+                p[n] = c == point ? position : positions[c];
+            }
+            if (shared)
+                continue;
+            Vector3d before = (positions[corner(t, 1)] - positions[corner(t, 0)]).cross(positions[corner(t, 2)] - positions[corner(t, 0)]);
+            Vector3d after = (p[1] - p[0]).cross(p[2] - p[0]);
+            if (before.dot(after) <= 0.0)
+                return true;
+        }
+        return false;
+    };
+
+    while(live_triangles > target_triangle_count && !heap.empty())
+    {
+        SimplifyCollapse collapse = heap.top();
+        heap.pop();
+        int a = collapse.a, b = collapse.b;
+        if (point_removed[a] || point_removed[b] || versions[a] != collapse.version_a || versions[b] != collapse.version_b)
+            continue;
+        if (flips(a, b, collapse.position) || flips(b, a, collapse.position))
+            continue;
+
+        //Merge a into b.
+        positions[b] = collapse.position;
+        quadrics[b].add(quadrics[a]);
+        point_removed[a] = true;
+        versions[b]++;
+        for(int member : members[a])
+            weld[member] = b;
+        members[b].insert(members[b].end(), members[a].begin(), members[a].end());
+        members[a].clear();
+        for(int t : point_triangles[a])
+        {
+            if (triangle_removed[t])
+                continue;
+            int p0 = corner(t, 0), p1 = corner(t, 1), p2 = corner(t, 2);
+            if (p0 == p1 || p1 == p2 || p2 == p0)
+            {
+                triangle_removed[t] = true;
+                live_triangles--;
+            }
+            else
+            {
+                point_triangles[b].push_back(t);
+            }
+        }
+        point_triangles[a].clear();
+        point_triangles[b].erase(std::remove_if(point_triangles[b].begin(), point_triangles[b].end(), [&](int t) { return triangle_removed[t]; }), point_triangles[b].end());
+
+        std::vector<int> neighbours;
+        for(int t : point_triangles[b])
+            for(int n=0; n<3; n++)
+                if (corner(t, n) != b)
+                    neighbours.push_back(corner(t, n));
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for(int neighbour : neighbours)
+            pushCollapse(std::min(b, neighbour), std::max(b, neighbour));
+    }
+
+    //Only keep the vertices that are still used, at the position of their welded point.
+    MeshData::Vertices vertices;
+    MeshData::Indices indices;
+    std::vector<int> remap(source_vertices.size(), -1);
+    indices.reserve(live_triangles * 3);
+    for(int t=0; t<triangle_count; t++)
+    {
+        if (triangle_removed[t])
+            continue;
+        for(int n=0; n<3; n++)
+        {
+            uint32_t index = source_indices[t * 3 + n];
+            if (remap[index] < 0)
+            {
+                remap[index] = int(vertices.size());
+                vertices.push_back(source_vertices[index]);
+                const Vector3d& p = positions[weld[index]];
+                vertices.back().position = Vector3f(float(p.x), float(p.y), float(p.z));
+            }
+            indices.push_back(remap[index]);
+        }
+    }
+    return MeshData::create(std::move(vertices), std::move(indices), mesh.getType(), mesh.getLayout());
+}
+
+}//namespace sp
@@ -269,7 +269,7 @@ std::shared_ptr<MeshData> FbxLoader::load(const string& resource_name)
         }
     }
     
-    return std::make_shared<MeshData>(std::move(vertices), std::move(indices));
+    return std::make_shared<MeshData>(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::PackedNormal);
 }
 
 }//namespace sp
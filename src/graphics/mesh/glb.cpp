@@ -28,7 +28,7 @@ std::shared_ptr<MeshData> GLBLoader::GLBFile::flatMesh() const {
     for(auto& root : roots) {
         addToFlat(vertices, indices, root, transform);
     }
-    return MeshData::create(std::move(vertices), std::move(indices));
+    return MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::PackedNormal);
 }
 
 void GLBLoader::GLBFile::addToFlat(sp::MeshData::Vertices& vertices, sp::MeshData::Indices& indices, const Node& node, Matrix4x4f transform) const {
@@ -164,6 +164,9 @@ void GLBLoader::handleNode(int node_id, GLBFile::Node& node)
                 case 5123:
                     index = buffer[indice_offset*2] | (buffer[indice_offset*2+1] << 8);
                     break;
+                case 5125:
+                    index = buffer[indice_offset*4] | (buffer[indice_offset*4+1] << 8) | (buffer[indice_offset*4+2] << 16) | (buffer[indice_offset*4+3] << 24);
+                    break;
                 }
                 node.indices.push_back(index);
             }
@@ -333,7 +333,7 @@ std::shared_ptr<MeshData> ObjLoader::load(const string& resource_name)
     }
 
     LOG(Info, "Loaded:", resource_name, vertices.size(), "vertices", indices.size() / 3, "triangles");
-    return std::make_shared<MeshData>(std::move(vertices), std::move(indices));
+    return std::make_shared<MeshData>(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::PackedNormal);
 }
 
 
@@ -37,9 +37,9 @@ void MeshBuilder::addQuad(Vector3f p0, Vector3f p1, Vector3f p2, Vector3f p3, Ve
     vertices.emplace_back(p3, normal, sp::Vector2f(1, 0));
 }
 
-std::shared_ptr<MeshData> MeshBuilder::create()
+std::shared_ptr<MeshData> MeshBuilder::create(MeshData::Layout layout)
 {
-    return sp::MeshData::create(std::move(vertices), std::move(indices));
+    return sp::MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Static, layout);
 }
 
 }//namespace sp
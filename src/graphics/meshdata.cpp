@@ -1,8 +1,12 @@
 #include <sp2/graphics/opengl.h>
 #include <sp2/graphics/meshdata.h>
 #include <sp2/graphics/shader.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/logging.h>
+#include <sp2/assert.h>
 #include <limits>
+#include <algorithm>
+#include <cmath>
 #include <string.h>
 #include <stddef.h>
 
@@ -10,77 +14,428 @@ const unsigned int NO_BUFFER = std::numeric_limits<unsigned int>::max();
 
 namespace sp {
 
-MeshData::MeshData(Type type)
-: type(type)
+std::atomic<unsigned int> MeshData::next_id;
+
+//Vertices that can be addressed with 16 bit indices.
+static constexpr size_t max_short_index_vertices = 0x10000;
+//Changed ranges larger than this part of the mesh are uploaded as a whole, orphaning the old buffer instead of writing into it.
+static constexpr size_t max_partial_upload_divider = 2;
+
+MeshData::MeshData(Type type, Layout layout)
+: type(type), layout(layout), id(next_id++)
 {
-    vertices_vbo = NO_BUFFER;
-    indices_vbo = NO_BUFFER;
+    for(auto& buffer : buffers)
+        buffer = Buffers{NO_BUFFER, NO_BUFFER, 0, 0};
+    buffer_index = 0;
+    index_type = GL_UNSIGNED_SHORT;
     dirty = true;
+    dirty_begin = dirty_end = 0;
     revision = 0;
+    updateBounds();
 }
 
-MeshData::MeshData(Vertices&& vertices, Indices&& indices, Type type)
-: MeshData(type)
+MeshData::MeshData(Vertices&& vertices, Indices&& indices, Type type, Layout layout)
+: MeshData(type, layout)
 {
     this->vertices = std::move(vertices);
     this->indices = std::move(indices);
+    updateBounds();
 }
 
 MeshData::~MeshData()
 {
-    if (vertices_vbo != NO_BUFFER)
-        glDeleteBuffers(1, &vertices_vbo);
-    if (indices_vbo != NO_BUFFER)
-        glDeleteBuffers(1, &indices_vbo);
+    for(auto& buffer : buffers)
+    {
+        if (buffer.vertices_vbo != NO_BUFFER)
+        {
+            GLState::forgetBuffer(buffer.vertices_vbo);
+            glDeleteBuffers(1, &buffer.vertices_vbo);
+        }
+        if (buffer.indices_vbo != NO_BUFFER)
+        {
+            GLState::forgetBuffer(buffer.indices_vbo);
+            glDeleteBuffers(1, &buffer.indices_vbo);
+        }
+    }
 }
 
 void MeshData::render()
 {
     if (vertices.size() < 1)
         return;
-    if (vertices_vbo == NO_BUFFER)
+    if (dirty && type == Type::Stream)
+        buffer_index = (buffer_index + 1) % stream_buffer_count;
+    Buffers& buffer = buffers[buffer_index];
+    if (buffer.vertices_vbo == NO_BUFFER)
     {
-        glGenBuffers(1, &vertices_vbo);
-        glGenBuffers(1, &indices_vbo);
+        glGenBuffers(1, &buffer.vertices_vbo);
+        glGenBuffers(1, &buffer.indices_vbo);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vertices_vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_vbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, buffer.vertices_vbo);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indices_vbo);
     if (dirty)
+        upload(buffer);
+    else if (dirty_begin < dirty_end)
+        uploadRange(buffer);
+
+    if (parts.empty())
+    {
+        setVertexAttributes(layout);
+        glDrawElements(GL_TRIANGLES, indices.size(), index_type, nullptr);
+        return;
+    }
+    for(const auto& part : parts)
+    {
+        setVertexAttributes(layout, part.vertex_offset * VertexLayout::get(layout).stride);
+        glDrawElements(GL_TRIANGLES, part.index_count, GL_UNSIGNED_SHORT, reinterpret_cast<void*>(part.index_offset * sizeof(uint16_t)));
+    }
+}
+
+void MeshData::upload(Buffers& buffer)
+{
+    dirty = false;
+    dirty_begin = dirty_end = 0;
+    upload_stats.full_uploads++;
+
+    parts.clear();
+    if (vertices.size() <= max_short_index_vertices)
+    {
+        //Indices are stored as 32 bit, but most meshes fit in 16 bit indices, which take half the memory on the GPU.
+        //Only used on the render thread, so the conversion buffer can be shared by all meshes.
+        static std::vector<uint16_t> short_indices;
+        short_indices.assign(indices.begin(), indices.end());
+        uploadBuffer(GL_ARRAY_BUFFER, buffer.vertices_size, VertexLayout::get(layout).stride * vertices.size(), packVertices(vertices.data(), vertices.size()));
+        uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indices_size, sizeof(uint16_t) * short_indices.size(), short_indices.data());
+        index_type = GL_UNSIGNED_SHORT;
+    }
+    else if (opengl_element_index_uint)
     {
-        int gl_type = GL_STATIC_DRAW;
-        if (type == Type::Dynamic)
-            gl_type = GL_DYNAMIC_DRAW;
+        uploadBuffer(GL_ARRAY_BUFFER, buffer.vertices_size, VertexLayout::get(layout).stride * vertices.size(), packVertices(vertices.data(), vertices.size()));
+        uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indices_size, sizeof(uint32_t) * indices.size(), indices.data());
+        index_type = GL_UNSIGNED_INT;
+    }
+    else
+    {
+        //Without 32 bit indices, split the triangles into parts that use at most 65536 vertices each.
+        //Every part gets a copy of the vertices it uses, so vertices shared between parts are duplicated.
+        Vertices part_vertices;
+        std::vector<uint16_t> part_indices;
+        part_vertices.reserve(vertices.size());
+        part_indices.reserve(indices.size());
+        //Position of each vertex in part_vertices, below the offset of the current part when it is not copied to this part yet.
+        std::vector<int> remap(vertices.size(), -1);
+        Part part{0, 0, 0};
+        for(size_t n=0; n + 2<indices.size(); n+=3)
+        {
+            int new_vertices = 0;
+            for(int corner=0; corner<3; corner++)
+                if (remap[indices[n + corner]] < part.vertex_offset)
+                    new_vertices++;
+            if (part_vertices.size() - part.vertex_offset + new_vertices > max_short_index_vertices)
+            {
+                part.index_count = part_indices.size() - part.index_offset;
+                parts.push_back(part);
+                part.vertex_offset = part_vertices.size();
+                part.index_offset = part_indices.size();
+            }
+            for(int corner=0; corner<3; corner++)
+            {
+                uint32_t index = indices[n + corner];
+                if (remap[index] < part.vertex_offset)
+                {
+                    remap[index] = part_vertices.size();
+                    part_vertices.push_back(vertices[index]);
+                }
+                part_indices.push_back(remap[index] - part.vertex_offset);
+            }
+        }
+        part.index_count = part_indices.size() - part.index_offset;
+        parts.push_back(part);
 
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), gl_type);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * indices.size(), indices.data(), gl_type);
-        dirty = false;
+        uploadBuffer(GL_ARRAY_BUFFER, buffer.vertices_size, VertexLayout::get(layout).stride * part_vertices.size(), packVertices(part_vertices.data(), part_vertices.size()));
+        uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.indices_size, sizeof(uint16_t) * part_indices.size(), part_indices.data());
+        index_type = GL_UNSIGNED_SHORT;
     }
+}
 
-    if (Shader::bound_shader)
+void MeshData::uploadRange(Buffers& buffer)
+{
+    size_t stride = VertexLayout::get(layout).stride;
+    size_t count = dirty_end - dirty_begin;
+    glBufferSubData(GL_ARRAY_BUFFER, dirty_begin * stride, count * stride, packVertices(vertices.data() + dirty_begin, count));
+    upload_stats.bytes += count * stride;
+    upload_stats.partial_uploads++;
+    dirty_begin = dirty_end = 0;
+}
+
+void MeshData::uploadBuffer(unsigned int target, size_t& allocated_size, size_t size, const void* data)
+{
+    upload_stats.bytes += size;
+    int gl_type = GL_STATIC_DRAW;
+    if (type == Type::Dynamic)
+        gl_type = GL_DYNAMIC_DRAW;
+    else if (type == Type::Stream)
+        gl_type = GL_STREAM_DRAW;
+    //Orphan the old storage when the new data fits in it, so the driver can hand out fresh memory
+    //without waiting for draws that still use the old contents, and without reallocating when the size changes a bit.
+    if (type != Type::Static && size <= allocated_size && size * 2 >= allocated_size)
     {
-        if (Shader::bound_shader->vertex_attribute != -1)
-            glVertexAttribPointer(Shader::bound_shader->vertex_attribute, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, position));
-        if (Shader::bound_shader->normal_attribute != -1)
-            glVertexAttribPointer(Shader::bound_shader->normal_attribute, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-        if (Shader::bound_shader->uv_attribute != -1)
-            glVertexAttribPointer(Shader::bound_shader->uv_attribute, 2, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+        glBufferData(target, allocated_size, nullptr, gl_type);
+        glBufferSubData(target, 0, size, data);
+        return;
     }
+    glBufferData(target, size, data, gl_type);
+    allocated_size = size;
+}
 
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_SHORT, nullptr);
+const void* MeshData::packVertices(const Vertex* source, size_t count)
+{
+    static_assert(sizeof(Vertex) == 36, "The full layout uploads the vertices as they are stored");
+    if (layout == Layout::Full)
+        return source;
+    //Only used on the render thread, so the packing buffer can be shared by all meshes.
+    static std::vector<uint8_t> packed;
+    const VertexLayout& descriptor = VertexLayout::get(layout);
+    packed.resize(descriptor.stride * count);
+    uint8_t* target = packed.data();
+    for(size_t n=0; n<count; n++)
+    {
+        descriptor.pack(source[n], target);
+        target += descriptor.stride;
+    }
+    return packed.data();
 }
 
-void MeshData::update(Vertices&& vertices, Indices&& indices)
+void MeshData::setVertexAttributes(Layout layout, size_t offset)
 {
-    this->vertices = std::move(vertices);
-    this->indices = std::move(indices);
+    Shader* shader = Shader::bound_shader;
+    if (!shader)
+        return;
+    const VertexLayout& descriptor = VertexLayout::get(layout);
+    int locations[4] = {shader->vertex_attribute, shader->normal_attribute, shader->uv_attribute, shader->tile_attribute};
+    int present = 0;
+    for(const auto& element : descriptor.elements)
+    {
+        int location = locations[int(element.attribute)];
+        if (location == -1)
+            continue;
+        present |= 1 << int(element.attribute);
+        glVertexAttribPointer(location, element.components, element.gl_type, element.normalized, descriptor.stride, reinterpret_cast<void*>(offset + element.offset));
+    }
+    //Attributes missing from the layout are read from a constant zero instead of an array, only switched when the previous mesh had a different set.
+    for(int n=0; n<4; n++)
+    {
+        int mask = 1 << n;
+        if (locations[n] == -1 || (present & mask) == (shader->enabled_attributes & mask))
+            continue;
+        if (present & mask)
+        {
+            glEnableVertexAttribArray(locations[n]);
+        }
+        else
+        {
+            glDisableVertexAttribArray(locations[n]);
+            glVertexAttrib4f(locations[n], 0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        shader->enabled_attributes ^= mask;
+    }
+}
+
+const MeshData::VertexLayout& MeshData::VertexLayout::get(Layout layout)
+{
+    static const VertexLayout layouts[] = {
+        //Full
+        {36, {{Attribute::Position, 3, GL_FLOAT, false, 0}, {Attribute::Normal, 3, GL_FLOAT, false, 12}, {Attribute::UV, 2, GL_FLOAT, false, 24}, {Attribute::Tile, 4, GL_UNSIGNED_BYTE, false, 32}}},
+        //Position
+        {12, {{Attribute::Position, 3, GL_FLOAT, false, 0}}},
+        //Position2DUV
+        {16, {{Attribute::Position, 2, GL_FLOAT, false, 0}, {Attribute::UV, 2, GL_FLOAT, false, 8}}},
+        //Position2DUVColor
+        {20, {{Attribute::Position, 2, GL_FLOAT, false, 0}, {Attribute::UV, 2, GL_FLOAT, false, 8}, {Attribute::Normal, 4, GL_UNSIGNED_BYTE, true, 16}}},
+        //PackedNormal, the normal is padded to 4 bytes to keep the uv aligned.
+        {24, {{Attribute::Position, 3, GL_FLOAT, false, 0}, {Attribute::Normal, 4, GL_BYTE, true, 12}, {Attribute::UV, 2, GL_FLOAT, false, 16}}},
+        //PackedNormalUV
+        {20, {{Attribute::Position, 3, GL_FLOAT, false, 0}, {Attribute::Normal, 4, GL_BYTE, true, 12}, {Attribute::UV, 2, GL_UNSIGNED_SHORT, true, 16}}},
+        //PackedNormalTile
+        {28, {{Attribute::Position, 3, GL_FLOAT, false, 0}, {Attribute::Normal, 4, GL_BYTE, true, 12}, {Attribute::UV, 2, GL_FLOAT, false, 16}, {Attribute::Tile, 4, GL_UNSIGNED_BYTE, false, 24}}},
+    };
+    return layouts[int(layout)];
+}
+
+static const float* attributeData(const MeshData::Vertex& vertex, MeshData::VertexLayout::Attribute attribute, int& count)
+{
+    switch(attribute)
+    {
+    case MeshData::VertexLayout::Attribute::Position: count = 3; return &vertex.position.x;
+    case MeshData::VertexLayout::Attribute::Normal: count = 3; return &vertex.normal.x;
+    case MeshData::VertexLayout::Attribute::UV: count = 2; return &vertex.uv.x;
+    case MeshData::VertexLayout::Attribute::Tile: break;
+    }
+    count = 0;
+    return nullptr;
+}
+
+void MeshData::VertexLayout::pack(const Vertex& vertex, uint8_t* target) const
+{
+    for(const auto& element : elements)
+    {
+        uint8_t* output = target + element.offset;
+        //The tile is already stored as bytes.
+        if (element.attribute == Attribute::Tile)
+        {
+            memcpy(output, vertex.tile, sizeof(vertex.tile));
+            continue;
+        }
+        int count;
+        const float* data = attributeData(vertex, element.attribute, count);
+        for(int n=0; n<element.components; n++)
+        {
+            //Padding components are 0, except for the alpha of colors.
+            float f = n < count ? data[n] : (element.gl_type == GL_UNSIGNED_BYTE ? 1.0f : 0.0f);
+            switch(element.gl_type)
+            {
+            case GL_FLOAT:
+                memcpy(output + n * sizeof(float), &f, sizeof(float));
+                break;
+            case GL_BYTE:
+                output[n] = uint8_t(int8_t(std::round(std::min(std::max(f, -1.0f), 1.0f) * 127.0f)));
+                break;
+            case GL_UNSIGNED_BYTE:
+                output[n] = uint8_t(std::round(std::min(std::max(f, 0.0f), 1.0f) * 255.0f));
+                break;
+            case GL_UNSIGNED_SHORT:{
+                uint16_t value = uint16_t(std::round(std::min(std::max(f, 0.0f), 1.0f) * 65535.0f));
+                memcpy(output + n * sizeof(uint16_t), &value, sizeof(value));
+                }break;
+            }
+        }
+    }
+}
+
+MeshData::Vertex MeshData::VertexLayout::unpack(const uint8_t* source) const
+{
+    Vertex vertex(Vector3f(0, 0, 0), Vector3f(0, 0, 0), Vector2f(0, 0));
+    for(const auto& element : elements)
+    {
+        const uint8_t* input = source + element.offset;
+        if (element.attribute == Attribute::Tile)
+        {
+            memcpy(vertex.tile, input, sizeof(vertex.tile));
+            continue;
+        }
+        int count;
+        float* data = const_cast<float*>(attributeData(vertex, element.attribute, count));
+        for(int n=0; n<std::min(count, element.components); n++)
+        {
+            switch(element.gl_type)
+            {
+            case GL_FLOAT:
+                memcpy(&data[n], input + n * sizeof(float), sizeof(float));
+                break;
+            case GL_BYTE:
+                data[n] = std::max(float(int8_t(input[n])) / 127.0f, -1.0f);
+                break;
+            case GL_UNSIGNED_BYTE:
+                data[n] = float(input[n]) / 255.0f;
+                break;
+            case GL_UNSIGNED_SHORT:{
+                uint16_t value;
+                memcpy(&value, input + n * sizeof(uint16_t), sizeof(value));
+                data[n] = float(value) / 65535.0f;
+                }break;
+            }
+        }
+    }
+    return vertex;
+}
+
+void MeshData::update(Vertices&& new_vertices, Indices&& new_indices)
+{
+    if (type != Type::Stream && new_vertices.size() == vertices.size() && new_indices == indices)
+    {
+        //Vertex has no padding, so changed vertices can be found by comparing the memory.
+        size_t first = 0;
+        size_t last = vertices.size();
+        while(first < last && memcmp(&vertices[first], &new_vertices[first], sizeof(Vertex)) == 0)
+            first++;
+        while(last > first && memcmp(&vertices[last - 1], &new_vertices[last - 1], sizeof(Vertex)) == 0)
+            last--;
+        if (first == last)
+            return;
+        vertices.swap(new_vertices);
+        markDirtyRange(first, last);
+        return;
+    }
+    vertices = std::move(new_vertices);
+    indices = std::move(new_indices);
     dirty = true;
     revision++;
+    updateBounds();
+}
+
+void MeshData::updateVertices(size_t first, const Vertices& new_vertices)
+{
+    sp2assert(first + new_vertices.size() <= vertices.size(), "updateVertices cannot change the number of vertices");
+    if (new_vertices.empty())
+        return;
+    std::copy(new_vertices.begin(), new_vertices.end(), vertices.begin() + first);
+    markDirtyRange(first, first + new_vertices.size());
+}
+
+void MeshData::markDirtyRange(size_t first, size_t last)
+{
+    revision++;
+    updateBounds();
+    if (dirty)
+        return;
+    if (dirty_begin < dirty_end)
+    {
+        first = std::min(first, dirty_begin);
+        last = std::max(last, dirty_end);
+    }
+    //Split meshes have their vertices rearranged on the GPU, so they are always uploaded as a whole.
+    if (!parts.empty() || (last - first) * max_partial_upload_divider > vertices.size())
+    {
+        dirty = true;
+        return;
+    }
+    dirty_begin = first;
+    dirty_end = last;
+}
+
+void MeshData::updateBounds()
+{
+    if (vertices.empty())
+    {
+        bounds_min = bounds_max = bounds_center = Vector3f(0, 0, 0);
+        bounds_radius = -1.0f;
+        return;
+    }
+    bounds_min = bounds_max = vertices[0].position;
+    for(const auto& v : vertices)
+    {
+        bounds_min.x = std::min(bounds_min.x, v.position.x);
+        bounds_min.y = std::min(bounds_min.y, v.position.y);
+        bounds_min.z = std::min(bounds_min.z, v.position.z);
+        bounds_max.x = std::max(bounds_max.x, v.position.x);
+        bounds_max.y = std::max(bounds_max.y, v.position.y);
+        bounds_max.z = std::max(bounds_max.z, v.position.z);
+    }
+    //Sphere around the center of the box, with the radius of the furthest vertex, which is tighter than the box corners.
+    bounds_center = (bounds_min + bounds_max) * 0.5f;
+    float radius_squared = 0.0f;
+    for(const auto& v : vertices)
+    {
+        Vector3f d = v.position - bounds_center;
+        radius_squared = std::max(radius_squared, d.dot(d));
+    }
+    bounds_radius = std::sqrt(radius_squared);
 }
 
-std::shared_ptr<MeshData> MeshData::create(Vertices&& vertices, Indices&& indices, Type type)
+std::shared_ptr<MeshData> MeshData::create(Vertices&& vertices, Indices&& indices, Type type, Layout layout)
 {
-    return std::make_shared<MeshData>(std::forward<Vertices>(vertices), std::forward<Indices>(indices), type);
+    return std::make_shared<MeshData>(std::forward<Vertices>(vertices), std::forward<Indices>(indices), type, layout);
 }
 
 std::shared_ptr<MeshData> MeshData::createQuad(Vector2f size, Vector2f uv0, Vector2f uv1)
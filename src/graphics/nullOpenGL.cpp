@@ -0,0 +1,590 @@
+#include <sp2/graphics/nullOpenGL.h>
+#include <sp2/graphics/opengl.h>
+#include <sp2/logging.h>
+#include <cstring>
+#include <map>
+
+namespace sp {
+
+bool NullOpenGL::installed = false;
+bool NullOpenGL::recording = false;
+NullOpenGL::Statistics NullOpenGL::statistics;
+std::vector<NullOpenGL::Command> NullOpenGL::commands;
+
+int NullOpenGL::countCommands(const char* function)
+{
+    int count = 0;
+    for(const auto& command : commands)
+        if (strcmp(command.function, function) == 0)
+            count++;
+    return count;
+}
+
+//Stubs are plain functions, this gives them access to the counters and command stream.
+class NullOpenGLRecorder
+{
+public:
+    template<typename... ARGS> static void record(const char* function, NullOpenGL::Category category, ARGS... args)
+    {
+        NullOpenGL::statistics.calls++;
+        switch(category)
+        {
+        case NullOpenGL::Category::Draw: NullOpenGL::statistics.draw_calls++; break;
+        case NullOpenGL::Category::State: NullOpenGL::statistics.state_changes++; break;
+        case NullOpenGL::Category::Uniform: NullOpenGL::statistics.uniform_uploads++; break;
+        case NullOpenGL::Category::Buffer: NullOpenGL::statistics.buffer_uploads++; break;
+        case NullOpenGL::Category::Texture: NullOpenGL::statistics.texture_uploads++; break;
+        case NullOpenGL::Category::Other: break;
+        }
+        if (NullOpenGL::recording)
+            NullOpenGL::commands.push_back({function, category, {int64_t(args)...}});
+    }
+
+    static NullOpenGL::Statistics& getStatistics() { return NullOpenGL::statistics; }
+};
+
+typedef NullOpenGL::Category Category;
+
+template<typename... ARGS> static void record(const char* function, Category category, ARGS... args)
+{
+    NullOpenGLRecorder::record(function, category, args...);
+}
+
+static NullOpenGL::Statistics& statistics()
+{
+    return NullOpenGLRecorder::getStatistics();
+}
+
+static GLuint next_object_id = 1;
+static std::map<string, GLint> attribute_locations;
+static std::map<string, GLint> uniform_locations;
+
+static void generate(GLsizei n, GLuint* ids)
+{
+    for(GLsizei index=0; index<n; index++)
+        ids[index] = next_object_id++;
+}
+
+//Every name gets its own location, the same in every program.
+static GLint getLocation(std::map<string, GLint>& locations, const GLchar* name)
+{
+    auto it = locations.find(name);
+    if (it != locations.end())
+        return it->second;
+    GLint location = GLint(locations.size());
+    locations[name] = location;
+    return location;
+}
+
+static void emptyString(GLsizei bufsize, GLsizei* length, GLchar* str)
+{
+    if (length)
+        *length = 0;
+    if (str && bufsize > 0)
+        str[0] = '\0';
+}
+
+static int bytesPerPixel(GLenum format, GLenum type)
+{
+    if (type != GL_UNSIGNED_BYTE)
+        return 2;
+    switch(format)
+    {
+    case GL_RGBA: return 4;
+    case GL_RGB: return 3;
+    case GL_LUMINANCE_ALPHA: return 2;
+    default: return 1;
+    }
+}
+
+static void GL_APIENTRY null_glActiveTexture(GLenum texture) { record("glActiveTexture", Category::State, texture); }
+static void GL_APIENTRY null_glAttachShader(GLuint program, GLuint shader) { record("glAttachShader", Category::Other, program, shader); }
+static void GL_APIENTRY null_glBindAttribLocation(GLuint program, GLuint index, const GLchar* /*name*/) { record("glBindAttribLocation", Category::Other, program, index); }
+static void GL_APIENTRY null_glBindBuffer(GLenum target, GLuint buffer) { record("glBindBuffer", Category::State, target, buffer); }
+static void GL_APIENTRY null_glBindFramebuffer(GLenum target, GLuint framebuffer) { record("glBindFramebuffer", Category::State, target, framebuffer); }
+static void GL_APIENTRY null_glBindRenderbuffer(GLenum target, GLuint renderbuffer) { record("glBindRenderbuffer", Category::State, target, renderbuffer); }
+static void GL_APIENTRY null_glBindTexture(GLenum target, GLuint texture) { record("glBindTexture", Category::State, target, texture); }
+static void GL_APIENTRY null_glBlendColor(GLclampf /*red*/, GLclampf /*green*/, GLclampf /*blue*/, GLclampf /*alpha*/) { record("glBlendColor", Category::State); }
+static void GL_APIENTRY null_glBlendEquation(GLenum mode) { record("glBlendEquation", Category::State, mode); }
+static void GL_APIENTRY null_glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha) { record("glBlendEquationSeparate", Category::State, modeRGB, modeAlpha); }
+static void GL_APIENTRY null_glBlendFunc(GLenum sfactor, GLenum dfactor) { record("glBlendFunc", Category::State, sfactor, dfactor); }
+static void GL_APIENTRY null_glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) { record("glBlendFuncSeparate", Category::State, srcRGB, dstRGB, srcAlpha, dstAlpha); }
+
+static void GL_APIENTRY null_glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+    record("glBufferData", Category::Buffer, target, size, usage);
+    //Without data the buffer is only allocated (or orphaned), nothing is transferred.
+    if (data)
+        statistics().buffer_bytes += size;
+}
+
+static void GL_APIENTRY null_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* /*data*/)
+{
+    record("glBufferSubData", Category::Buffer, target, offset, size);
+    statistics().buffer_bytes += size;
+}
+
+static GLenum GL_APIENTRY null_glCheckFramebufferStatus(GLenum target)
+{
+    record("glCheckFramebufferStatus", Category::Other, target);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void GL_APIENTRY null_glClear(GLbitfield mask) { record("glClear", Category::Other, mask); }
+static void GL_APIENTRY null_glClearColor(GLclampf /*red*/, GLclampf /*green*/, GLclampf /*blue*/, GLclampf /*alpha*/) { record("glClearColor", Category::State); }
+static void GL_APIENTRY null_glClearDepthf(GLclampf /*depth*/) { record("glClearDepthf", Category::State); }
+static void GL_APIENTRY null_glClearStencil(GLint s) { record("glClearStencil", Category::State, s); }
+static void GL_APIENTRY null_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) { record("glColorMask", Category::State, red, green, blue, alpha); }
+static void GL_APIENTRY null_glCompileShader(GLuint shader) { record("glCompileShader", Category::Other, shader); }
+
+static void GL_APIENTRY null_glCompressedTexImage2D(GLenum target, GLint /*level*/, GLenum /*internalformat*/, GLsizei width, GLsizei height, GLint /*border*/, GLsizei imageSize, const GLvoid* /*data*/)
+{
+    record("glCompressedTexImage2D", Category::Texture, target, width, height, imageSize);
+    statistics().texture_bytes += imageSize;
+}
+
+static void GL_APIENTRY null_glCompressedTexSubImage2D(GLenum target, GLint /*level*/, GLint /*xoffset*/, GLint /*yoffset*/, GLsizei width, GLsizei height, GLenum /*format*/, GLsizei imageSize, const GLvoid* /*data*/)
+{
+    record("glCompressedTexSubImage2D", Category::Texture, target, width, height, imageSize);
+    statistics().texture_bytes += imageSize;
+}
+
+static void GL_APIENTRY null_glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint /*y*/, GLsizei /*width*/, GLsizei /*height*/, GLint /*border*/) { record("glCopyTexImage2D", Category::Other, target, level, internalformat, x); }
+static void GL_APIENTRY null_glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint /*x*/, GLint /*y*/, GLsizei /*width*/, GLsizei /*height*/) { record("glCopyTexSubImage2D", Category::Other, target, level, xoffset, yoffset); }
+
+static GLuint GL_APIENTRY null_glCreateProgram(void)
+{
+    record("glCreateProgram", Category::Other);
+    return next_object_id++;
+}
+
+static GLuint GL_APIENTRY null_glCreateShader(GLenum type)
+{
+    record("glCreateShader", Category::Other, type);
+    return next_object_id++;
+}
+
+static void GL_APIENTRY null_glCullFace(GLenum mode) { record("glCullFace", Category::State, mode); }
+static void GL_APIENTRY null_glDeleteBuffers(GLsizei n, const GLuint* /*buffers*/) { record("glDeleteBuffers", Category::Other, n); }
+static void GL_APIENTRY null_glDeleteFramebuffers(GLsizei n, const GLuint* /*framebuffers*/) { record("glDeleteFramebuffers", Category::Other, n); }
+static void GL_APIENTRY null_glDeleteProgram(GLuint program) { record("glDeleteProgram", Category::Other, program); }
+static void GL_APIENTRY null_glDeleteRenderbuffers(GLsizei n, const GLuint* /*renderbuffers*/) { record("glDeleteRenderbuffers", Category::Other, n); }
+static void GL_APIENTRY null_glDeleteShader(GLuint shader) { record("glDeleteShader", Category::Other, shader); }
+static void GL_APIENTRY null_glDeleteTextures(GLsizei n, const GLuint* /*textures*/) { record("glDeleteTextures", Category::Other, n); }
+static void GL_APIENTRY null_glDepthFunc(GLenum func) { record("glDepthFunc", Category::State, func); }
+static void GL_APIENTRY null_glDepthMask(GLboolean flag) { record("glDepthMask", Category::State, flag); }
+static void GL_APIENTRY null_glDepthRangef(GLclampf /*zNear*/, GLclampf /*zFar*/) { record("glDepthRangef", Category::State); }
+static void GL_APIENTRY null_glDetachShader(GLuint program, GLuint shader) { record("glDetachShader", Category::Other, program, shader); }
+static void GL_APIENTRY null_glDisable(GLenum cap) { record("glDisable", Category::State, cap); }
+static void GL_APIENTRY null_glDisableVertexAttribArray(GLuint index) { record("glDisableVertexAttribArray", Category::State, index); }
+
+static void GL_APIENTRY null_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    record("glDrawArrays", Category::Draw, mode, first, count);
+    statistics().vertices += count;
+}
+
+static void GL_APIENTRY null_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* /*indices*/)
+{
+    record("glDrawElements", Category::Draw, mode, count, type);
+    statistics().vertices += count;
+}
+
+static void GL_APIENTRY null_glEnable(GLenum cap) { record("glEnable", Category::State, cap); }
+static void GL_APIENTRY null_glEnableVertexAttribArray(GLuint index) { record("glEnableVertexAttribArray", Category::State, index); }
+static void GL_APIENTRY null_glFinish(void) { record("glFinish", Category::Other); }
+static void GL_APIENTRY null_glFlush(void) { record("glFlush", Category::Other); }
+static void GL_APIENTRY null_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) { record("glFramebufferRenderbuffer", Category::Other, target, attachment, renderbuffertarget, renderbuffer); }
+static void GL_APIENTRY null_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint /*level*/) { record("glFramebufferTexture2D", Category::Other, target, attachment, textarget, texture); }
+static void GL_APIENTRY null_glFrontFace(GLenum mode) { record("glFrontFace", Category::State, mode); }
+
+static void GL_APIENTRY null_glGenBuffers(GLsizei n, GLuint* buffers)
+{
+    record("glGenBuffers", Category::Other, n);
+    generate(n, buffers);
+}
+
+static void GL_APIENTRY null_glGenerateMipmap(GLenum target) { record("glGenerateMipmap", Category::Other, target); }
+
+static void GL_APIENTRY null_glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    record("glGenFramebuffers", Category::Other, n);
+    generate(n, framebuffers);
+}
+
+static void GL_APIENTRY null_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+    record("glGenRenderbuffers", Category::Other, n);
+    generate(n, renderbuffers);
+}
+
+static void GL_APIENTRY null_glGenTextures(GLsizei n, GLuint* textures)
+{
+    record("glGenTextures", Category::Other, n);
+    generate(n, textures);
+}
+
+static void GL_APIENTRY null_glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufsize, GLsizei* length, GLint* /*size*/, GLenum* /*type*/, GLchar* name)
+{
+    record("glGetActiveAttrib", Category::Other, program, index, bufsize);
+    emptyString(bufsize, length, name);
+}
+
+static void GL_APIENTRY null_glGetActiveUniform(GLuint program, GLuint index, GLsizei bufsize, GLsizei* length, GLint* /*size*/, GLenum* /*type*/, GLchar* name)
+{
+    record("glGetActiveUniform", Category::Other, program, index, bufsize);
+    emptyString(bufsize, length, name);
+}
+
+static void GL_APIENTRY null_glGetAttachedShaders(GLuint program, GLsizei maxcount, GLsizei* /*count*/, GLuint* /*shaders*/) { record("glGetAttachedShaders", Category::Other, program, maxcount); }
+
+static GLint GL_APIENTRY null_glGetAttribLocation(GLuint program, const GLchar* name)
+{
+    record("glGetAttribLocation", Category::Other, program);
+    return getLocation(attribute_locations, name);
+}
+
+static void GL_APIENTRY null_glGetBooleanv(GLenum pname, GLboolean* params)
+{
+    record("glGetBooleanv", Category::Other, pname);
+    *params = GL_FALSE;
+}
+
+static void GL_APIENTRY null_glGetBufferParameteriv(GLenum target, GLenum pname, GLint* /*params*/) { record("glGetBufferParameteriv", Category::Other, target, pname); }
+static GLenum GL_APIENTRY null_glGetError(void) { return GL_NO_ERROR; }
+
+static void GL_APIENTRY null_glGetFloatv(GLenum pname, GLfloat* params)
+{
+    record("glGetFloatv", Category::Other, pname);
+    *params = 0.0f;
+}
+
+static void GL_APIENTRY null_glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint* /*params*/) { record("glGetFramebufferAttachmentParameteriv", Category::Other, target, attachment, pname); }
+
+static void GL_APIENTRY null_glGetIntegerv(GLenum pname, GLint* params)
+{
+    record("glGetIntegerv", Category::Other, pname);
+    *params = 0;
+}
+
+static void GL_APIENTRY null_glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    record("glGetProgramiv", Category::Other, program, pname);
+    //Report success for link and validate status, and empty logs.
+    *params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+
+static void GL_APIENTRY null_glGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+    record("glGetProgramInfoLog", Category::Other, program);
+    emptyString(bufsize, length, infolog);
+}
+
+static void GL_APIENTRY null_glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint* /*params*/) { record("glGetRenderbufferParameteriv", Category::Other, target, pname); }
+
+static void GL_APIENTRY null_glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    record("glGetShaderiv", Category::Other, shader, pname);
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void GL_APIENTRY null_glGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+    record("glGetShaderInfoLog", Category::Other, shader);
+    emptyString(bufsize, length, infolog);
+}
+
+static void GL_APIENTRY null_glGetShaderPrecisionFormat(GLenum shadertype, GLenum precisiontype, GLint* /*range*/, GLint* /*precision*/) { record("glGetShaderPrecisionFormat", Category::Other, shadertype, precisiontype); }
+
+static void GL_APIENTRY null_glGetShaderSource(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* source)
+{
+    record("glGetShaderSource", Category::Other, shader);
+    emptyString(bufsize, length, source);
+}
+
+static const GLubyte* GL_APIENTRY null_glGetString(GLenum name)
+{
+    record("glGetString", Category::Other, name);
+    return reinterpret_cast<const GLubyte*>("NullOpenGL");
+}
+
+static void GL_APIENTRY null_glGetTexParameterfv(GLenum target, GLenum pname, GLfloat* /*params*/) { record("glGetTexParameterfv", Category::Other, target, pname); }
+static void GL_APIENTRY null_glGetTexParameteriv(GLenum target, GLenum pname, GLint* /*params*/) { record("glGetTexParameteriv", Category::Other, target, pname); }
+static void GL_APIENTRY null_glGetUniformfv(GLuint program, GLint location, GLfloat* /*params*/) { record("glGetUniformfv", Category::Other, program, location); }
+static void GL_APIENTRY null_glGetUniformiv(GLuint program, GLint location, GLint* /*params*/) { record("glGetUniformiv", Category::Other, program, location); }
+
+static GLint GL_APIENTRY null_glGetUniformLocation(GLuint program, const GLchar* name)
+{
+    record("glGetUniformLocation", Category::Other, program);
+    return getLocation(uniform_locations, name);
+}
+
+static void GL_APIENTRY null_glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat* /*params*/) { record("glGetVertexAttribfv", Category::Other, index, pname); }
+static void GL_APIENTRY null_glGetVertexAttribiv(GLuint index, GLenum pname, GLint* /*params*/) { record("glGetVertexAttribiv", Category::Other, index, pname); }
+static void GL_APIENTRY null_glGetVertexAttribPointerv(GLuint index, GLenum pname, GLvoid** /*pointer*/) { record("glGetVertexAttribPointerv", Category::Other, index, pname); }
+static void GL_APIENTRY null_glHint(GLenum target, GLenum mode) { record("glHint", Category::State, target, mode); }
+
+static GLboolean GL_APIENTRY null_glIsBuffer(GLuint buffer)
+{
+    record("glIsBuffer", Category::Other, buffer);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsEnabled(GLenum cap)
+{
+    record("glIsEnabled", Category::Other, cap);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsFramebuffer(GLuint framebuffer)
+{
+    record("glIsFramebuffer", Category::Other, framebuffer);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsProgram(GLuint program)
+{
+    record("glIsProgram", Category::Other, program);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsRenderbuffer(GLuint renderbuffer)
+{
+    record("glIsRenderbuffer", Category::Other, renderbuffer);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsShader(GLuint shader)
+{
+    record("glIsShader", Category::Other, shader);
+    return GL_TRUE;
+}
+
+static GLboolean GL_APIENTRY null_glIsTexture(GLuint texture)
+{
+    record("glIsTexture", Category::Other, texture);
+    return GL_TRUE;
+}
+
+static void GL_APIENTRY null_glLineWidth(GLfloat /*width*/) { record("glLineWidth", Category::State); }
+static void GL_APIENTRY null_glLinkProgram(GLuint program) { record("glLinkProgram", Category::Other, program); }
+static void GL_APIENTRY null_glPixelStorei(GLenum pname, GLint param) { record("glPixelStorei", Category::State, pname, param); }
+static void GL_APIENTRY null_glPolygonOffset(GLfloat /*factor*/, GLfloat /*units*/) { record("glPolygonOffset", Category::State); }
+static void GL_APIENTRY null_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum /*format*/, GLenum /*type*/, GLvoid* /*pixels*/) { record("glReadPixels", Category::Other, x, y, width, height); }
+static void GL_APIENTRY null_glReleaseShaderCompiler(void) { record("glReleaseShaderCompiler", Category::Other); }
+static void GL_APIENTRY null_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) { record("glRenderbufferStorage", Category::Other, target, internalformat, width, height); }
+static void GL_APIENTRY null_glSampleCoverage(GLclampf /*value*/, GLboolean invert) { record("glSampleCoverage", Category::State, invert); }
+static void GL_APIENTRY null_glScissor(GLint x, GLint y, GLsizei width, GLsizei height) { record("glScissor", Category::State, x, y, width, height); }
+static void GL_APIENTRY null_glShaderBinary(GLsizei n, const GLuint* /*shaders*/, GLenum binaryformat, const GLvoid* /*binary*/, GLsizei length) { record("glShaderBinary", Category::Other, n, binaryformat, length); }
+static void GL_APIENTRY null_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* /*string*/, const GLint* /*length*/) { record("glShaderSource", Category::Other, shader, count); }
+static void GL_APIENTRY null_glStencilFunc(GLenum func, GLint ref, GLuint mask) { record("glStencilFunc", Category::State, func, ref, mask); }
+static void GL_APIENTRY null_glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask) { record("glStencilFuncSeparate", Category::State, face, func, ref, mask); }
+static void GL_APIENTRY null_glStencilMask(GLuint mask) { record("glStencilMask", Category::State, mask); }
+static void GL_APIENTRY null_glStencilMaskSeparate(GLenum face, GLuint mask) { record("glStencilMaskSeparate", Category::State, face, mask); }
+static void GL_APIENTRY null_glStencilOp(GLenum fail, GLenum zfail, GLenum zpass) { record("glStencilOp", Category::State, fail, zfail, zpass); }
+static void GL_APIENTRY null_glStencilOpSeparate(GLenum face, GLenum fail, GLenum zfail, GLenum zpass) { record("glStencilOpSeparate", Category::State, face, fail, zfail, zpass); }
+
+static void GL_APIENTRY null_glTexImage2D(GLenum target, GLint /*level*/, GLint /*internalformat*/, GLsizei width, GLsizei height, GLint /*border*/, GLenum format, GLenum type, const GLvoid* pixels)
+{
+    record("glTexImage2D", Category::Texture, target, width, height, format);
+    if (pixels)
+        statistics().texture_bytes += int64_t(width) * height * bytesPerPixel(format, type);
+}
+
+static void GL_APIENTRY null_glTexParameterf(GLenum target, GLenum pname, GLfloat /*param*/) { record("glTexParameterf", Category::State, target, pname); }
+static void GL_APIENTRY null_glTexParameterfv(GLenum target, GLenum pname, const GLfloat* /*params*/) { record("glTexParameterfv", Category::State, target, pname); }
+static void GL_APIENTRY null_glTexParameteri(GLenum target, GLenum pname, GLint param) { record("glTexParameteri", Category::State, target, pname, param); }
+static void GL_APIENTRY null_glTexParameteriv(GLenum target, GLenum pname, const GLint* /*params*/) { record("glTexParameteriv", Category::State, target, pname); }
+
+static void GL_APIENTRY null_glTexSubImage2D(GLenum target, GLint /*level*/, GLint /*xoffset*/, GLint /*yoffset*/, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* /*pixels*/)
+{
+    record("glTexSubImage2D", Category::Texture, target, width, height, format);
+    statistics().texture_bytes += int64_t(width) * height * bytesPerPixel(format, type);
+}
+
+static void GL_APIENTRY null_glUniform1f(GLint location, GLfloat /*x*/) { record("glUniform1f", Category::Uniform, location); }
+static void GL_APIENTRY null_glUniform1fv(GLint location, GLsizei count, const GLfloat* /*v*/) { record("glUniform1fv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform1i(GLint location, GLint x) { record("glUniform1i", Category::Uniform, location, x); }
+static void GL_APIENTRY null_glUniform1iv(GLint location, GLsizei count, const GLint* /*v*/) { record("glUniform1iv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform2f(GLint location, GLfloat /*x*/, GLfloat /*y*/) { record("glUniform2f", Category::Uniform, location); }
+static void GL_APIENTRY null_glUniform2fv(GLint location, GLsizei count, const GLfloat* /*v*/) { record("glUniform2fv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform2i(GLint location, GLint x, GLint y) { record("glUniform2i", Category::Uniform, location, x, y); }
+static void GL_APIENTRY null_glUniform2iv(GLint location, GLsizei count, const GLint* /*v*/) { record("glUniform2iv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform3f(GLint location, GLfloat /*x*/, GLfloat /*y*/, GLfloat /*z*/) { record("glUniform3f", Category::Uniform, location); }
+static void GL_APIENTRY null_glUniform3fv(GLint location, GLsizei count, const GLfloat* /*v*/) { record("glUniform3fv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform3i(GLint location, GLint x, GLint y, GLint z) { record("glUniform3i", Category::Uniform, location, x, y, z); }
+static void GL_APIENTRY null_glUniform3iv(GLint location, GLsizei count, const GLint* /*v*/) { record("glUniform3iv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform4f(GLint location, GLfloat /*x*/, GLfloat /*y*/, GLfloat /*z*/, GLfloat /*w*/) { record("glUniform4f", Category::Uniform, location); }
+static void GL_APIENTRY null_glUniform4fv(GLint location, GLsizei count, const GLfloat* /*v*/) { record("glUniform4fv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniform4i(GLint location, GLint x, GLint y, GLint z, GLint /*w*/) { record("glUniform4i", Category::Uniform, location, x, y, z); }
+static void GL_APIENTRY null_glUniform4iv(GLint location, GLsizei count, const GLint* /*v*/) { record("glUniform4iv", Category::Uniform, location, count); }
+static void GL_APIENTRY null_glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* /*value*/) { record("glUniformMatrix2fv", Category::Uniform, location, count, transpose); }
+static void GL_APIENTRY null_glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* /*value*/) { record("glUniformMatrix3fv", Category::Uniform, location, count, transpose); }
+static void GL_APIENTRY null_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* /*value*/) { record("glUniformMatrix4fv", Category::Uniform, location, count, transpose); }
+static void GL_APIENTRY null_glUseProgram(GLuint program) { record("glUseProgram", Category::State, program); }
+static void GL_APIENTRY null_glValidateProgram(GLuint program) { record("glValidateProgram", Category::Other, program); }
+static void GL_APIENTRY null_glVertexAttrib1f(GLuint indx, GLfloat /*x*/) { record("glVertexAttrib1f", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib1fv(GLuint indx, const GLfloat* /*values*/) { record("glVertexAttrib1fv", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib2f(GLuint indx, GLfloat /*x*/, GLfloat /*y*/) { record("glVertexAttrib2f", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib2fv(GLuint indx, const GLfloat* /*values*/) { record("glVertexAttrib2fv", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib3f(GLuint indx, GLfloat /*x*/, GLfloat /*y*/, GLfloat /*z*/) { record("glVertexAttrib3f", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib3fv(GLuint indx, const GLfloat* /*values*/) { record("glVertexAttrib3fv", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib4f(GLuint indx, GLfloat /*x*/, GLfloat /*y*/, GLfloat /*z*/, GLfloat /*w*/) { record("glVertexAttrib4f", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttrib4fv(GLuint indx, const GLfloat* /*values*/) { record("glVertexAttrib4fv", Category::State, indx); }
+static void GL_APIENTRY null_glVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalized, GLsizei /*stride*/, const GLvoid* /*ptr*/) { record("glVertexAttribPointer", Category::State, indx, size, type, normalized); }
+static void GL_APIENTRY null_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) { record("glViewport", Category::State, x, y, width, height); }
+static void GL_APIENTRY null_glDrawBuffers(GLsizei n, const GLenum * /*bufs*/) { record("glDrawBuffers", Category::State, n); }
+
+void NullOpenGL::install()
+{
+    if (installed)
+        return;
+    installed = true;
+    LOG(Info, "Using null OpenGL, nothing will be rendered.");
+
+    glActiveTexture = null_glActiveTexture;
+    glAttachShader = null_glAttachShader;
+    glBindAttribLocation = null_glBindAttribLocation;
+    glBindBuffer = null_glBindBuffer;
+    glBindFramebuffer = null_glBindFramebuffer;
+    glBindRenderbuffer = null_glBindRenderbuffer;
+    glBindTexture = null_glBindTexture;
+    glBlendColor = null_glBlendColor;
+    glBlendEquation = null_glBlendEquation;
+    glBlendEquationSeparate = null_glBlendEquationSeparate;
+    glBlendFunc = null_glBlendFunc;
+    glBlendFuncSeparate = null_glBlendFuncSeparate;
+    glBufferData = null_glBufferData;
+    glBufferSubData = null_glBufferSubData;
+    glCheckFramebufferStatus = null_glCheckFramebufferStatus;
+    glClear = null_glClear;
+    glClearColor = null_glClearColor;
+    glClearDepthf = null_glClearDepthf;
+    glClearStencil = null_glClearStencil;
+    glColorMask = null_glColorMask;
+    glCompileShader = null_glCompileShader;
+    glCompressedTexImage2D = null_glCompressedTexImage2D;
+    glCompressedTexSubImage2D = null_glCompressedTexSubImage2D;
+    glCopyTexImage2D = null_glCopyTexImage2D;
+    glCopyTexSubImage2D = null_glCopyTexSubImage2D;
+    glCreateProgram = null_glCreateProgram;
+    glCreateShader = null_glCreateShader;
+    glCullFace = null_glCullFace;
+    glDeleteBuffers = null_glDeleteBuffers;
+    glDeleteFramebuffers = null_glDeleteFramebuffers;
+    glDeleteProgram = null_glDeleteProgram;
+    glDeleteRenderbuffers = null_glDeleteRenderbuffers;
+    glDeleteShader = null_glDeleteShader;
+    glDeleteTextures = null_glDeleteTextures;
+    glDepthFunc = null_glDepthFunc;
+    glDepthMask = null_glDepthMask;
+    glDepthRangef = null_glDepthRangef;
+    glDetachShader = null_glDetachShader;
+    glDisable = null_glDisable;
+    glDisableVertexAttribArray = null_glDisableVertexAttribArray;
+    glDrawArrays = null_glDrawArrays;
+    glDrawElements = null_glDrawElements;
+    glEnable = null_glEnable;
+    glEnableVertexAttribArray = null_glEnableVertexAttribArray;
+    glFinish = null_glFinish;
+    glFlush = null_glFlush;
+    glFramebufferRenderbuffer = null_glFramebufferRenderbuffer;
+    glFramebufferTexture2D = null_glFramebufferTexture2D;
+    glFrontFace = null_glFrontFace;
+    glGenBuffers = null_glGenBuffers;
+    glGenerateMipmap = null_glGenerateMipmap;
+    glGenFramebuffers = null_glGenFramebuffers;
+    glGenRenderbuffers = null_glGenRenderbuffers;
+    glGenTextures = null_glGenTextures;
+    glGetActiveAttrib = null_glGetActiveAttrib;
+    glGetActiveUniform = null_glGetActiveUniform;
+    glGetAttachedShaders = null_glGetAttachedShaders;
+    glGetAttribLocation = null_glGetAttribLocation;
+    glGetBooleanv = null_glGetBooleanv;
+    glGetBufferParameteriv = null_glGetBufferParameteriv;
+    glGetError = null_glGetError;
+    glGetFloatv = null_glGetFloatv;
+    glGetFramebufferAttachmentParameteriv = null_glGetFramebufferAttachmentParameteriv;
+    glGetIntegerv = null_glGetIntegerv;
+    glGetProgramiv = null_glGetProgramiv;
+    glGetProgramInfoLog = null_glGetProgramInfoLog;
+    glGetRenderbufferParameteriv = null_glGetRenderbufferParameteriv;
+    glGetShaderiv = null_glGetShaderiv;
+    glGetShaderInfoLog = null_glGetShaderInfoLog;
+    glGetShaderPrecisionFormat = null_glGetShaderPrecisionFormat;
+    glGetShaderSource = null_glGetShaderSource;
+    glGetString = null_glGetString;
+    glGetTexParameterfv = null_glGetTexParameterfv;
+    glGetTexParameteriv = null_glGetTexParameteriv;
+    glGetUniformfv = null_glGetUniformfv;
+    glGetUniformiv = null_glGetUniformiv;
+    glGetUniformLocation = null_glGetUniformLocation;
+    glGetVertexAttribfv = null_glGetVertexAttribfv;
+    glGetVertexAttribiv = null_glGetVertexAttribiv;
+    glGetVertexAttribPointerv = null_glGetVertexAttribPointerv;
+    glHint = null_glHint;
+    glIsBuffer = null_glIsBuffer;
+    glIsEnabled = null_glIsEnabled;
+    glIsFramebuffer = null_glIsFramebuffer;
+    glIsProgram = null_glIsProgram;
+    glIsRenderbuffer = null_glIsRenderbuffer;
+    glIsShader = null_glIsShader;
+    glIsTexture = null_glIsTexture;
+    glLineWidth = null_glLineWidth;
+    glLinkProgram = null_glLinkProgram;
+    glPixelStorei = null_glPixelStorei;
+    glPolygonOffset = null_glPolygonOffset;
+    glReadPixels = null_glReadPixels;
+    glReleaseShaderCompiler = null_glReleaseShaderCompiler;
+    glRenderbufferStorage = null_glRenderbufferStorage;
+    glSampleCoverage = null_glSampleCoverage;
+    glScissor = null_glScissor;
+    glShaderBinary = null_glShaderBinary;
+    glShaderSource = null_glShaderSource;
+    glStencilFunc = null_glStencilFunc;
+    glStencilFuncSeparate = null_glStencilFuncSeparate;
+    glStencilMask = null_glStencilMask;
+    glStencilMaskSeparate = null_glStencilMaskSeparate;
+    glStencilOp = null_glStencilOp;
+    glStencilOpSeparate = null_glStencilOpSeparate;
+    glTexImage2D = null_glTexImage2D;
+    glTexParameterf = null_glTexParameterf;
+    glTexParameterfv = null_glTexParameterfv;
+    glTexParameteri = null_glTexParameteri;
+    glTexParameteriv = null_glTexParameteriv;
+    glTexSubImage2D = null_glTexSubImage2D;
+    glUniform1f = null_glUniform1f;
+    glUniform1fv = null_glUniform1fv;
+    glUniform1i = null_glUniform1i;
+    glUniform1iv = null_glUniform1iv;
+    glUniform2f = null_glUniform2f;
+    glUniform2fv = null_glUniform2fv;
+    glUniform2i = null_glUniform2i;
+    glUniform2iv = null_glUniform2iv;
+    glUniform3f = null_glUniform3f;
+    glUniform3fv = null_glUniform3fv;
+    glUniform3i = null_glUniform3i;
+    glUniform3iv = null_glUniform3iv;
+    glUniform4f = null_glUniform4f;
+    glUniform4fv = null_glUniform4fv;
+    glUniform4i = null_glUniform4i;
+    glUniform4iv = null_glUniform4iv;
+    glUniformMatrix2fv = null_glUniformMatrix2fv;
+    glUniformMatrix3fv = null_glUniformMatrix3fv;
+    glUniformMatrix4fv = null_glUniformMatrix4fv;
+    glUseProgram = null_glUseProgram;
+    glValidateProgram = null_glValidateProgram;
+    glVertexAttrib1f = null_glVertexAttrib1f;
+    glVertexAttrib1fv = null_glVertexAttrib1fv;
+    glVertexAttrib2f = null_glVertexAttrib2f;
+    glVertexAttrib2fv = null_glVertexAttrib2fv;
+    glVertexAttrib3f = null_glVertexAttrib3f;
+    glVertexAttrib3fv = null_glVertexAttrib3fv;
+    glVertexAttrib4f = null_glVertexAttrib4f;
+    glVertexAttrib4fv = null_glVertexAttrib4fv;
+    glVertexAttribPointer = null_glVertexAttribPointer;
+    glViewport = null_glViewport;
+    glDrawBuffers = null_glDrawBuffers;
+}
+
+}//namespace sp
@@ -1,4 +1,5 @@
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/nullOpenGL.h>
 #include <sp2/logging.h>
 #include <SDL_video.h>
 
@@ -156,11 +157,18 @@ void (GL_APIENTRY * glDrawBuffers)(GLsizei n, const GLenum *bufs);
 
 namespace sp {
 
+bool opengl_element_index_uint = false;
+
 void initOpenGL()
 {
     if (init_done)
         return;
     init_done = true;
+#ifdef SP2_NULL_OPENGL
+    NullOpenGL::install();
+    opengl_element_index_uint = true;
+    return;
+#endif
     bool failure = false;
 
 #ifdef SP2_GRAPHICS_OPENGLES2_H
@@ -315,6 +323,12 @@ void initOpenGL()
 
     if (failure)
         exit(1);
+
+#if defined(ANDROID) || defined(__EMSCRIPTEN__)
+    opengl_element_index_uint = SDL_GL_ExtensionSupported("GL_OES_element_index_uint");
+#else
+    opengl_element_index_uint = true;
+#endif
 }
 
 }//namespace sp
@@ -1,6 +1,7 @@
 #include <sp2/graphics/renderTexture.h>
 #include <sp2/graphics/textureManager.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 
 
 namespace sp {
@@ -38,6 +39,7 @@ RenderTexture::~RenderTexture()
         for(int n=0;n<count; n++) {
             for(auto ptr : color_buffer[n]) {
                 glDeleteTextures(1, &ptr->handle);
+                GLState::forgetTexture(ptr->handle);
                 delete ptr;
             }
         }
@@ -63,7 +65,7 @@ void RenderTexture::create()
         glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer[n]);
 
         for(int idx=0; idx<texture_count; idx++) {
-            glBindTexture(GL_TEXTURE_2D, color_buffer[n][idx]->handle);
+            GLState::bindTexture(GL_TEXTURE_2D, color_buffer[n][idx]->handle);
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
@@ -89,7 +91,7 @@ void RenderTexture::create()
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void RenderTexture::bind()
@@ -171,7 +173,7 @@ RenderTexture::ColorTexture::~ColorTexture()
 
 void RenderTexture::ColorTexture::bind()
 {
-    glBindTexture(GL_TEXTURE_2D, handle);
+    GLState::bindTexture(GL_TEXTURE_2D, handle);
 }
 
 
@@ -2,7 +2,9 @@
 #include <sp2/scene/scene.h>
 #include <sp2/scene/node.h>
 #include <sp2/scene/camera.h>
+#include <sp2/graphics/lodChain.h>
 #include <sp2/logging.h>
+#include <limits>
 
 namespace sp {
 
@@ -26,6 +28,7 @@ void BasicNodeRenderPass::addCamera(P<Camera> camera)
 
 void BasicNodeRenderPass::render(RenderQueue& queue)
 {
+    culling_stats = CullingStats();
     if (!cameras.empty())
     {
         for(P<Camera> camera : cameras)
@@ -193,17 +196,217 @@ void BasicNodeRenderPass::renderScene(RenderQueue& queue, P<Scene> scene, P<Came
     if (scene->isEnabled(Scene::FlagEnableRender) && camera)
     {
         queue.setCamera(camera);
-        recursiveNodeRender(queue, scene->getRoot());
+        view_projection = camera->getProjectionMatrix() * camera->getGlobalTransform().inverse();
+        lod_scale = camera->getProjectionMatrix().data[5];
+        lod_camera = *camera;
+        frustum = Frustumf(view_projection);
+        if (threaded && threading::JobSystem::getWorkerCount() > 0)
+            threadedNodeRender(queue, scene->getRoot());
+        else
+            recursiveNodeRender(queue, *scene->getRoot(), !culling, culling_stats);
     }
 }
 
-void BasicNodeRenderPass::recursiveNodeRender(RenderQueue& queue, P<Node> node)
+bool BasicNodeRenderPass::renderNode(RenderQueue& queue, Node* node, bool& inside_view, CullingStats& stats)
 {
-    addNodeToRenderQueue(queue, node);
-    for(P<Node> child : node->getChildren())
+    bool test_own_bounds = false;
+    if (!inside_view)
     {
-        recursiveNodeRender(queue, child);
+        Vector3f center;
+        float radius;
+        node->getRenderBounds(center, radius);
+        if (radius >= 0.0f)
+        {
+            switch(frustum.test(node->getGlobalTransform() * center, radius))
+            {
+            case Frustumf::Result::Outside:
+                if (node->getChildren().empty())
+                    stats.culled++;
+                else
+                    stats.culled_subtrees++;
+                return false;
+            case Frustumf::Result::Inside:
+                inside_view = true;
+                break;
+            case Frustumf::Result::Intersect:
+                //Without children, the subtree bounds are the bounds of our own mesh, which we just tested.
+                //Infinite bounds mean culling is disabled for this node or one of the children.
+                test_own_bounds = !node->getChildren().empty() && radius != std::numeric_limits<float>::infinity();
+                break;
+            }
+        }
+    }
+
+    if (node->isRenderStatic())
+    {
+        renderStaticNode(queue, node, inside_view, stats);
+        return false;
+    }
+
+    //Only nodes that are passed to addNodeToRenderQueue need a P<Node>, walking the tree uses plain pointers.
+    P<Node> node_pointer = node;
+    if (node->render_data.mesh)
+    {
+        Vector3f center;
+        float radius;
+        if (test_own_bounds)
+            node->render_data.getBoundingSphere(center, radius);
+        if (test_own_bounds && radius >= 0.0f && frustum.test(node->getGlobalTransform() * center, radius) == Frustumf::Result::Outside)
+        {
+            stats.culled++;
+        }
+        else
+        {
+            stats.visible++;
+            selectLod(node->render_data, node->getGlobalTransform());
+            stats.triangles += int(node->render_data.getLodMesh()->getIndices().size() / 3);
+            addNodeToRenderQueue(queue, node_pointer);
+        }
+    }
+    else
+    {
+        addNodeToRenderQueue(queue, node_pointer);
+    }
+    return true;
+}
+
+void BasicNodeRenderPass::recursiveNodeRender(RenderQueue& queue, Node* node, bool inside_view, CullingStats& stats)
+{
+    if (!renderNode(queue, node, inside_view, stats))
+        return;
+    for(Node* child : node->getChildren())
+    {
+        recursiveNodeRender(queue, child, inside_view, stats);
+    }
+}
+
+void BasicNodeRenderPass::renderStaticNode(RenderQueue& queue, P<Node> node, bool inside_view, CullingStats& stats)
+{
+    const Node::StaticRenderData& data = node->getStaticRenderData();
+    const Matrix4x4f& transform = node->getGlobalTransform();
+    for(const RenderData& render_data : data.merged)
+    {
+        if (!inside_view)
+        {
+            Vector3f center;
+            float radius;
+            render_data.getBoundingSphere(center, radius);
+            if (frustum.test(transform * center, radius) == Frustumf::Result::Outside)
+            {
+                stats.culled++;
+                continue;
+            }
+        }
+        stats.visible++;
+        stats.triangles += int(render_data.mesh->getIndices().size() / 3);
+        queue.add(transform, render_data);
     }
+    for(P<Node> unmerged : data.unmerged)
+    {
+        if (unmerged->render_data.mesh)
+        {
+            stats.visible++;
+            selectLod(unmerged->render_data, unmerged->getGlobalTransform());
+            stats.triangles += int(unmerged->render_data.getLodMesh()->getIndices().size() / 3);
+        }
+        addNodeToRenderQueue(queue, unmerged);
+    }
+}
+
+void BasicNodeRenderPass::threadedNodeRender(RenderQueue& queue, P<Node> root)
+{
+    //Jobs only read the global transforms, so they need to be up to date before any job starts.
+    root->updateGlobalTransforms();
+    segment_count = 0;
+    jobs.clear();
+    splitNodeRender(queue, root, !culling, 0, (threading::JobSystem::getWorkerCount() + 1) * 4);
+    threading::JobSystem::wait(jobs);
+    jobs.clear();
+    for(size_t n=0; n<segment_count; n++)
+    {
+        Segment& segment = *segments[n];
+        queue.merge(queue.getWorkerQueue(int(n)));
+        culling_stats.visible += segment.stats.visible;
+        culling_stats.culled += segment.stats.culled;
+        culling_stats.culled_subtrees += segment.stats.culled_subtrees;
+        culling_stats.triangles += segment.stats.triangles;
+    }
+}
+
+void BasicNodeRenderPass::splitNodeRender(RenderQueue& queue, P<Node> node, bool inside_view, int depth, int job_target)
+{
+    //Nodes near the root are added by the main thread, until a node has enough children to spread over the jobs.
+    //A node is rendered before jobs for its children start, and never visited again, so the render bounds jobs invalidate are not read here.
+    constexpr int max_split_depth = 4;
+    Segment* segment = segment_count > 0 ? segments[segment_count - 1].get() : nullptr;
+    if (!segment || segment->job)
+        segment = &addSegment(false, inside_view);
+    if (!renderNode(queue.getWorkerQueue(int(segment_count - 1)), *node, inside_view, segment->stats))
+        return;
+    const auto& children = node->getChildren();
+    int child_count = children.size();
+    if (child_count == 0)
+        return;
+    if (child_count < job_target && depth < max_split_depth)
+    {
+        for(Node* child : children)
+            splitNodeRender(queue, child, inside_view, depth + 1, job_target);
+        return;
+    }
+
+    //Every job gets a consecutive range of children, so merging the jobs in order keeps the tree order.
+    size_t per_job = (child_count + job_target - 1) / job_target;
+    Segment* job = nullptr;
+    auto submit = [this, &queue](Segment* job_segment)
+    {
+        RenderQueue* job_queue = &queue.getWorkerQueue(int(segment_count - 1));
+        jobs.push_back(threading::JobSystem::submit([this, job_segment, job_queue]()
+        {
+            for(Node* job_node : job_segment->nodes)
+                recursiveNodeRender(*job_queue, job_node, job_segment->inside_view, job_segment->stats);
+        }, threading::JobSystem::Priority::High));
+    };
+    for(Node* child : children)
+    {
+        if (job && job->nodes.size() >= per_job)
+        {
+            submit(job);
+            job = nullptr;
+        }
+        if (!job)
+            job = &addSegment(true, inside_view);
+        job->nodes.push_back(child);
+    }
+    submit(job);
+}
+
+BasicNodeRenderPass::Segment& BasicNodeRenderPass::addSegment(bool job, bool inside_view)
+{
+    if (segment_count == segments.size())
+        segments.emplace_back(new Segment());
+    Segment& segment = *segments[segment_count++];
+    segment.job = job;
+    segment.inside_view = inside_view;
+    segment.nodes.clear();
+    segment.stats = CullingStats();
+    return segment;
+}
+
+void BasicNodeRenderPass::selectLod(RenderData& data, const Matrix4x4f& transform)
+{
+    if (!data.lod)
+        return;
+    Vector3f center;
+    float radius;
+    data.getBoundingSphere(center, radius);
+    if (radius < 0.0f)
+        return;
+    //The w of the clip space position is the distance in front of a perspective camera, and 1 for an orthographic one.
+    Vector3f position = transform * center;
+    const float* m = view_projection.data;
+    float w = m[3] * position.x + m[7] * position.y + m[11] * position.z + m[15];
+    float screen_size = w > 0.0f ? radius * lod_scale / w : std::numeric_limits<float>::infinity();
+    data.selectLodLevel(lod_camera, screen_size);
 }
 
 void BasicNodeRenderPass::addNodeToRenderQueue(RenderQueue& queue, P<Node>& node)
@@ -1,6 +1,7 @@
 #include <sp2/graphics/scene/collisionrenderpass.h>
 #include <sp2/graphics/meshdata.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/scene/scene.h>
 #include <sp2/scene/node.h>
 #include <sp2/scene/camera.h>
@@ -46,7 +47,7 @@ void CollisionRenderPass::render(RenderQueue& queue)
     }
     if (!enabled)
         return;
-    queue.add([]() { glDisable(GL_DEPTH_TEST); });
+    queue.add([]() { GLState::disable(GL_DEPTH_TEST); });
     if (specific_camera)
     {
         renderScene(queue, *specific_camera->getScene());
@@ -56,7 +57,7 @@ void CollisionRenderPass::render(RenderQueue& queue)
         for(P<Scene> scene : Scene::all())
             renderScene(queue, scene);
     }
-    queue.add([]() { glEnable(GL_DEPTH_TEST); });
+    queue.add([]() { GLState::enable(GL_DEPTH_TEST); });
 }
 
 void CollisionRenderPass::renderScene(RenderQueue& queue, P<Scene> scene)
@@ -3,6 +3,7 @@
 #include <sp2/graphics/scene/renderqueue.h>
 #include <sp2/logging.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/graphics/shader.h>
 
 namespace sp {
@@ -24,11 +25,11 @@ void SceneGraphicsLayer::render(RenderQueue& queue)
     queue.add([]()
     {
         glClear(GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
+        GLState::enable(GL_CULL_FACE);
+        GLState::enable(GL_DEPTH_TEST);
+        GLState::enable(GL_BLEND);
 
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glDepthFunc(GL_LEQUAL);
     });
     
@@ -37,9 +38,9 @@ void SceneGraphicsLayer::render(RenderQueue& queue)
 
     queue.add([]()
     {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::disable(GL_DEPTH_TEST);
+        GLState::disable(GL_CULL_FACE);
         sp::Shader::unbind();
     });
 }
@@ -1,4 +1,8 @@
 #include <sp2/graphics/scene/renderdata.h>
+#include <sp2/graphics/meshdata.h>
+#include <sp2/graphics/lodChain.h>
+#include <algorithm>
+#include <cmath>
 
 namespace sp {
 
@@ -10,6 +14,30 @@ RenderData::RenderData()
     scale = sp::Vector3f(1.0, 1.0, 1.0);
     shader = nullptr;
     texture = nullptr;
+    lod_level = 0;
+}
+
+const std::shared_ptr<MeshData>& RenderData::getLodMesh() const
+{
+    if (lod && lod_level > 0 && lod_level < lod->getLevelCount())
+        return lod->getMesh(lod_level);
+    return mesh;
+}
+
+void RenderData::selectLodLevel(const Camera* camera, float screen_size)
+{
+    //A node is rarely seen by more than a few cameras, the oldest camera makes room when there are more.
+    constexpr size_t max_cameras = 4;
+    auto it = std::find_if(lod_camera_levels.begin(), lod_camera_levels.end(), [camera](const LodCameraLevel& entry) { return entry.camera == camera; });
+    if (it == lod_camera_levels.end())
+    {
+        if (lod_camera_levels.size() >= max_cameras)
+            lod_camera_levels.erase(lod_camera_levels.begin());
+        lod_camera_levels.push_back({camera, 0});
+        it = lod_camera_levels.end() - 1;
+    }
+    it->level = lod->selectLevel(screen_size, it->level);
+    lod_level = it->level;
 }
 
 bool RenderData::operator<(const RenderData& other) const
@@ -37,4 +65,17 @@ bool RenderData::operator<(const RenderData& other) const
     return false;
 }
 
+void RenderData::getBoundingSphere(Vector3f& center, float& radius) const
+{
+    if (!mesh || mesh->getBoundingSphereRadius() < 0.0f)
+    {
+        center = Vector3f(0, 0, 0);
+        radius = -1.0f;
+        return;
+    }
+    const Vector3f& mesh_center = mesh->getBoundingSphereCenter();
+    center = Vector3f(mesh_center.x * scale.x, mesh_center.y * scale.y, mesh_center.z * scale.z);
+    radius = mesh->getBoundingSphereRadius() * std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+}
+
 }//namespace sp
@@ -1,18 +1,51 @@
 #include <sp2/logging.h>
+#include <sp2/assert.h>
 #include <sp2/graphics/scene/renderqueue.h>
 #include <sp2/graphics/meshdata.h>
 #include <sp2/graphics/textureManager.h>
 #include <sp2/graphics/shader.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/scene/camera.h>
+#include <algorithm>
+#include <cstring>
 
 
 namespace sp {
 
+static const Shader::Uniform projection_matrix_uniform("projection_matrix");
+static const Shader::Uniform camera_matrix_uniform("camera_matrix");
+static const Shader::Uniform object_matrix_uniform("object_matrix");
+static const Shader::Uniform object_scale_uniform("object_scale");
+static const Shader::Uniform color_uniform("color");
+static const Shader::Uniform texture_map_uniform("texture_map");
+
+//Default batching limits, small enough that transforming the vertices is cheaper than a draw call.
+static constexpr int default_batch_max_item_vertices = 128;
+static constexpr int default_batch_max_vertices = 16384;
+
+//Below this size a stable insertion sort is faster than the radix passes.
+static constexpr int insertion_sort_limit = 64;
+
+//Map a float on an unsigned int that sorts in the same order.
+static uint32_t sortableFloat(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    if (bits & 0x80000000)
+        return ~bits;
+    return bits | 0x80000000;
+}
+
 RenderQueue::RenderQueue()
 {
-    render_list.clear();
     render_list_sort_start = 0;
+    submit_camera_transform = Matrix4x4f::identity();
+    memset(pin_cache, 0, sizeof(pin_cache));
+    batch_max_item_vertices = default_batch_max_item_vertices;
+    batch_max_vertices = default_batch_max_vertices;
+    worker = false;
+    merged_arena_count = 0;
     
 #ifdef SP2_USE_RENDER_THREAD
     render_data_ready = false;
@@ -21,6 +54,22 @@ RenderQueue::RenderQueue()
 #endif
 }
 
+RenderQueue::RenderQueue(RenderQueue* parent)
+{
+    render_list_sort_start = 0;
+    submit_camera_transform = parent->submit_camera_transform;
+    memset(pin_cache, 0, sizeof(pin_cache));
+    batch_max_item_vertices = parent->batch_max_item_vertices;
+    batch_max_vertices = parent->batch_max_vertices;
+    target_aspect_ratio = parent->target_aspect_ratio;
+    aspect_ratio = parent->aspect_ratio;
+    worker = true;
+    merged_arena_count = 0;
+#ifdef SP2_USE_RENDER_THREAD
+    render_data_ready = false;
+#endif
+}
+
 void RenderQueue::setTargetAspectSize(float aspect_ratio)
 {
     this->target_aspect_ratio = aspect_ratio;
@@ -31,6 +80,12 @@ void RenderQueue::setAspectRatio(float aspect_ratio)
     this->aspect_ratio = aspect_ratio;
 }
 
+void RenderQueue::setBatching(int max_item_vertices, int max_batch_vertices)
+{
+    batch_max_item_vertices = max_item_vertices;
+    batch_max_vertices = max_batch_vertices;
+}
+
 void RenderQueue::setCamera(P<Camera> camera)
 {
     camera->setAspectRatio(target_aspect_ratio * aspect_ratio);
@@ -39,49 +94,214 @@ void RenderQueue::setCamera(P<Camera> camera)
 
 void RenderQueue::setCamera(const Matrix4x4f& camera_projection, const Matrix4x4f& camera_transform)
 {
-    std::sort(render_list.begin() + render_list_sort_start, render_list.end());
-    render_list.emplace_back(Item::Type::CameraProjection, camera_projection);
-    render_list.emplace_back(Item::Type::CameraTransform, camera_transform);
-    render_list_sort_start = render_list.size();
+    sp2assert(!worker, "Worker queues use the camera of the queue they are merged into");
+    sortItems();
+    addItem(Item::Type::CameraProjection)->transform = camera_projection;
+    addItem(Item::Type::CameraTransform)->transform = camera_transform;
+    render_list_sort_start = sort_list.size();
+    submit_camera_transform = camera_transform;
 }
 
-void RenderQueue::add(std::function<void()> function)
+RenderQueue::Item* RenderQueue::addItem(Item::Type type)
 {
-    std::sort(render_list.begin() + render_list_sort_start, render_list.end());
-    render_list.emplace_back(function);
-    render_list_sort_start = render_list.size();
+    Item* item = arena.create<Item>();
+    item->type = type;
+    item->function = nullptr;
+    item->batch_limit = 0;
+    sort_list.push_back({0, item});
+    return item;
 }
 
-void RenderQueue::add(const Matrix4x4f& transform, const RenderData& data)
+RenderQueue::Item* RenderQueue::addFunctionCall()
+{
+    if (worker)
+    {
+        sort_barriers.push_back(sort_list.size());
+        return addItem(Item::Type::FunctionCall);
+    }
+    sortItems();
+    Item* item = addItem(Item::Type::FunctionCall);
+    render_list_sort_start = sort_list.size();
+    return item;
+}
+
+RenderQueue::Item* RenderQueue::addRenderItem(const Matrix4x4f& transform, const RenderData& data)
 {
     if (!data.shader)
+        return nullptr;
+    Item* item = addItem(Item::Type::RenderItem);
+    sort_list.back().key = buildSortKey(transform, data);
+    item->render_type = data.type;
+    item->transform = transform;
+    item->shader = data.shader;
+    const std::shared_ptr<MeshData>& mesh = data.getLodMesh();
+    item->mesh = mesh.get();
+    item->texture = data.texture;
+    item->color = data.color;
+    item->scale = data.scale;
+    if (mesh)
+    {
+        pinMesh(mesh);
+        int vertex_count = int(mesh->getVertices().size());
+        //Merged normals only get the object matrix like in the default shaders, which is wrong for non-uniform scales, so those items are drawn on their own.
+        bool uniform_scale = data.scale.x == data.scale.y && data.scale.y == data.scale.z;
+        if (vertex_count > 0 && vertex_count <= batch_max_item_vertices && uniform_scale && mesh->getType() == MeshData::Type::Static && data.shader->allowsBatching())
+            item->batch_limit = batch_max_vertices;
+    }
+    return item;
+}
+
+void RenderQueue::pinMesh(const std::shared_ptr<MeshData>& mesh)
+{
+    MeshData*& slot = pin_cache[(uintptr_t(mesh.get()) / sizeof(void*)) % pin_cache_size];
+    if (slot == mesh.get())
         return;
-    render_list.emplace_back(transform, data);
+    slot = mesh.get();
+    pinned_meshes.push_back(mesh);
 }
 
-void RenderQueue::add(const Matrix4x4f& transform, const RenderData& data, std::function<void()> function)
+RenderQueue& RenderQueue::getWorkerQueue(int index)
 {
-    if (!data.shader)
+    while(int(worker_queues.size()) <= index)
+        worker_queues.emplace_back(new RenderQueue(this));
+    RenderQueue& queue = *worker_queues[index];
+    queue.submit_camera_transform = submit_camera_transform;
+    queue.batch_max_item_vertices = batch_max_item_vertices;
+    queue.batch_max_vertices = batch_max_vertices;
+    return queue;
+}
+
+void RenderQueue::merge(RenderQueue& worker_queue)
+{
+    sp2assert(worker_queue.worker, "Only worker queues can be merged");
+    auto& entries = worker_queue.sort_list;
+    if (entries.empty())
         return;
-    render_list.emplace_back(transform, data, function);
+    //Replay the sorting that addFunctionCall would have done when the items were added here directly.
+    size_t start = 0;
+    for(size_t barrier : worker_queue.sort_barriers)
+    {
+        sort_list.insert(sort_list.end(), entries.begin() + start, entries.begin() + barrier);
+        sortItems();
+        sort_list.push_back(entries[barrier]);
+        render_list_sort_start = sort_list.size();
+        start = barrier + 1;
+    }
+    sort_list.insert(sort_list.end(), entries.begin() + start, entries.end());
+
+    if (merged_arena_count == merged_arenas.size())
+        merged_arenas.emplace_back(new LinearArena());
+    merged_arenas[merged_arena_count++]->swap(worker_queue.arena);
+    for(const auto& mesh : worker_queue.pinned_meshes)
+        pinMesh(mesh);
+
+    entries.clear();
+    worker_queue.sort_barriers.clear();
+    worker_queue.pinned_meshes.clear();
+    memset(worker_queue.pin_cache, 0, sizeof(worker_queue.pin_cache));
 }
 
 void RenderQueue::render()
 {
-    std::sort(render_list.begin() + render_list_sort_start, render_list.end());
+    sp2assert(!worker, "Worker queues are rendered by merging them into the queue they belong to");
+    sortItems();
     render_list_sort_start = 0;
+    submit_camera_transform = Matrix4x4f::identity();
+    memset(pin_cache, 0, sizeof(pin_cache));
 #ifdef SP2_USE_RENDER_THREAD
     {
         std::unique_lock<std::mutex> lock(render_mutex);
         if (render_data_ready)
             render_trigger.wait(lock, [this](){ return !render_data_ready; });
-        std::swap(ready_render_list, render_list);
+        ready_arena.swap(arena);
+        std::swap(ready_sort_list, sort_list);
+        std::swap(ready_pinned_meshes, pinned_meshes);
+        std::swap(ready_merged_arenas, merged_arenas);
         render_data_ready = true;
     }
     render_trigger.notify_one();
 #else
-    render(render_list);
+    render(sort_list, arena, pinned_meshes, merged_arenas);
 #endif
+    merged_arena_count = 0;
+}
+
+uint64_t RenderQueue::buildSortKey(const Matrix4x4f& transform, const RenderData& data)
+{
+    uint64_t order = uint64_t(std::min(std::max(data.order + 0x8000, 0), 0xffff));
+    uint64_t key = order << 48 | uint64_t(data.type) << 44;
+
+    //Distance in front of the camera, the camera looks along the negative z axis.
+    const float* c = submit_camera_transform.data;
+    float distance = -(c[2] * transform.data[12] + c[6] * transform.data[13] + c[10] * transform.data[14] + c[14]);
+    uint64_t depth = sortableFloat(distance);
+
+    uint64_t shader = data.shader->getId();
+    uint64_t texture = data.texture ? data.texture->getId() + 1 : 0;
+    if (data.type == RenderData::Type::Transparent || data.type == RenderData::Type::Additive)
+    {
+        //Blended items need to be drawn back to front, so depth goes before the state changes.
+        return key | (~depth >> 8 & 0xffffff) << 20 | (shader & 0x3ff) << 10 | (texture & 0x3ff);
+    }
+    const MeshData* mesh_data = data.getLodMesh().get();
+    uint64_t mesh = mesh_data ? mesh_data->getId() + 1 : 0;
+    //Group on state changes first, and draw roughly front to back within the same state to reduce overdraw.
+    return key | (shader & 0x3ff) << 34 | (texture & 0x3fff) << 20 | (mesh & 0xfff) << 8 | (depth >> 24);
+}
+
+void RenderQueue::sortItems()
+{
+    SortEntry* entries = sort_list.data() + render_list_sort_start;
+    size_t count = sort_list.size() - render_list_sort_start;
+    if (count < 2)
+        return;
+    if (count < insertion_sort_limit)
+    {
+        for(size_t n=1; n<count; n++)
+        {
+            SortEntry entry = entries[n];
+            size_t m = n;
+            for(; m > 0 && entries[m - 1].key > entry.key; m--)
+                entries[m] = entries[m - 1];
+            entries[m] = entry;
+        }
+        return;
+    }
+
+    //Least significant digit radix sort on 8 bit digits. Which is stable, so items with equal keys keep the order they were added in.
+    size_t histogram[8][256] = {};
+    for(size_t n=0; n<count; n++)
+    {
+        uint64_t key = entries[n].key;
+        for(int digit=0; digit<8; digit++)
+            histogram[digit][(key >> (digit * 8)) & 0xff]++;
+    }
+    if (sort_buffer.size() < count)
+        sort_buffer.resize(count);
+    SortEntry* source = entries;
+    SortEntry* target = sort_buffer.data();
+    for(int digit=0; digit<8; digit++)
+    {
+        size_t* buckets = histogram[digit];
+        //Skip the pass when all keys have the same value for this digit, which is common for the order and type bits.
+        if (buckets[(source[0].key >> (digit * 8)) & 0xff] == count)
+            continue;
+        size_t offset = 0;
+        for(int bucket=0; bucket<256; bucket++)
+        {
+            size_t bucket_size = buckets[bucket];
+            buckets[bucket] = offset;
+            offset += bucket_size;
+        }
+        for(size_t n=0; n<count; n++)
+        {
+            const SortEntry& entry = source[n];
+            target[buckets[(entry.key >> (digit * 8)) & 0xff]++] = entry;
+        }
+        std::swap(source, target);
+    }
+    if (source != entries)
+        memcpy(entries, source, count * sizeof(SortEntry));
 }
 
 #ifdef SP2_USE_RENDER_THREAD
@@ -94,7 +314,7 @@ void RenderQueue::renderThread()
             if (!render_data_ready)
                 render_trigger.wait(lock, [this](){ return render_data_ready; });
         }
-        render(ready_render_list);
+        render(ready_sort_list, ready_arena, ready_pinned_meshes, ready_merged_arenas);
         {
             std::unique_lock<std::mutex> lock(render_mutex);
             render_data_ready = false;
@@ -104,11 +324,15 @@ void RenderQueue::renderThread()
 }
 #endif
 
-void RenderQueue::render(std::vector<Item>& list)
+void RenderQueue::render(std::vector<SortEntry>& sort_list, LinearArena& arena, std::vector<std::shared_ptr<MeshData>>& pinned_meshes, std::vector<std::unique_ptr<LinearArena>>& merged_arenas)
 {
+    GLState::resetStatistics();
     bool force_camera_matrix_update = false;
-    for(Item& item : list)
+    //Depth writes are left disabled between blended items, and enabled again before anything else runs.
+    bool depth_write_disabled = false;
+    for(size_t index=0; index<sort_list.size(); index++)
     {
+        Item& item = *sort_list[index].item;
         switch(item.type)
         {
         case Item::Type::CameraProjection:
@@ -120,10 +344,10 @@ void RenderQueue::render(std::vector<Item>& list)
             force_camera_matrix_update = true;
             break;
         case Item::Type::FunctionCall:
-            item.function();
+            callFunction(item, depth_write_disabled);
             break;
         case Item::Type::RenderItem:
-            switch(item.data.type)
+            switch(item.render_type)
             {
             case RenderData::Type::None:
             case RenderData::Type::Custom1:
@@ -135,38 +359,134 @@ void RenderQueue::render(std::vector<Item>& list)
             case RenderData::Type::Custom7:
             case RenderData::Type::Custom8:
                 if (item.function)
-                    item.function();
+                    callFunction(item, depth_write_disabled);
                 break;
             case RenderData::Type::Normal:
             case RenderData::Type::Transparent:
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                 break;
             case RenderData::Type::Additive:
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+                GLState::blendFunc(GL_SRC_ALPHA, GL_ONE);
                 break;
             }
-            if (item.data.mesh)
+            if (item.mesh)
             {
-                if (item.data.type == RenderData::Type::Transparent || item.data.type == RenderData::Type::Additive)
-                    glDepthMask(false);
-                if (item.data.shader->bind() || force_camera_matrix_update)
+                bool blended = item.render_type == RenderData::Type::Transparent || item.render_type == RenderData::Type::Additive;
+                if (blended != depth_write_disabled)
+                {
+                    GLState::depthMask(!blended);
+                    depth_write_disabled = blended;
+                }
+                if (item.shader->bind() || force_camera_matrix_update)
                 {
-                    item.data.shader->setUniform("projection_matrix", camera_projection);
-                    item.data.shader->setUniform("camera_matrix", camera_transform);
+                    item.shader->setUniform(projection_matrix_uniform, camera_projection);
+                    item.shader->setUniform(camera_matrix_uniform, camera_transform);
                     force_camera_matrix_update = false;
                 }
-                item.data.shader->setUniform("object_matrix", item.transform);
-                item.data.shader->setUniform("object_scale", item.data.scale);
-                item.data.shader->setUniform("color", item.data.color);
-                item.data.shader->setUniform("texture_map", item.data.texture);
-                item.data.mesh->render();
-                if (item.data.type == RenderData::Type::Transparent || item.data.type == RenderData::Type::Additive)
-                    glDepthMask(true);
+                size_t batch_end = findBatchEnd(sort_list, index);
+                if (batch_end > index + 1)
+                {
+                    renderBatch(sort_list, index, batch_end);
+                    index = batch_end - 1;
+                }
+                else
+                {
+                    item.shader->setUniform(object_matrix_uniform, item.transform);
+                    item.shader->setUniform(object_scale_uniform, item.scale);
+                    item.shader->setUniform(color_uniform, item.color);
+                    item.shader->setUniform(texture_map_uniform, item.texture);
+                    item.mesh->render();
+                }
             }
             break;
         }
     }
-    list.clear();
+    if (depth_write_disabled)
+        GLState::depthMask(true);
+    sort_list.clear();
+    arena.reset();
+    for(auto& merged_arena : merged_arenas)
+        merged_arena->reset();
+    pinned_meshes.clear();
+}
+
+size_t RenderQueue::findBatchEnd(const std::vector<SortEntry>& sort_list, size_t start)
+{
+    const Item& first = *sort_list[start].item;
+    if (!first.batch_limit)
+        return start + 1;
+    int vertex_count = int(first.mesh->getVertices().size());
+    size_t end = start + 1;
+    for(; end<sort_list.size(); end++)
+    {
+        const Item& item = *sort_list[end].item;
+        if (item.type != Item::Type::RenderItem || !item.batch_limit || item.render_type != first.render_type)
+            break;
+        if (item.shader != first.shader || item.texture != first.texture)
+            break;
+        if (item.color.r != first.color.r || item.color.g != first.color.g || item.color.b != first.color.b || item.color.a != first.color.a)
+            break;
+        vertex_count += int(item.mesh->getVertices().size());
+        if (vertex_count > first.batch_limit)
+            break;
+    }
+    return end;
+}
+
+void RenderQueue::renderBatch(const std::vector<SortEntry>& sort_list, size_t start, size_t end)
+{
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for(size_t index=start; index<end; index++)
+    {
+        vertex_count += sort_list[index].item->mesh->getVertices().size();
+        index_count += sort_list[index].item->mesh->getIndices().size();
+    }
+    MeshData::Vertices vertices;
+    MeshData::Indices indices;
+    vertices.reserve(vertex_count);
+    indices.reserve(index_count);
+    for(size_t index=start; index<end; index++)
+    {
+        const Item& item = *sort_list[index].item;
+        const Matrix4x4f& transform = item.transform;
+        uint32_t base = uint32_t(vertices.size());
+        //Same as the default shaders: the scale only applies to positions, and normals get the object matrix without translation.
+        for(const auto& v : item.mesh->getVertices())
+        {
+            Vector3f position(v.position.x * item.scale.x, v.position.y * item.scale.y, v.position.z * item.scale.z);
+            vertices.emplace_back(transform * position, transform.applyDirection(v.normal), v.uv);
+        }
+        for(uint32_t i : item.mesh->getIndices())
+            indices.push_back(base + i);
+    }
+
+    const Item& first = *sort_list[start].item;
+    first.shader->setUniform(object_matrix_uniform, Matrix4x4f::identity());
+    first.shader->setUniform(object_scale_uniform, Vector3f(1, 1, 1));
+    first.shader->setUniform(color_uniform, first.color);
+    first.shader->setUniform(texture_map_uniform, first.texture);
+
+    //The stream mesh rotates over a few buffers and orphans them on upload, so it does not wait for the draw of the previous batch.
+    //It also picks 16 or 32 bit indices, or splits the batch when 32 bit indices are not supported.
+    if (!batch_mesh)
+        batch_mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Stream);
+    else
+        batch_mesh->update(std::move(vertices), std::move(indices));
+    batch_mesh->render();
+}
+
+void RenderQueue::callFunction(Item& item, bool& depth_write_disabled)
+{
+    //Functions can expect the depth buffer to be writable, for example to clear it.
+    if (depth_write_disabled)
+    {
+        GLState::depthMask(true);
+        depth_write_disabled = false;
+    }
+    item.function(item.function_data);
+    //The function can change any OpenGL state directly.
+    GLState::invalidate();
 }
 
 }//namespace sp
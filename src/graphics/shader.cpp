@@ -1,16 +1,36 @@
 #include <sp2/graphics/shader.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/io/resourceProvider.h>
 #include <sp2/logging.h>
 #include <sp2/assert.h>
 #include <sp2/graphics/texture.h>
 
 #include <SDL_messagebox.h>
+#include <cstring>
+#include <mutex>
 
 namespace sp {
 
 std::map<string, Shader*> Shader::cached_shaders;
 Shader* Shader::bound_shader;
+unsigned int Shader::next_id;
+
+//Ids and names of all uniforms, as function static so uniforms can be resolved during static initialization.
+//Render queues are build on multiple threads, so access is guarded by the mutex.
+class UniformRegistry
+{
+public:
+    std::mutex mutex;
+    std::map<string, int> ids;
+    std::vector<string> names;
+};
+
+static UniformRegistry& uniformRegistry()
+{
+    static UniformRegistry registry;
+    return registry;
+}
 
 Shader* Shader::get(const string& name)
 {
@@ -33,6 +53,7 @@ Shader* Shader::get(const string& name)
         string fragment_shader = "#version 110\n";
 #endif
         int type = -1;
+        bool batching = false;
         while(stream->tell() != stream->getSize())
         {
             string line = stream->readLine();
@@ -40,6 +61,8 @@ Shader* Shader::get(const string& name)
                 type = 1;
             else if (line == "[FRAGMENT]")
                 type = 2;
+            else if (line == "[BATCHING]")
+                batching = true;
             else if (type == 1)
                 vertex_shader += line;
             else if (type == 2)
@@ -48,6 +71,7 @@ Shader* Shader::get(const string& name)
             fragment_shader += "\n";
         }
         new_shader = new Shader(name, std::move(vertex_shader), std::move(fragment_shader));
+        new_shader->batching = batching;
     }
     else
     {
@@ -62,12 +86,14 @@ Shader::Shader(const string& name)
 : name(name)
 {
     program = 0;
+    id = next_id++;
 }
 
 Shader::Shader(const string& name, string&& vertex_shader, string&& fragment_shader)
 : name(name), vertex_shader(std::move(vertex_shader)), fragment_shader(std::move(fragment_shader))
 {
     program = 0xffffffff;
+    id = next_id++;
 }
 
 bool Shader::bind()
@@ -116,6 +142,7 @@ bool Shader::bind()
         vertex_attribute = glGetAttribLocation(program, "a_vertex");
         normal_attribute = glGetAttribLocation(program, "a_normal");
         uv_attribute = glGetAttribLocation(program, "a_uv");
+        tile_attribute = glGetAttribLocation(program, "a_tile");
         
         if (vertex_attribute == -1)
             LOG(Warning, "Shader:", name, "has no attribute for a_vertex, this is odd... (legacy shader with gl_Vertex?)");
@@ -129,14 +156,18 @@ bool Shader::bind()
             glDisableVertexAttribArray(previous_shader->normal_attribute);
         if (previous_shader->uv_attribute != -1)
             glDisableVertexAttribArray(previous_shader->uv_attribute);
+        if (previous_shader->tile_attribute != -1)
+            glDisableVertexAttribArray(previous_shader->tile_attribute);
     }
     if (program == 0)
         return false;
-    glUseProgram(program);
+    GLState::useProgram(program);
 
     if (vertex_attribute != -1) glEnableVertexAttribArray(vertex_attribute);
     if (normal_attribute != -1) glEnableVertexAttribArray(normal_attribute);
     if (uv_attribute != -1) glEnableVertexAttribArray(uv_attribute);
+    if (tile_attribute != -1) glEnableVertexAttribArray(tile_attribute);
+    enabled_attributes = 0x0f;
     return true;
 }
 
@@ -164,80 +195,101 @@ unsigned int Shader::compileShader(const char* code, int type)
     return shader_handle;
 }
 
-void Shader::setUniform(const string& s, const Matrix4x4f& matrix)
+Shader::Uniform::Uniform(const string& name)
 {
-    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
-    
-    int location = getUniformLocation(s);
-    if (location == -1)
-        return;
-    glUniformMatrix4fv(location, 1, false, matrix.data);
+    UniformRegistry& registry = uniformRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.ids.find(name);
+    if (it == registry.ids.end())
+    {
+        it = registry.ids.emplace(name, int(registry.names.size())).first;
+        //The names are needed to find the location in the shaders.
+        registry.names.push_back(name);
+    }
+    id = it->second;
 }
 
-void Shader::setUniform(const string& s, const Vector2f& v)
+void Shader::setUniform(Uniform uniform, const Matrix4x4f& matrix)
 {
-    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
-
-    int location = getUniformLocation(s);
-    if (location == -1)
-        return;
-    glUniform2fv(location, 1, &v.x);
+    auto state = updateUniform(uniform, matrix.data, 16);
+    if (state)
+        glUniformMatrix4fv(state->location, 1, false, matrix.data);
 }
 
-void Shader::setUniform(const string& s, const Vector3f& v)
+void Shader::setUniform(Uniform uniform, const Vector2f& v)
 {
-    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
-
-    int location = getUniformLocation(s);
-    if (location == -1)
-        return;
-    glUniform3fv(location, 1, &v.x);
+    auto state = updateUniform(uniform, &v.x, 2);
+    if (state)
+        glUniform2fv(state->location, 1, &v.x);
 }
 
-void Shader::setUniform(const string& s, const Color& c)
+void Shader::setUniform(Uniform uniform, const Vector3f& v)
 {
-    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
+    auto state = updateUniform(uniform, &v.x, 3);
+    if (state)
+        glUniform3fv(state->location, 1, &v.x);
+}
 
-    int location = getUniformLocation(s);
-    if (location == -1)
-        return;
-    glUniform4fv(location, 1, &c.r);
+void Shader::setUniform(Uniform uniform, const Color& c)
+{
+    auto state = updateUniform(uniform, &c.r, 4);
+    if (state)
+        glUniform4fv(state->location, 1, &c.r);
 }
 
-void Shader::setUniform(const string& s, float v)
+void Shader::setUniform(Uniform uniform, float v)
 {
-    int location = getUniformLocation(s);
-    if (location == -1)
-        return;
-    glUniform1f(location, v);
+    auto state = updateUniform(uniform, &v, 1);
+    if (state)
+        glUniform1f(state->location, v);
 }
 
-void Shader::setUniform(const string& s, Texture* texture, int texture_index)
+void Shader::setUniform(Uniform uniform, Texture* texture, int texture_index)
 {
-    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
-    
     if (!texture)
         return;
     
-    int location = getUniformLocation(s);
-    if (location == -1)
+    float index = texture_index;
+    auto state = updateUniform(uniform, &index, 1);
+    if (state)
+        glUniform1i(state->location, texture_index);
+    else if (uniforms[uniform.id].location == -1)
         return;
-    glUniform1i(location, texture_index);
-    glActiveTexture(GL_TEXTURE0 + texture_index);
+    GLState::activeTexture(texture_index);
     texture->bind();
 }
 
-int Shader::getUniformLocation(const string& s)
+Shader::UniformState* Shader::updateUniform(Uniform uniform, const float* value, int size)
 {
-    auto it = uniform_mapping.find(s);
-    if (it != uniform_mapping.end())
-        return it->second;
-        
-    int location = glGetUniformLocation(program, s.c_str());
-    if (location == -1)
-        LOG(Debug, "Failed to find uniform:", s, "in:", name);
-    uniform_mapping[s] = location;
-    return location;
+    sp2assert(bound_shader == this, "Shader needs to be bound before uniforms can be set");
+
+    if (uniform.id >= int(uniforms.size()))
+        uniforms.resize(uniform.id + 1);
+    UniformState& state = uniforms[uniform.id];
+    if (state.location == -2)
+    {
+        string s;
+        {
+            UniformRegistry& registry = uniformRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            s = registry.names[uniform.id];
+        }
+        state.location = glGetUniformLocation(program, s.c_str());
+        if (state.location == -1)
+            LOG(Debug, "Failed to find uniform:", s, "in:", name);
+    }
+    if (state.location == -1)
+        return nullptr;
+    //Uniform values are part of the program, so they are kept when other shaders are used in between.
+    if (state.size == size && memcmp(state.value, value, sizeof(float) * size) == 0)
+    {
+        GLState::countCall(false);
+        return nullptr;
+    }
+    state.size = size;
+    memcpy(state.value, value, sizeof(float) * size);
+    GLState::countCall(true);
+    return &state;
 }
 
 void Shader::unbind()
@@ -250,8 +302,10 @@ void Shader::unbind()
             glDisableVertexAttribArray(bound_shader->normal_attribute);
         if (bound_shader->uv_attribute != -1)
             glDisableVertexAttribArray(bound_shader->uv_attribute);
+        if (bound_shader->tile_attribute != -1)
+            glDisableVertexAttribArray(bound_shader->tile_attribute);
     }
-    glUseProgram(0);
+    GLState::useProgram(0);
     bound_shader = nullptr;
 }
 
@@ -199,6 +199,8 @@ void SpriteAnimation::Data::load(const string& resource_name)
         Vector3f p1 = Vector3f( size.x + offset.x, -size.y + offset.y, 0.0f);
         Vector3f p2 = Vector3f(-size.x + offset.x,  size.y + offset.y, 0.0f);
         Vector3f p3 = Vector3f( size.x + offset.x,  size.y + offset.y, 0.0f);
+        //Sprites face the camera, the normal is kept so lit shaders can shade them.
+        Vector3f normal = Vector3f(0.0f, 0.0f, 1.0f);
         
         total_frames += frames.size();
         for(unsigned int n=0; n<frames.size(); n++)
@@ -253,36 +255,36 @@ void SpriteAnimation::Data::load(const string& resource_name)
             sp::MeshData::Indices indices{0,1,2, 2,1,3};
             if (flip[n].find("D") >= 0)
             {
-                vertices.emplace_back(p2, sp::Vector2f(u1, v1));
-                vertices.emplace_back(p0, sp::Vector2f(u0, v1));
-                vertices.emplace_back(p3, sp::Vector2f(u1, v0));
-                vertices.emplace_back(p1, sp::Vector2f(u0, v0));
+                vertices.emplace_back(p2, normal, sp::Vector2f(u1, v1));
+                vertices.emplace_back(p0, normal, sp::Vector2f(u0, v1));
+                vertices.emplace_back(p3, normal, sp::Vector2f(u1, v0));
+                vertices.emplace_back(p1, normal, sp::Vector2f(u0, v0));
             }
             else
             {
-                vertices.emplace_back(p0, sp::Vector2f(u0, v1));
-                vertices.emplace_back(p1, sp::Vector2f(u1, v1));
-                vertices.emplace_back(p2, sp::Vector2f(u0, v0));
-                vertices.emplace_back(p3, sp::Vector2f(u1, v0));
+                vertices.emplace_back(p0, normal, sp::Vector2f(u0, v1));
+                vertices.emplace_back(p1, normal, sp::Vector2f(u1, v1));
+                vertices.emplace_back(p2, normal, sp::Vector2f(u0, v0));
+                vertices.emplace_back(p3, normal, sp::Vector2f(u1, v0));
             }
-            frame.normal_mesh = MeshData::create(std::move(vertices), std::move(indices));
+            frame.normal_mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Static, MeshData::Layout::PackedNormal);
             vertices.clear();
             sp::MeshData::Indices indices2{0,1,2, 2,1,3};
             if (flip[n].find("D") >= 0)
             {
-                vertices.emplace_back(p2, sp::Vector2f(u0, v1));
-                vertices.emplace_back(p0, sp::Vector2f(u1, v1));
-                vertices.emplace_back(p3, sp::Vector2f(u0, v0));
-                vertices.emplace_back(p1, sp::Vector2f(u1, v0));
+                vertices.emplace_back(p2, normal, sp::Vector2f(u0, v1));
+                vertices.emplace_back(p0, normal, sp::Vector2f(u1, v1));
+                vertices.emplace_back(p3, normal, sp::Vector2f(u0, v0));
+                vertices.emplace_back(p1, normal, sp::Vector2f(u1, v0));
             }
             else
             {
-                vertices.emplace_back(p0, sp::Vector2f(u1, v1));
-                vertices.emplace_back(p1, sp::Vector2f(u0, v1));
-                vertices.emplace_back(p2, sp::Vector2f(u1, v0));
-                vertices.emplace_back(p3, sp::Vector2f(u0, v0));
+                vertices.emplace_back(p0, normal, sp::Vector2f(u1, v1));
+                vertices.emplace_back(p1, normal, sp::Vector2f(u0, v1));
+                vertices.emplace_back(p2, normal, sp::Vector2f(u1, v0));
+                vertices.emplace_back(p3, normal, sp::Vector2f(u0, v0));
             }
-            frame.mirrored_mesh = MeshData::create(std::move(vertices), std::move(indices2));
+            frame.mirrored_mesh = MeshData::create(std::move(vertices), std::move(indices2), MeshData::Type::Static, MeshData::Layout::PackedNormal);
             vertices.clear();
             
             frame.delay = delays[n % delays.size()];
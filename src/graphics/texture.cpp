@@ -1,11 +1,14 @@
 #include <sp2/graphics/texture.h>
 #include <sp2/graphics/textureManager.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 #include <sp2/logging.h>
 
 
 namespace sp {
 
+std::atomic<unsigned int> Texture::next_id;
+
 OpenGLTexture::OpenGLTexture(Type type, const string& name)
 : Texture(type, name)
 {
@@ -16,7 +19,10 @@ OpenGLTexture::OpenGLTexture(Type type, const string& name)
 OpenGLTexture::~OpenGLTexture()
 {
     if (handle)
+    {
         glDeleteTextures(1, &handle);
+        GLState::forgetTexture(handle);
+    }
 }
 
 void OpenGLTexture::bind()
@@ -30,13 +36,13 @@ void OpenGLTexture::bind()
         if (handle == 0)
         {
             glGenTextures(1, &handle);
-            glBindTexture(GL_TEXTURE_2D, handle);
+            GLState::bindTexture(GL_TEXTURE_2D, handle);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
         }
         else
         {
-            glBindTexture(GL_TEXTURE_2D, handle);
+            GLState::bindTexture(GL_TEXTURE_2D, handle);
         }
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
@@ -48,9 +54,9 @@ void OpenGLTexture::bind()
     }
     
     if (handle)
-        glBindTexture(GL_TEXTURE_2D, handle);
+        GLState::bindTexture(GL_TEXTURE_2D, handle);
     else
-        glBindTexture(GL_TEXTURE_2D, 0); //TODO: Fallback texture
+        GLState::bindTexture(GL_TEXTURE_2D, 0); //TODO: Fallback texture
 }
 
 void OpenGLTexture::setImage(Image&& image)
@@ -1,6 +1,7 @@
 #include <sp2/graphics/textureAtlas.h>
 #include <sp2/graphics/textureManager.h>
 #include <sp2/graphics/opengl.h>
+#include <sp2/graphics/glState.h>
 
 #include <algorithm>
 
@@ -19,7 +20,10 @@ AtlasTexture::AtlasTexture(const string& name, Vector2i size)
 AtlasTexture::~AtlasTexture()
 {
     if (gl_handle)
+    {
         glDeleteTextures(1, &gl_handle);
+        GLState::forgetTexture(gl_handle);
+    }
 }
 
 void AtlasTexture::bind()
@@ -27,7 +31,7 @@ void AtlasTexture::bind()
     if (gl_handle == 0)
     {
         glGenTextures(1, &gl_handle);
-        glBindTexture(GL_TEXTURE_2D, gl_handle);
+        GLState::bindTexture(GL_TEXTURE_2D, gl_handle);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
@@ -37,7 +41,7 @@ void AtlasTexture::bind()
     }
     else
     {
-        glBindTexture(GL_TEXTURE_2D, gl_handle);
+        GLState::bindTexture(GL_TEXTURE_2D, gl_handle);
     }
 
     if (!add_list.empty())
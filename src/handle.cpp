@@ -0,0 +1,69 @@
+#include <sp2/handle.h>
+#include <sp2/assert.h>
+#include <mutex>
+
+namespace sp {
+
+_HandleTable::Slot* _HandleTable::pages[_HandleTable::page_count];
+
+static std::mutex handle_table_mutex;
+//Index 0 is never used, so an index of 0 can be used as "no handle"
+static uint32_t next_index = 1;
+static uint32_t free_list = 0;
+
+uint32_t _HandleTable::acquire(AutoPointerObject* object)
+{
+    //Once assigned, the index of an object never changes till it is deleted.
+    //The acquire load pairs with the release store below, so the slot and its page are visible.
+    uint32_t existing = object->handle_index.load(std::memory_order_acquire);
+    if (existing)
+        return existing;
+
+    std::lock_guard<std::mutex> lock(handle_table_mutex);
+    existing = object->handle_index.load(std::memory_order_relaxed);
+    if (existing)
+        return existing;
+
+    uint32_t index;
+    if (free_list)
+    {
+        index = free_list;
+        free_list = pages[index >> page_shift][index & (page_size - 1)].next_free;
+    }
+    else
+    {
+        index = next_index++;
+        Slot*& page = pages[index >> page_shift];
+        if (!page)
+        {
+            sp2assert((index >> page_shift) < page_count, "Out of handle slots.");
+            page = new Slot[page_size];
+            for(uint32_t n=0; n<page_size; n++)
+            {
+                page[n].object.store(nullptr, std::memory_order_relaxed);
+                page[n].generation.store(1, std::memory_order_relaxed);
+                page[n].next_free = 0;
+            }
+        }
+    }
+    Slot& slot = pages[index >> page_shift][index & (page_size - 1)];
+    slot.object.store(object, std::memory_order_relaxed);
+    object->handle_index.store(index, std::memory_order_release);
+    return index;
+}
+
+void _HandleTable::release(uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(handle_table_mutex);
+    Slot& slot = pages[index >> page_shift][index & (page_size - 1)];
+    slot.object.store(nullptr, std::memory_order_relaxed);
+    //Generation 0 is what an empty handle uses, skip it when wrapping around.
+    uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+    if (generation == 0)
+        generation = 1;
+    slot.generation.store(generation, std::memory_order_release);
+    slot.next_free = free_list;
+    free_list = index;
+}
+
+}//namespace sp
@@ -1,4 +1,5 @@
 #include <sp2/io/irc/client.h>
+#include <sp2/logging.h>
 
 namespace sp {
 namespace io {
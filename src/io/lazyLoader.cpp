@@ -3,36 +3,10 @@
 namespace sp {
 namespace io {
 
-#ifndef __EMSCRIPTEN__
-static bool running = true;
-#endif
-std::thread* LazyLoaderManager::thread;
-sp::threading::Queue<std::function<void()>> LazyLoaderManager::queue;
-
 void LazyLoaderManager::addWork(std::function<void()> f)
 {
-#ifdef __EMSCRIPTEN__
-    //emscripten has very limited threading support, so do not lazy load with emscripten.
-    f();
-#else
-    queue.put(f);
-
-    if (!thread)
-    {
-        atexit([](){
-            running = false;
-            queue.put([](){});
-        });
-        thread = new std::thread([]()
-        {
-            while(running)
-            {
-                std::function<void()> workFunction = queue.get();
-                workFunction();
-            }
-        });
-    }
-#endif
+    //Loading is done on the shared job system, so multiple resources can be decoded at the same time.
+    threading::JobSystem::submit(std::move(f), threading::JobSystem::Priority::Low);
 }
 
 }//namespace io
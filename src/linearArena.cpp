@@ -0,0 +1,85 @@
+#include <sp2/linearArena.h>
+#include <sp2/assert.h>
+#include <algorithm>
+
+namespace sp {
+
+std::atomic<size_t> LinearArena::heap_allocation_count{0};
+
+LinearArena::LinearArena(size_t block_size)
+: block_size(block_size), block_index(0), block_used(0), destructors(nullptr)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    reset();
+    for(auto& block : blocks)
+        delete[] block.data;
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+    sp2assert(alignment <= alignof(std::max_align_t), "LinearArena does not support over aligned allocations");
+    size_t offset = (block_used + alignment - 1) & ~(alignment - 1);
+    if (blocks.empty() || offset + size > blocks[block_index].size)
+    {
+        nextBlock(size);
+        offset = 0;
+    }
+    block_used = offset + size;
+    return blocks[block_index].data + offset;
+}
+
+void LinearArena::reset()
+{
+    while(destructors)
+    {
+        Destructor* destructor = destructors;
+        destructors = destructor->next;
+        destructor->function(destructor->object);
+    }
+    block_index = 0;
+    block_used = 0;
+}
+
+void LinearArena::swap(LinearArena& other)
+{
+    std::swap(block_size, other.block_size);
+    std::swap(blocks, other.blocks);
+    std::swap(block_index, other.block_index);
+    std::swap(block_used, other.block_used);
+    std::swap(destructors, other.destructors);
+}
+
+void LinearArena::addDestructor(void (*function)(void*), void* object)
+{
+    Destructor* destructor = static_cast<Destructor*>(allocate(sizeof(Destructor), alignof(Destructor)));
+    destructor->function = function;
+    destructor->object = object;
+    destructor->next = destructors;
+    destructors = destructor;
+}
+
+void LinearArena::nextBlock(size_t minimal_size)
+{
+    if (!blocks.empty())
+        block_index++;
+    //Reuse the blocks from previous frames, unless the next one is too small for this allocation.
+    if (block_index < blocks.size() && blocks[block_index].size < minimal_size)
+    {
+        delete[] blocks[block_index].data;
+        blocks[block_index].size = minimal_size;
+        blocks[block_index].data = new char[minimal_size];
+        heap_allocation_count++;
+    }
+    else if (block_index == blocks.size())
+    {
+        size_t size = std::max(block_size, minimal_size);
+        blocks.push_back({new char[size], size});
+        heap_allocation_count++;
+    }
+    block_used = 0;
+}
+
+}//namespace sp
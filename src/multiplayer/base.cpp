@@ -12,6 +12,7 @@ bool Base::isServer()
 
 P<Node> Base::getNode(uint64_t id)
 {
+    std::lock_guard<std::mutex> lock(node_by_id_mutex);
     auto it = node_by_id.find(id);
     if (it == node_by_id.end())
         return nullptr;
@@ -21,22 +22,24 @@ P<Node> Base::getNode(uint64_t id)
 void Base::addNode(P<Node> node)
 {
     sp2assert(node->multiplayer.getId() > 0, "Nodes need to be given an ID before added to a multiplayer node registry.");
+    std::lock_guard<std::mutex> lock(node_by_id_mutex);
     node_by_id[node->multiplayer.getId()] = node;
 }
 
-std::unordered_map<uint64_t, P<Node>>::iterator Base::nodeBegin()
+std::unordered_map<uint64_t, Handle<Node>>::iterator Base::nodeBegin()
 {
     cleanDeletedNodes();
     return node_by_id.begin();
 }
 
-std::unordered_map<uint64_t, P<Node>>::iterator Base::nodeEnd()
+std::unordered_map<uint64_t, Handle<Node>>::iterator Base::nodeEnd()
 {
     return node_by_id.end();
 }
 
 void Base::cleanDeletedNodes()
 {
+    std::lock_guard<std::mutex> lock(node_by_id_mutex);
     for(auto it = node_by_id.begin(); it != node_by_id.end(); )
     {
         if (it->second)
@@ -1,10 +1,19 @@
 #include <sp2/pointer.h>
 #include <sp2/pointerList.h>
+#include <sp2/pointerVector.h>
+#include <sp2/handle.h>
 
 namespace sp {
 
 AutoPointerObject::~AutoPointerObject()
 {
+    uint32_t index = handle_index.load(std::memory_order_acquire);
+    if (index)
+        _HandleTable::release(index);
+
+    if (pointer_vector_storage)
+        _PVectorStorage::clearObject(this);
+
     for(_PBase* p = pointer_list_start; p; p = p->next)
         p->ptr = nullptr;
     
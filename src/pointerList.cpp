@@ -1,8 +1,82 @@
 #include <sp2/pointerList.h>
+#include <atomic>
 
 namespace sp {
 
-static _PListEntry* free_list;
+/* Entries are allocated in slabs, and every thread keeps its own cache of free entries, so creating and freeing entries never locks.
+   When a thread cache grows too large, a batch of entries is returned to a global lock free stack, where other threads can pick it up.
+   Inside a batch, entries are linked with list_next, batches on the global stack are linked with the object_next of their first entry.
+ */
+static constexpr int slab_size = 256;
+static constexpr int batch_size = 64;
+
+static std::atomic<_PListEntry*> global_batches{nullptr};
+
+//Plain data, so it stays usable after the thread_local destructors have run, for lists that are destroyed during static destruction.
+struct PListEntryCache
+{
+    enum class State { Unused, Active, Exited };
+
+    _PListEntry* free_list;
+    int count;
+    State state;
+};
+static thread_local PListEntryCache cache;
+
+static void pushBatch(_PListEntry* batch)
+{
+    _PListEntry* head = global_batches.load(std::memory_order_relaxed);
+    do
+    {
+        batch->object_next = head;
+    } while(!global_batches.compare_exchange_weak(head, batch, std::memory_order_release, std::memory_order_relaxed));
+}
+
+static _PListEntry* popBatch()
+{
+    //Taking the whole stack and pushing back the remainder avoids the ABA problem of popping a single batch.
+    _PListEntry* batches = global_batches.exchange(nullptr, std::memory_order_acquire);
+    if (!batches)
+        return nullptr;
+    _PListEntry* rest = batches->object_next;
+    while(rest)
+    {
+        _PListEntry* next = rest->object_next;
+        pushBatch(rest);
+        rest = next;
+    }
+    return batches;
+}
+
+static _PListEntry* takeFromCache(int count)
+{
+    _PListEntry* batch = cache.free_list;
+    _PListEntry* last = batch;
+    for(int n=1; n<count; n++)
+        last = last->list_next;
+    cache.free_list = last->list_next;
+    cache.count -= count;
+    last->list_next = nullptr;
+    return batch;
+}
+
+static void flushCache()
+{
+    while(cache.count > 0)
+        pushBatch(takeFromCache(std::min(cache.count, batch_size)));
+    cache.state = PListEntryCache::State::Exited;
+}
+
+static void activateCache()
+{
+    struct Flusher
+    {
+        ~Flusher() { flushCache(); }
+    };
+    static thread_local Flusher flusher;
+    (void)flusher;
+    cache.state = PListEntryCache::State::Active;
+}
 
 _PListBase::~_PListBase()
 {
@@ -66,8 +140,6 @@ _PListEntry* _PListBase::removeEntry(_PListEntry* e)
 
 void _PListEntry::free()
 {
-    list_next = free_list;
-    free_list = this;
 #ifdef DEBUG
     object = nullptr;
     object_prev = nullptr;
@@ -75,19 +147,51 @@ void _PListEntry::free()
 
     list = nullptr;
 #endif
+    if (cache.state == PListEntryCache::State::Unused)
+        activateCache();
+    if (cache.state == PListEntryCache::State::Exited)
+    {
+        //This thread is shutting down, hand the entry directly to the other threads.
+        list_next = nullptr;
+        pushBatch(this);
+        return;
+    }
+    list_next = cache.free_list;
+    cache.free_list = this;
+    cache.count++;
+    //Keep one batch around, so a thread that creates and frees in a loop does not keep moving the same batch.
+    if (cache.count >= batch_size * 2)
+        pushBatch(takeFromCache(batch_size));
 }
 
 _PListEntry* _PListEntry::create()
 {
-    _PListEntry* result = free_list;
-    if (result)
-    {
-        free_list = free_list->list_next;
-    }
-    else
+    if (!cache.free_list)
     {
-        result = new _PListEntry();
+        if (cache.state == PListEntryCache::State::Unused)
+            activateCache();
+        _PListEntry* batch = popBatch();
+        if (!batch)
+        {
+            batch = new _PListEntry[slab_size];
+            for(int n=0; n<slab_size - 1; n++)
+                batch[n].list_next = &batch[n + 1];
+            batch[slab_size - 1].list_next = nullptr;
+        }
+        if (cache.state == PListEntryCache::State::Exited)
+        {
+            //Keep the first entry, and give the rest back.
+            if (batch->list_next)
+                pushBatch(batch->list_next);
+            return batch;
+        }
+        cache.free_list = batch;
+        for(_PListEntry* e = batch; e; e = e->list_next)
+            cache.count++;
     }
+    _PListEntry* result = cache.free_list;
+    cache.free_list = result->list_next;
+    cache.count--;
     return result;
 }
 
@@ -0,0 +1,154 @@
+#include <sp2/pointerVector.h>
+
+namespace sp {
+
+void _PVectorStorage::findLink(uint32_t index, _PVectorStorage**& link_storage, uint32_t*& link_index)
+{
+    AutoPointerObject* object = items[index].object;
+    link_storage = &object->pointer_vector_storage;
+    link_index = &object->pointer_vector_index;
+    while(*link_storage != this || *link_index != index)
+    {
+        Entry& entry = (*link_storage)->items[*link_index];
+        link_storage = &entry.next_storage;
+        link_index = &entry.next_index;
+    }
+}
+
+void _PVectorStorage::unlink(uint32_t index)
+{
+    _PVectorStorage** link_storage;
+    uint32_t* link_index;
+    findLink(index, link_storage, link_index);
+    *link_storage = items[index].next_storage;
+    *link_index = items[index].next_index;
+}
+
+void _PVectorStorage::relink(uint32_t index)
+{
+    Entry& entry = items[index];
+    entry.next_storage = entry.object->pointer_vector_storage;
+    entry.next_index = entry.object->pointer_vector_index;
+    entry.object->pointer_vector_storage = this;
+    entry.object->pointer_vector_index = index;
+}
+
+void _PVectorStorage::compact()
+{
+    //Entries only move down, so the chains stay valid while moving them one by one.
+    uint32_t target = 0;
+    for(uint32_t index=0; index<items.size(); index++)
+    {
+        if (!items[index].object)
+            continue;
+        if (target != index)
+        {
+            _PVectorStorage** link_storage;
+            uint32_t* link_index;
+            findLink(index, link_storage, link_index);
+            *link_index = target;
+            items[target] = items[index];
+        }
+        target++;
+    }
+    items.resize(target);
+    has_holes = false;
+}
+
+void _PVectorStorage::add(AutoPointerObject* item)
+{
+    //Clean out deleted objects before growing, so lists that are never iterated do not keep growing.
+    if (items.size() == items.capacity() && !iterators)
+        compact();
+    items.push_back({item, nullptr, 0});
+    relink(uint32_t(items.size() - 1));
+    count++;
+}
+
+void _PVectorStorage::remove(AutoPointerObject* item)
+{
+    //Only walks the entries that point to this object, the hole is compacted later.
+    _PVectorStorage** link_storage = &item->pointer_vector_storage;
+    uint32_t* link_index = &item->pointer_vector_index;
+    while(*link_storage)
+    {
+        Entry& entry = (*link_storage)->items[*link_index];
+        if (*link_storage == this)
+        {
+            *link_storage = entry.next_storage;
+            *link_index = entry.next_index;
+            entry.object = nullptr;
+            has_holes = true;
+            count--;
+        }
+        else
+        {
+            link_storage = &entry.next_storage;
+            link_index = &entry.next_index;
+        }
+    }
+}
+
+void _PVectorStorage::clear()
+{
+    for(uint32_t index=0; index<items.size(); index++)
+    {
+        if (items[index].object)
+        {
+            unlink(index);
+            items[index].object = nullptr;
+        }
+    }
+    count = 0;
+    if (iterators)
+        has_holes = true;
+    else
+        items.clear();
+}
+
+void _PVectorStorage::sort(const std::function<bool(AutoPointerObject* a, AutoPointerObject* b)>& less)
+{
+    if (!iterators)
+        compact();
+    for(uint32_t index=0; index<items.size(); index++)
+        if (items[index].object)
+            unlink(index);
+    std::stable_sort(items.begin(), items.end(), [&less](const Entry& a, const Entry& b)
+    {
+        //Holes are moved to the end.
+        if (!a.object || !b.object)
+            return a.object && !b.object;
+        return less(a.object, b.object);
+    });
+    for(uint32_t index=0; index<items.size(); index++)
+        if (items[index].object)
+            relink(index);
+}
+
+void _PVectorStorage::releaseIterator()
+{
+    iterators--;
+    if (iterators)
+        return;
+    if (orphaned)
+        delete this;
+    else if (has_holes)
+        compact();
+}
+
+void _PVectorStorage::clearObject(AutoPointerObject* object)
+{
+    _PVectorStorage* storage = object->pointer_vector_storage;
+    uint32_t index = object->pointer_vector_index;
+    while(storage)
+    {
+        Entry& entry = storage->items[index];
+        entry.object = nullptr;
+        storage->has_holes = true;
+        storage->count--;
+        storage = entry.next_storage;
+        index = entry.next_index;
+    }
+}
+
+}//namespace sp
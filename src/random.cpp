@@ -2,12 +2,15 @@
 #include <time.h>
 #include <stdint.h>
 #include <random>
+#include <mutex>
 
 #include <sp2/random.h>
 
 namespace sp {
 
 static std::mt19937_64 random_engine;
+//Scenes with independent update can draw numbers from job system workers at the same time.
+static std::mutex random_mutex;
 
 class StaticRandomInitializer
 {
@@ -21,16 +24,19 @@ static StaticRandomInitializer static_random_initializer;
 
 float random(float fmin, float fmax)
 {
+    std::lock_guard<std::mutex> lock(random_mutex);
     return std::uniform_real_distribution<>(fmin, fmax)(random_engine);
 }
 
 int irandom(int imin, int imax)
 {
+    std::lock_guard<std::mutex> lock(random_mutex);
     return std::uniform_int_distribution<>(imin, imax)(random_engine);
 }
 
 bool chance(float percentage)
 {
+    std::lock_guard<std::mutex> lock(random_mutex);
     return std::bernoulli_distribution(percentage / 100.0f)(random_engine);
 }
 
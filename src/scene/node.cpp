@@ -5,7 +5,10 @@
 #include <sp2/assert.h>
 #include <sp2/multiplayer/server.h>
 #include <sp2/multiplayer/registry.h>
+#include <sp2/graphics/meshdata.h>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <typeindex>
 
 namespace sp {
@@ -19,9 +22,9 @@ Node::Node(P<Node> parent)
     
     scene = parent->scene;
     parent->children.add(this);
+    parent->invalidateRenderBounds();
     
-    local_transform = Matrix4x4f::identity();
-    updateGlobalTransform();
+    transform_slot = scene->transforms.create(parent->parent ? parent->transform_slot : -1);
 }
 
 Node::Node(Scene* scene)
@@ -30,8 +33,7 @@ Node::Node(Scene* scene)
     collision_body = nullptr;
     parent = nullptr;
     
-    global_transform = Matrix4x4f::identity();
-    local_transform = Matrix4x4f::identity();
+    transform_slot = scene->transforms.create(-1);
 }
 
 Node::~Node()
@@ -40,6 +42,12 @@ Node::~Node()
         child.destroy();
     if (collision_body)
         scene->collision_backend->destroyBody(collision_body);
+    scene->transforms.destroy(transform_slot);
+    scene->removeFromTickList(Scene::TickUpdate, this);
+    scene->removeFromTickList(Scene::TickFixedUpdate, this);
+    scene->removeFromTickList(Scene::TickAnimation, this);
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 P<Node> Node::getParent() const
@@ -52,7 +60,7 @@ P<Scene> Node::getScene() const
     return scene;
 }
 
-const PList<Node>& Node::getChildren()
+const PVector<Node>& Node::getChildren()
 {
     return children;
 }
@@ -65,58 +73,95 @@ void Node::setParent(P<Node> new_parent)
     sp2assert(!multiplayer.isEnabled(), "Tried to switch parents on a multiplayer enabled node. This is not supported.");
     
     parent->children.remove(P<Node>(this));
+    parent->invalidateRenderBounds();
     parent = new_parent;
     parent->children.add(this);
+    parent->invalidateRenderBounds();
 
-    if (new_parent->scene != scene)
+    Scene* old_scene = *scene;
+    scene = new_parent->scene;
+    reattach(old_scene);
+}
+
+void Node::reattach(Scene* old_scene)
+{
+    //Move to the end of the tick lists, so parents keep being updated before their children.
+    //The last tick stops a node that moves while the list is ticking from being ticked twice, it only applies to the scene it was ticked in.
+    for(int list=0; list<Scene::TickListCount; list++)
     {
-        scene = new_parent->scene;
-        for(P<Node> child : children)
+        if (tick_list_index[list] >= 0)
         {
-            sp2assert(child->children.size() == 0, "Implementation incomplete...");
-            child->scene = new_parent->scene;
+            old_scene->removeFromTickList(Scene::TickList(list), this);
+            scene->addToTickList(Scene::TickList(list), this);
         }
+        if (old_scene != *scene)
+            last_tick[list] = 0;
+    }
+
+    int parent_slot = parent->parent ? parent->transform_slot : -1;
+    if (old_scene != *scene)
+    {
+        Vector3d translation = old_scene->transforms.getTranslation(transform_slot);
+        Quaterniond rotation = old_scene->transforms.getRotation(transform_slot);
+        old_scene->transforms.destroy(transform_slot);
+        transform_slot = scene->transforms.create(parent_slot);
+        scene->transforms.setTranslation(transform_slot, translation);
+        scene->transforms.setRotation(transform_slot, rotation);
+    }
+    else
+    {
+        //Even with the same parent slot, the depth of our children can change, so always update.
+        scene->transforms.setParent(transform_slot, parent_slot);
+    }
+    for(Node* child : children)
+    {
+        child->scene = scene;
+        child->reattach(old_scene);
     }
-    
-    updateGlobalTransform();
 }
 
 void Node::setPosition(sp::Vector2d position)
 {
+    Vector3d translation = scene->transforms.getTranslation(transform_slot);
     if (translation.x == position.x && translation.y == position.y)
         return;
     translation.x = position.x;
     translation.y = position.y;
     if (collision_body)
         scene->collision_backend->updatePosition(collision_body, sp::Vector3d(position.x, position.y, 0));
-    updateLocalTransform();
+    scene->transforms.setTranslation(transform_slot, translation);
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 void Node::setPosition(sp::Vector3d position)
 {
-    if (translation == position)
+    if (scene->transforms.getTranslation(transform_slot) == position)
         return;
-    translation = position;
     if (collision_body)
         scene->collision_backend->updatePosition(collision_body, position);
-    updateLocalTransform();
+    scene->transforms.setTranslation(transform_slot, position);
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 void Node::setRotation(double rotation)
 {
-    this->rotation = Quaterniond::fromAngle(rotation);
     if (collision_body)
         scene->collision_backend->updateRotation(collision_body, rotation);
-    updateLocalTransform();
+    scene->transforms.setRotation(transform_slot, Quaterniond::fromAngle(rotation));
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 void Node::setRotation(Quaterniond rotation)
 {
-    this->rotation = rotation;
-    this->rotation.normalize();
+    rotation.normalize();
     if (collision_body)
         scene->collision_backend->updateRotation(collision_body, rotation);
-    updateLocalTransform();
+    scene->transforms.setRotation(transform_slot, rotation);
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 void Node::setLinearVelocity(sp::Vector2d velocity)
@@ -145,32 +190,33 @@ void Node::setAngularVelocity(sp::Vector3d velocity)
 
 Vector2d Node::getPosition2D() const
 {
+    const Vector3d& translation = scene->transforms.getTranslation(transform_slot);
     return Vector2d(translation.x, translation.y);
 }
 
 double Node::getRotation2D() const
 {
-    return (rotation * Vector2d(1, 0)).angle();
+    return (scene->transforms.getRotation(transform_slot) * Vector2d(1, 0)).angle();
 }
 
 Vector2d Node::getGlobalPosition2D() const
 {
-    return Vector2d(global_transform * Vector2f(0, 0));
+    return Vector2d(getGlobalTransform() * Vector2f(0, 0));
 }
 
 double Node::getGlobalRotation2D() const
 {
-    return global_transform.applyDirection(Vector2f(1, 0)).angle();
+    return getGlobalTransform().applyDirection(Vector2f(1, 0)).angle();
 }
 
 Vector2d Node::getLocalPoint2D(Vector2d v) const
 {
-    return Vector2d(local_transform * Vector2f(v));
+    return Vector2d(getLocalTransform() * Vector2f(v));
 }
 
 Vector2d Node::getGlobalPoint2D(Vector2d v) const
 {
-    return Vector2d(global_transform * Vector2f(v));
+    return Vector2d(getGlobalTransform() * Vector2f(v));
 }
 
 sp::Vector2d Node::getLinearVelocity2D() const
@@ -195,26 +241,26 @@ double Node::getAngularVelocity2D() const
 
 Vector3d Node::getPosition3D() const
 {
-    return translation;
+    return scene->transforms.getTranslation(transform_slot);
 }
 
 Quaterniond Node::getRotation3D() const
 {
-    return rotation;
+    return scene->transforms.getRotation(transform_slot);
 }
 
 Vector3d Node::getGlobalPosition3D() const
 {
-    return Vector3d(global_transform * Vector3f(0, 0, 0));
+    return Vector3d(getGlobalTransform() * Vector3f(0, 0, 0));
 }
 
 Quaterniond Node::getGlobalRotation3D() const
 {
-    Quaterniond result = rotation;
+    Quaterniond result = getRotation3D();
     sp::P<Node> n = getParent();
     while(n)
     {
-        result = n->rotation * result;
+        result = n->getRotation3D() * result;
         n = n->getParent();
     }
     return result;
@@ -222,7 +268,7 @@ Quaterniond Node::getGlobalRotation3D() const
 
 Vector3d Node::getGlobalPoint3D(Vector3d v) const
 {
-    return Vector3d(global_transform * Vector3f(v));
+    return Vector3d(getGlobalTransform() * Vector3f(v));
 }
 
 Vector3d Node::getLinearVelocity3D() const
@@ -276,7 +322,30 @@ void Node::setAnimation(std::unique_ptr<Animation> animation)
 {
     this->animation = std::move(animation);
     if (this->animation)
+    {
         this->animation->prepare(render_data);
+        scene->addToTickList(Scene::TickAnimation, this);
+    }
+    else
+    {
+        scene->removeFromTickList(Scene::TickAnimation, this);
+    }
+}
+
+void Node::setUpdateEnabled(bool enabled)
+{
+    if (enabled)
+        scene->addToTickList(Scene::TickUpdate, this);
+    else
+        scene->removeFromTickList(Scene::TickUpdate, this);
+}
+
+void Node::setFixedUpdateEnabled(bool enabled)
+{
+    if (enabled)
+        scene->addToTickList(Scene::TickFixedUpdate, this);
+    else
+        scene->removeFromTickList(Scene::TickFixedUpdate, this);
 }
 
 void Node::animationPlay(const string& key, float speed)
@@ -305,36 +374,214 @@ bool Node::animationIsFinished() const
     return animation->finished();
 }
 
-void Node::updateLocalTransform()
+const Matrix4x4f& Node::getLocalTransform() const
 {
-    local_transform = Matrix4x4f::translate(Vector3f(translation)) * Matrix4x4f::fromQuaternion(Quaternionf(rotation));
-    updateGlobalTransform();
+    return scene->transforms.getLocalTransform(transform_slot);
 }
 
-void Node::updateGlobalTransform()
+const Matrix4x4f& Node::getGlobalTransform() const
 {
-    if (parent && parent != scene->getRoot())
-        global_transform = parent->global_transform * local_transform;
-    else
-        global_transform = local_transform;
+    return scene->transforms.getGlobalTransform(transform_slot);
+}
 
-    for(P<Node> n : children)
-        n->updateGlobalTransform();
+void Node::updateGlobalTransforms()
+{
+    scene->transforms.update();
 }
 
 void Node::modifyPositionByPhysics(sp::Vector2d position, double rotation)
 {
-    translation.x = position.x;
-    translation.y = position.y;
-    this->rotation = Quaterniond::fromAngle(rotation);
-    updateLocalTransform();
+    double z = scene->transforms.getTranslation(transform_slot).z;
+    scene->transforms.setTranslation(transform_slot, Vector3d(position.x, position.y, z));
+    scene->transforms.setRotation(transform_slot, Quaterniond::fromAngle(rotation));
+    if (parent)
+        parent->invalidateRenderBounds();
 }
 
 void Node::modifyPositionByPhysics(sp::Vector3d position, Quaterniond rotation)
 {
-    translation = position;
-    this->rotation = rotation;
-    updateLocalTransform();
+    scene->transforms.setTranslation(transform_slot, position);
+    scene->transforms.setRotation(transform_slot, rotation);
+    if (parent)
+        parent->invalidateRenderBounds();
+}
+
+void Node::getRenderBounds(Vector3f& center, float& radius)
+{
+    const MeshData* mesh = render_data.mesh.get();
+    if (mesh != render_bounds_mesh || (mesh && render_data.mesh->getRevision() != render_bounds_mesh_revision) || render_data.scale != render_bounds_scale)
+        invalidateRenderBounds();
+    if (render_bounds_dirty)
+    {
+        render_bounds_mesh = mesh;
+        render_bounds_mesh_revision = mesh ? render_data.mesh->getRevision() : 0;
+        render_bounds_scale = render_data.scale;
+
+        if (!render_culling)
+        {
+            render_bounds_center = Vector3f(0, 0, 0);
+            render_bounds_radius = std::numeric_limits<float>::infinity();
+        }
+        else
+        {
+            render_data.getBoundingSphere(render_bounds_center, render_bounds_radius);
+        }
+
+        for(Node* child : children)
+        {
+            Vector3f child_center;
+            float child_radius;
+            child->getRenderBounds(child_center, child_radius);
+            if (child_radius < 0.0f || render_bounds_radius == std::numeric_limits<float>::infinity())
+                continue;
+            if (child_radius == std::numeric_limits<float>::infinity())
+            {
+                render_bounds_radius = child_radius;
+                continue;
+            }
+            //Node transforms are only rotation and translation, so the radius stays the same in our space.
+            child_center = child->getLocalTransform() * child_center;
+            if (render_bounds_radius < 0.0f)
+            {
+                render_bounds_center = child_center;
+                render_bounds_radius = child_radius;
+                continue;
+            }
+            Vector3f diff = child_center - render_bounds_center;
+            float distance = diff.length();
+            if (distance + child_radius <= render_bounds_radius)
+                continue;
+            if (distance + render_bounds_radius <= child_radius)
+            {
+                render_bounds_center = child_center;
+                render_bounds_radius = child_radius;
+                continue;
+            }
+            float new_radius = (distance + render_bounds_radius + child_radius) * 0.5f;
+            render_bounds_center += diff * ((new_radius - render_bounds_radius) / distance);
+            render_bounds_radius = new_radius;
+        }
+        //Cleared last, so children that find their mesh changed while we are updating do not walk up the whole tree.
+        render_bounds_dirty = false;
+    }
+    center = render_bounds_center;
+    radius = render_bounds_radius;
+}
+
+void Node::invalidateRenderBounds()
+{
+    //A dirty node always has dirty parents, so we can stop at the first dirty node.
+    for(Node* node = this; node && !node->render_bounds_dirty; node = *node->parent)
+    {
+        node->render_bounds_dirty = true;
+        node->render_static_dirty = true;
+    }
+}
+
+void Node::setRenderCulling(bool enabled)
+{
+    if (render_culling == enabled)
+        return;
+    render_culling = enabled;
+    invalidateRenderBounds();
+}
+
+void Node::setRenderStatic(bool enabled)
+{
+    render_static = enabled;
+    render_static_dirty = true;
+    if (!enabled)
+        static_render_data = nullptr;
+}
+
+class StaticRenderMerge
+{
+public:
+    RenderData data;
+    MeshData::Layout layout;
+    MeshData::Vertices vertices;
+    MeshData::Indices indices;
+
+    bool matches(const RenderData& other) const
+    {
+        return data.order == other.order && data.type == other.type && data.shader == other.shader && data.texture == other.texture
+            && layout == other.mesh->getLayout()
+            && data.color.r == other.color.r && data.color.g == other.color.g && data.color.b == other.color.b && data.color.a == other.color.a;
+    }
+
+    void flush(std::vector<RenderData>& merged)
+    {
+        if (vertices.empty())
+            return;
+        //Flat layouts drop the z position, which the node transforms can have moved the vertices out of.
+        if (layout == MeshData::Layout::Position2DUV || layout == MeshData::Layout::Position2DUVColor)
+        {
+            if (std::any_of(vertices.begin(), vertices.end(), [](const MeshData::Vertex& v) { return v.position.z != 0.0f; }))
+                layout = layout == MeshData::Layout::Position2DUV ? MeshData::Layout::PackedNormal : MeshData::Layout::Full;
+        }
+        merged.push_back(data);
+        merged.back().mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Static, layout);
+    }
+};
+
+static void mergeStaticRenderData(Node* node, const Matrix4x4f& transform, std::vector<StaticRenderMerge>& merges, Node::StaticRenderData& result)
+{
+    const RenderData& data = node->render_data;
+    if (data.type != RenderData::Type::None)
+    {
+        MeshData* mesh = data.mesh.get();
+        //Nodes with a lod chain stay separate, so they can still switch level.
+        bool mergeable = mesh && !data.lod && data.shader && data.shader->allowsBatching() && mesh->getType() == MeshData::Type::Static;
+        if (data.type != RenderData::Type::Normal && data.type != RenderData::Type::Transparent && data.type != RenderData::Type::Additive)
+            mergeable = false;
+        if (!mergeable)
+        {
+            result.unmerged.add(node);
+        }
+        else if (!mesh->getVertices().empty())
+        {
+            auto it = std::find_if(merges.begin(), merges.end(), [&data](const StaticRenderMerge& merge) { return merge.matches(data); });
+            if (it == merges.end())
+            {
+                merges.emplace_back();
+                it = merges.end() - 1;
+                it->data = data;
+                it->data.mesh = nullptr;
+                it->layout = mesh->getLayout();
+                it->data.scale = Vector3f(1, 1, 1);
+            }
+            uint32_t base = uint32_t(it->vertices.size());
+            for(const auto& v : mesh->getVertices())
+            {
+                Vector3f position(v.position.x * data.scale.x, v.position.y * data.scale.y, v.position.z * data.scale.z);
+                it->vertices.emplace_back(transform * position, transform.applyDirection(v.normal), v.uv);
+            }
+            for(uint32_t i : mesh->getIndices())
+                it->indices.push_back(base + i);
+        }
+    }
+
+    for(Node* child : node->getChildren())
+        mergeStaticRenderData(child, transform * child->getLocalTransform(), merges, result);
+}
+
+const Node::StaticRenderData& Node::getStaticRenderData()
+{
+    if (!static_render_data || render_static_dirty)
+    {
+        //Updating the bounds clears the dirty state of the whole subtree, so any later change marks this node dirty again.
+        Vector3f center;
+        float radius;
+        getRenderBounds(center, radius);
+
+        static_render_data = std::unique_ptr<StaticRenderData>(new StaticRenderData());
+        std::vector<StaticRenderMerge> merges;
+        mergeStaticRenderData(this, Matrix4x4f::identity(), merges, *static_render_data);
+        for(auto& merge : merges)
+            merge.flush(static_render_data->merged);
+        render_static_dirty = false;
+    }
+    return *static_render_data;
 }
 
 Node::Multiplayer::Multiplayer(Node* node)
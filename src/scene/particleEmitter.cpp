@@ -44,6 +44,9 @@ ParticleEmitter::ParticleEmitter(P<Node> parent, string resource_name)
 : sp::Node(parent), origin(Origin::Global)
 {
     render_data.type = RenderData::Type::Transparent;
+    setUpdateEnabled(true);
+    //Particles are drawn around the emitter by the shader, or in world space, so the mesh bounds do not match what is rendered.
+    setRenderCulling(false);
 
     auto tree = io::KeyValueTreeLoader::loadResource(resource_name);
     if (!tree)
@@ -130,6 +133,7 @@ ParticleEmitter::ParticleEmitter(P<Node> parent, int initial_buffer_size, Origin
 : sp::Node(parent), origin(origin)
 {
     particles.reserve(initial_buffer_size);
+    setUpdateEnabled(true);
     switch(origin)
     {
     case Origin::Global:
@@ -141,6 +145,7 @@ ParticleEmitter::ParticleEmitter(P<Node> parent, int initial_buffer_size, Origin
     }
     render_data.texture = texture_manager.get("particle.png");
     render_data.type = RenderData::Type::Transparent;
+    setRenderCulling(false);
     
     auto_destroy = false;
 }
@@ -219,7 +224,7 @@ void ParticleEmitter::onUpdate(float delta)
     }
     
     if (!render_data.mesh)
-        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Dynamic);
+        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices), MeshData::Type::Stream);
     else
         render_data.mesh->update(std::move(vertices), std::move(indices));
 }
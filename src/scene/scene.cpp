@@ -5,11 +5,12 @@
 #include <sp2/logging.h>
 #include <sp2/assert.h>
 
+#include <chrono>
 
 namespace sp {
 
 std::unordered_map<string, P<Scene>> Scene::scene_mapping;
-PList<Scene> Scene::scenes;
+PVector<Scene> Scene::scenes;
 
 Scene::Scene(const string& scene_name, int priority)
 : scene_name(scene_name), priority(priority)
@@ -62,9 +63,35 @@ void Scene::setDefaultCamera(P<Camera> camera)
 
 void Scene::update(float delta)
 {
-    if (root)
-        updateNode(delta, *root);
+    auto start_time = std::chrono::steady_clock::now();
+    //Index based loops, as nodes can be created or destroyed from the update functions.
+    auto& update_list = tick_lists[TickUpdate];
+    uint32_t tick = ++tick_counter[TickUpdate];
+    for(unsigned int n=0; n<update_list.size(); n++)
+    {
+        Node* node = update_list[n];
+        if (!node || node->last_tick[TickUpdate] == tick)
+            continue;
+        node->last_tick[TickUpdate] = tick;
+        node->onUpdate(delta);
+    }
+    compactTickList(TickUpdate);
+    auto& animation_list = tick_lists[TickAnimation];
+    tick = ++tick_counter[TickAnimation];
+    for(unsigned int n=0; n<animation_list.size(); n++)
+    {
+        Node* node = animation_list[n];
+        if (!node || node->last_tick[TickAnimation] == tick)
+            continue;
+        node->last_tick[TickAnimation] = tick;
+        node->animation->update(delta, node->render_data);
+    }
+    compactTickList(TickAnimation);
     onUpdate(delta);
+    if (root)
+        root->updateGlobalTransforms();
+    std::chrono::duration<float> time = std::chrono::steady_clock::now() - start_time;
+    last_update_timing.update = time.count();
 }
 
 bool Scene::onPointerMove(Ray3d ray, int id)
@@ -96,50 +123,71 @@ bool Scene::onWheelMove(Ray3d ray, io::Pointer::Wheel direction)
 
 void Scene::fixedUpdate()
 {
-    if (root)
-        fixedUpdateNode(*root);
+    auto start_time = std::chrono::steady_clock::now();
+    auto& fixed_update_list = tick_lists[TickFixedUpdate];
+    uint32_t tick = ++tick_counter[TickFixedUpdate];
+    for(unsigned int n=0; n<fixed_update_list.size(); n++)
+    {
+        Node* node = fixed_update_list[n];
+        if (!node || node->last_tick[TickFixedUpdate] == tick)
+            continue;
+        node->last_tick[TickFixedUpdate] = tick;
+        node->onFixedUpdate();
+    }
+    compactTickList(TickFixedUpdate);
     onFixedUpdate();
     if (collision_backend)
     {
         collision_backend->step(Engine::fixed_update_delta);
         collision_backend->postUpdate(0);
     }
+    std::chrono::duration<float> time = std::chrono::steady_clock::now() - start_time;
+    fixed_update_time_accumulator += time.count();
 }
 
 void Scene::postFixedUpdate(float delta)
 {
+    last_update_timing.fixed_update = fixed_update_time_accumulator;
+    fixed_update_time_accumulator = 0.0f;
     if (collision_backend)
         collision_backend->postUpdate(delta);
 }
 
-void Scene::updateNode(float delta, P<Node> node)
+void Scene::addToTickList(TickList list, Node* node)
 {
-    node->onUpdate(delta);
-    if (node && node->animation)
-        node->animation->update(delta, node->render_data);
-    if (node)
-    {
-        for(P<Node> child : node->children)
-        {
-            updateNode(delta, child);
-            if (!node)
-                break;
-        }
-    }
+    if (node->tick_list_index[list] >= 0)
+        return;
+    node->tick_list_index[list] = tick_lists[list].size();
+    tick_lists[list].push_back(node);
 }
 
-void Scene::fixedUpdateNode(P<Node> node)
+void Scene::removeFromTickList(TickList list, Node* node)
 {
-    node->onFixedUpdate();
-    if (node)
+    int index = node->tick_list_index[list];
+    if (index < 0)
+        return;
+    //Do not shift the list here, we could be iterating over it.
+    tick_lists[list][index] = nullptr;
+    tick_list_has_holes[list] = true;
+    node->tick_list_index[list] = -1;
+}
+
+void Scene::compactTickList(TickList list)
+{
+    if (!tick_list_has_holes[list])
+        return;
+    auto& nodes = tick_lists[list];
+    unsigned int count = 0;
+    for(Node* node : nodes)
     {
-        for(P<Node> child : node->children)
+        if (node)
         {
-            fixedUpdateNode(child);
-            if (!node)
-                break;
+            node->tick_list_index[list] = count;
+            nodes[count++] = node;
         }
     }
+    nodes.resize(count);
+    tick_list_has_holes[list] = false;
 }
 
 void Scene::queryCollision(sp::Vector2d position, double range, std::function<bool(P<Node> object)> callback_function)
@@ -28,10 +28,12 @@ Tilemap::Tilemap(P<Node> parent, const string& texture, float tile_width, float
     render_data.shader = Shader::get("internal:basic.shader");
     if (texture != "")
         render_data.texture = texture_manager.get(texture);
+    //Meshes and collision shapes are rebuilt from the fixed update.
+    setFixedUpdateEnabled(true);
     render_data.type = RenderData::Type::Normal;
     render_data.order = -1;
     
-    dirty = false;
+    collision_dirty = false;
 }
 
 void Tilemap::setTilemapSpacingMargin(float spacing, float margin)
@@ -40,7 +42,7 @@ void Tilemap::setTilemapSpacingMargin(float spacing, float margin)
     texture_spacing.y = spacing / (float(texture_tile_count.y) + spacing * float(texture_tile_count.y - 1));
     texture_margin = Vector2f(margin, margin);
     
-    dirty = true;
+    markAllChunksDirty();
 }
 
 void Tilemap::setTile(sp::Vector2i position, int index, Collision collision)
@@ -50,8 +52,10 @@ void Tilemap::setTile(sp::Vector2i position, int index, Collision collision)
 
 void Tilemap::setTile(sp::Vector2i position, int index, double z_offset, sp::Vector3f normal, Collision collision)
 {
+    if (tiles.get(position).collision != collision)
+        collision_dirty = true;
     tiles.set(position, {.index = index, .z_offset = z_offset, .normal = normal, .collision = collision});
-    dirty = true;
+    dirty_chunks.insert(tiles.chunkPosition(position));
 }
 
 int Tilemap::getTileIndex(sp::Vector2i position)
@@ -82,15 +86,48 @@ sp::Rect2i Tilemap::getEnclosingRect()
 
 void Tilemap::onFixedUpdate()
 {
-    if (!dirty)
-        return;
-    dirty = false;
-    updateMesh();
-    updateCollision();
+    if (render_data.shader != chunk_render_data.shader || render_data.texture != chunk_render_data.texture
+        || render_data.type != chunk_render_data.type || render_data.order != chunk_render_data.order
+        || render_data.color.r != chunk_render_data.color.r || render_data.color.g != chunk_render_data.color.g
+        || render_data.color.b != chunk_render_data.color.b || render_data.color.a != chunk_render_data.color.a)
+    {
+        applyRenderData(chunk_render_data);
+        for(auto& it : chunk_nodes)
+            applyRenderData(it.second->render_data);
+    }
+
+    for(auto chunk_position : dirty_chunks)
+        updateChunkMesh(chunk_position);
+    dirty_chunks.clear();
+    if (collision_dirty)
+    {
+        collision_dirty = false;
+        updateCollision();
+    }
 }
 
-void Tilemap::updateMesh()
+void Tilemap::markAllChunksDirty()
 {
+    tiles.forEachChunk([this](Vector2i chunk_position, const InfiniGrid<Tile>::Chunk&)
+    {
+        dirty_chunks.insert(chunk_position);
+    });
+}
+
+void Tilemap::applyRenderData(RenderData& data)
+{
+    data.shader = render_data.shader;
+    data.texture = render_data.texture;
+    data.type = render_data.type;
+    data.order = render_data.order;
+    data.color = render_data.color;
+}
+
+void Tilemap::updateChunkMesh(Vector2i chunk_position)
+{
+    const auto* chunk = tiles.getChunk(chunk_position);
+    auto node_it = chunk_nodes.find(chunk_position);
+
     Vector2f uv_step_size = Vector2f(
         (1.0 - texture_margin.x * 2.0f + texture_spacing.x) / float(texture_tile_count.x),
         (1.0 - texture_margin.y * 2.0f + texture_spacing.y) / float(texture_tile_count.y));
@@ -98,13 +135,16 @@ void Tilemap::updateMesh()
 
     MeshData::Vertices vertices;
     MeshData::Indices indices;
-    for(auto it : tiles) {
-        const auto& tile = it.data;
+    //Vertices are relative to the chunk node, which keeps them precise far away from the origin.
+    for(int n=0; chunk && n<tiles.chunk_size * tiles.chunk_size; n++) {
+        int x = n / tiles.chunk_size;
+        int y = n % tiles.chunk_size;
+        const auto& tile = chunk->data[x][y];
         if (tile.index < 0)
             continue;
         int tile_index = tile.index & ~(flip_horizontal | flip_vertical | flip_diagonal);
-        float px = it.position.x * tile_width;
-        float py = it.position.y * tile_height;
+        float px = x * tile_width;
+        float py = y * tile_height;
         int u = tile_index % texture_tile_count.x;
         int v = tile_index / texture_tile_count.x;
         float u0 = texture_margin.x + u * uv_step_size.x;
@@ -141,11 +181,25 @@ void Tilemap::updateMesh()
             vertices.emplace_back(Vector3f(px + tile_width, py + tile_height, tile.z_offset), tile.normal, Vector2f(u1, v0));
         }
     }
-    
-    if (!render_data.mesh)
-        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices));
+
+    if (indices.empty())
+    {
+        if (node_it != chunk_nodes.end())
+            node_it->second->render_data.mesh = nullptr;
+        return;
+    }
+    if (node_it == chunk_nodes.end())
+    {
+        P<Node> node = new Node(this);
+        node->setPosition(Vector2d(chunk_position.x * tiles.chunk_size * tile_width, chunk_position.y * tiles.chunk_size * tile_height));
+        applyRenderData(node->render_data);
+        node_it = chunk_nodes.emplace(chunk_position, node).first;
+    }
+    RenderData& data = node_it->second->render_data;
+    if (!data.mesh)
+        data.mesh = MeshData::create(std::move(vertices), std::move(indices));
     else
-        render_data.mesh->update(std::move(vertices), std::move(indices));
+        data.mesh->update(std::move(vertices), std::move(indices));
 }
 
 class TilemapCollisionBuilder
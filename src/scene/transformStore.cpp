@@ -0,0 +1,336 @@
+#include <sp2/scene/transformStore.h>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SP2_TRANSFORM_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SP2_TRANSFORM_NEON
+#endif
+
+namespace sp {
+
+#if defined(SP2_TRANSFORM_SSE)
+typedef __m128 Lane4;
+static inline Lane4 load4(const float* f) { return _mm_loadu_ps(f); }
+static inline void store4(float* f, Lane4 v) { _mm_storeu_ps(f, v); }
+static inline Lane4 set4(float f) { return _mm_set1_ps(f); }
+static inline Lane4 add4(Lane4 a, Lane4 b) { return _mm_add_ps(a, b); }
+static inline Lane4 sub4(Lane4 a, Lane4 b) { return _mm_sub_ps(a, b); }
+static inline Lane4 mul4(Lane4 a, Lane4 b) { return _mm_mul_ps(a, b); }
+static inline Lane4 div4(Lane4 a, Lane4 b) { return _mm_div_ps(a, b); }
+#elif defined(SP2_TRANSFORM_NEON)
+typedef float32x4_t Lane4;
+static inline Lane4 load4(const float* f) { return vld1q_f32(f); }
+static inline void store4(float* f, Lane4 v) { vst1q_f32(f, v); }
+static inline Lane4 set4(float f) { return vdupq_n_f32(f); }
+static inline Lane4 add4(Lane4 a, Lane4 b) { return vaddq_f32(a, b); }
+static inline Lane4 sub4(Lane4 a, Lane4 b) { return vsubq_f32(a, b); }
+static inline Lane4 mul4(Lane4 a, Lane4 b) { return vmulq_f32(a, b); }
+static inline Lane4 div4(Lane4 a, Lane4 b) { return vdivq_f32(a, b); }
+#else
+struct Lane4 { float v[4]; };
+static inline Lane4 load4(const float* f) { return {{f[0], f[1], f[2], f[3]}}; }
+static inline void store4(float* f, Lane4 v) { for(int n=0; n<4; n++) f[n] = v.v[n]; }
+static inline Lane4 set4(float f) { return {{f, f, f, f}}; }
+static inline Lane4 add4(Lane4 a, Lane4 b) { for(int n=0; n<4; n++) a.v[n] += b.v[n]; return a; }
+static inline Lane4 sub4(Lane4 a, Lane4 b) { for(int n=0; n<4; n++) a.v[n] -= b.v[n]; return a; }
+static inline Lane4 mul4(Lane4 a, Lane4 b) { for(int n=0; n<4; n++) a.v[n] *= b.v[n]; return a; }
+static inline Lane4 div4(Lane4 a, Lane4 b) { for(int n=0; n<4; n++) a.v[n] /= b.v[n]; return a; }
+#endif
+
+/* Build 4 local matrices from 4 translations and rotations.
+   Every lane is a different node, every output is one matrix element for all 4 nodes.
+   Same math as Matrix4x4f::translate(t) * Matrix4x4f::fromQuaternion(q)
+ */
+static inline void composeLocal4(const float in[7][4], float out[16][4])
+{
+    Lane4 x = load4(in[3]), y = load4(in[4]), z = load4(in[5]), w = load4(in[6]);
+    Lane4 one = set4(1.0f);
+    Lane4 s = div4(set4(2.0f), add4(add4(mul4(x, x), mul4(y, y)), add4(mul4(z, z), mul4(w, w))));
+
+    Lane4 xs = mul4(s, x), ys = mul4(s, y), zs = mul4(s, z);
+    Lane4 wx = mul4(w, xs), wy = mul4(w, ys), wz = mul4(w, zs);
+    Lane4 xx = mul4(x, xs), xy = mul4(x, ys), xz = mul4(x, zs);
+    Lane4 yy = mul4(y, ys), yz = mul4(y, zs), zz = mul4(z, zs);
+
+    Lane4 zero = set4(0.0f);
+    store4(out[0], sub4(one, add4(yy, zz)));
+    store4(out[1], add4(xy, wz));
+    store4(out[2], sub4(xz, wy));
+    store4(out[3], zero);
+    store4(out[4], sub4(xy, wz));
+    store4(out[5], sub4(one, add4(xx, zz)));
+    store4(out[6], add4(yz, wx));
+    store4(out[7], zero);
+    store4(out[8], add4(xz, wy));
+    store4(out[9], sub4(yz, wx));
+    store4(out[10], sub4(one, add4(xx, yy)));
+    store4(out[11], zero);
+    store4(out[12], load4(in[0]));
+    store4(out[13], load4(in[1]));
+    store4(out[14], load4(in[2]));
+    store4(out[15], one);
+}
+
+//result = a * b, column major, result may not alias a or b.
+static inline void multiply(const float* a, const float* b, float* result)
+{
+    Lane4 c0 = load4(a), c1 = load4(a + 4), c2 = load4(a + 8), c3 = load4(a + 12);
+    for(int n=0; n<4; n++)
+    {
+        const float* column = b + n * 4;
+        Lane4 r = mul4(c0, set4(column[0]));
+        r = add4(r, mul4(c1, set4(column[1])));
+        r = add4(r, mul4(c2, set4(column[2])));
+        r = add4(r, mul4(c3, set4(column[3])));
+        store4(result + n * 4, r);
+    }
+}
+
+void TransformStore::MatrixArray::emplace_back()
+{
+    if ((count & chunk_mask) == 0)
+        chunks.emplace_back(new Matrix4x4f[chunk_mask + 1]);
+    count++;
+}
+
+int TransformStore::create(int parent_slot)
+{
+    int slot;
+    if (!free_slots.empty())
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        slot = translation.size();
+        translation.emplace_back();
+        rotation.emplace_back();
+        tx.emplace_back(); ty.emplace_back(); tz.emplace_back();
+        qx.emplace_back(); qy.emplace_back(); qz.emplace_back(); qw.emplace_back();
+        local_transform.emplace_back();
+        global_transform.emplace_back();
+        parent.emplace_back();
+        first_child.emplace_back();
+        next_sibling.emplace_back();
+        previous_sibling.emplace_back();
+        depth.emplace_back();
+        flags.emplace_back();
+        version.emplace_back(0);
+        parent_version.emplace_back(0);
+    }
+    flags[slot] = 0;
+    first_child[slot] = -1;
+    link(slot, parent_slot);
+    updateDepth(slot);
+    setTranslation(slot, Vector3d(0, 0, 0));
+    setRotation(slot, Quaterniond());
+    return slot;
+}
+
+void TransformStore::destroy(int slot)
+{
+    unlink(slot);
+    //Children are normally destroyed first, any that are left become the top of their own hierarchy.
+    while(first_child[slot] >= 0)
+    {
+        int child = first_child[slot];
+        unlink(child);
+        link(child, -1);
+        updateDepth(child);
+        queue(child);
+    }
+    //Stale entries in the dirty lists are skipped, as they no longer have the queued flag.
+    flags[slot] = 0;
+    version[slot]++;
+    free_slots.push_back(slot);
+}
+
+void TransformStore::setParent(int slot, int parent_slot)
+{
+    unlink(slot);
+    link(slot, parent_slot);
+    updateDepth(slot);
+    flags[slot] |= FlagGlobalDirty;
+    queue(slot);
+}
+
+void TransformStore::setTranslation(int slot, const Vector3d& t)
+{
+    translation[slot] = t;
+    tx[slot] = t.x;
+    ty[slot] = t.y;
+    tz[slot] = t.z;
+    flags[slot] |= FlagLocalDirty | FlagGlobalDirty;
+    queue(slot);
+}
+
+void TransformStore::setRotation(int slot, const Quaterniond& q)
+{
+    rotation[slot] = q;
+    qx[slot] = q.x;
+    qy[slot] = q.y;
+    qz[slot] = q.z;
+    qw[slot] = q.w;
+    flags[slot] |= FlagLocalDirty | FlagGlobalDirty;
+    queue(slot);
+}
+
+const Matrix4x4f& TransformStore::getLocalTransform(int slot)
+{
+    if (flags[slot] & FlagLocalDirty)
+        updateLocalTransforms(&slot, 1);
+    return local_transform[slot];
+}
+
+const Matrix4x4f& TransformStore::getGlobalTransform(int slot)
+{
+    if (all_clean)
+        return global_transform[slot];
+    int parent_slot = parent[slot];
+    if (parent_slot >= 0)
+        getGlobalTransform(parent_slot);
+    //The children of a transform that was resolved on demand still need to be visited by the next update.
+    if (updateGlobalTransform(slot))
+        queue(slot);
+    return global_transform[slot];
+}
+
+void TransformStore::update()
+{
+    for(size_t level=0; level<dirty_levels.size(); level++)
+    {
+        //Take the list, as the children of this level are queued on the next level while we go.
+        global_update_list.clear();
+        std::swap(global_update_list, dirty_levels[level]);
+        auto end = std::remove_if(global_update_list.begin(), global_update_list.end(), [this, level](int slot) {
+            return !(flags[slot] & FlagQueued) || depth[slot] != int(level);
+        });
+        global_update_list.erase(end, global_update_list.end());
+
+        //First build all outdated local matrices of this level in batches, then combine them with the parent transforms.
+        local_update_list.clear();
+        for(int slot : global_update_list)
+            if (flags[slot] & FlagLocalDirty)
+                local_update_list.push_back(slot);
+        updateLocalTransforms(local_update_list.data(), local_update_list.size());
+
+        for(int slot : global_update_list)
+        {
+            flags[slot] &=~FlagQueued;
+            updateGlobalTransform(slot);
+            for(int child = first_child[slot]; child >= 0; child = next_sibling[child])
+                if (parent_version[child] != version[slot])
+                    queue(child);
+        }
+    }
+    all_clean = true;
+}
+
+void TransformStore::link(int slot, int parent_slot)
+{
+    parent[slot] = parent_slot;
+    previous_sibling[slot] = -1;
+    next_sibling[slot] = -1;
+    if (parent_slot < 0)
+        return;
+    next_sibling[slot] = first_child[parent_slot];
+    if (next_sibling[slot] >= 0)
+        previous_sibling[next_sibling[slot]] = slot;
+    first_child[parent_slot] = slot;
+}
+
+void TransformStore::unlink(int slot)
+{
+    if (previous_sibling[slot] >= 0)
+        next_sibling[previous_sibling[slot]] = next_sibling[slot];
+    else if (parent[slot] >= 0)
+        first_child[parent[slot]] = next_sibling[slot];
+    if (next_sibling[slot] >= 0)
+        previous_sibling[next_sibling[slot]] = previous_sibling[slot];
+    parent[slot] = -1;
+    previous_sibling[slot] = -1;
+    next_sibling[slot] = -1;
+}
+
+void TransformStore::updateDepth(int slot)
+{
+    int parent_slot = parent[slot];
+    int new_depth = parent_slot >= 0 ? depth[parent_slot] + 1 : 0;
+    if (depth[slot] == new_depth && parent_slot >= 0)
+        return;
+    depth[slot] = new_depth;
+    //Queued slots move to the dirty list of their new level.
+    if (flags[slot] & FlagQueued)
+    {
+        flags[slot] &=~FlagQueued;
+        queue(slot);
+    }
+    for(int child = first_child[slot]; child >= 0; child = next_sibling[child])
+        updateDepth(child);
+}
+
+void TransformStore::queue(int slot)
+{
+    if (flags[slot] & FlagQueued)
+        return;
+    flags[slot] |= FlagQueued;
+    all_clean = false;
+    if (int(dirty_levels.size()) <= depth[slot])
+        dirty_levels.resize(depth[slot] + 1);
+    dirty_levels[depth[slot]].push_back(slot);
+}
+
+void TransformStore::updateLocalTransforms(const int* slots, int count)
+{
+    float in[7][4];
+    float out[16][4];
+    for(int offset=0; offset<count; offset+=4)
+    {
+        int lanes = std::min(4, count - offset);
+        for(int lane=0; lane<4; lane++)
+        {
+            //Unused lanes repeat the last node, so the math never sees uninitialized data.
+            int slot = slots[offset + std::min(lane, lanes - 1)];
+            in[0][lane] = tx[slot];
+            in[1][lane] = ty[slot];
+            in[2][lane] = tz[slot];
+            in[3][lane] = qx[slot];
+            in[4][lane] = qy[slot];
+            in[5][lane] = qz[slot];
+            in[6][lane] = qw[slot];
+        }
+        composeLocal4(in, out);
+        for(int lane=0; lane<lanes; lane++)
+        {
+            int slot = slots[offset + lane];
+            float* data = local_transform[slot].data;
+            for(int n=0; n<16; n++)
+                data[n] = out[n][lane];
+            flags[slot] &=~FlagLocalDirty;
+        }
+    }
+}
+
+bool TransformStore::updateGlobalTransform(int slot)
+{
+    int parent_slot = parent[slot];
+    uint32_t current_parent_version = parent_slot >= 0 ? version[parent_slot] : 0;
+    if (!(flags[slot] & FlagGlobalDirty) && parent_version[slot] == current_parent_version)
+        return false;
+    const Matrix4x4f& local = getLocalTransform(slot);
+    if (parent_slot >= 0)
+        multiply(global_transform[parent_slot].data, local.data, global_transform[slot].data);
+    else
+        global_transform[slot] = local;
+    parent_version[slot] = current_parent_version;
+    flags[slot] &=~FlagGlobalDirty;
+    version[slot]++;
+    global_update_count++;
+    return true;
+}
+
+}//namespace sp
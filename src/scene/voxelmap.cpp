@@ -1,11 +1,57 @@
 #include <sp2/scene/voxelmap.h>
 #include <sp2/graphics/meshdata.h>
 #include <sp2/graphics/textureManager.h>
+#include <sp2/threading/jobSystem.h>
 #include <sp2/assert.h>
+#include <limits>
 
 
 namespace sp {
 
+//Everything besides the voxels that the mesh depends on, shared by the snapshots of all chunks until one of the settings changes.
+class Voxelmap::MeshSettings
+{
+public:
+    std::vector<Data> voxel_data;
+    Meshing meshing;
+    float voxel_size;
+    int texture_tile_count_x;
+    int texture_tile_count_y;
+};
+
+//Copy of the voxels of a chunk and a border of one voxel around it, so the mesh can be built on another thread while the map changes.
+class Voxelmap::ChunkSnapshot
+{
+public:
+    static constexpr int size = chunk_size + 2;
+
+    std::shared_ptr<const MeshSettings> settings;
+    int count;
+    int voxels[size * size * size];
+
+    int get(int x, int y, int z) const { return voxels[(x + 1) + ((y + 1) + (z + 1) * size) * size]; }
+    bool isSolid(int x, int y, int z) const
+    {
+        int index = get(x, y, z);
+        return index >= 0 && settings->voxel_data[index].solid;
+    }
+    void buildMesh(MeshData::Vertices& vertices, MeshData::Indices& indices) const;
+private:
+    void addQuad(MeshData::Vertices& vertices, MeshData::Indices& indices, int face, int tile, const Vector3f& offset, const int origin[3], const int extent[3]) const;
+};
+
+class Voxelmap::MeshJob
+{
+public:
+    Vector3i chunk_position;
+    int generation;
+    Meshing meshing;
+    std::unique_ptr<ChunkSnapshot> snapshot;
+    threading::JobSystem::Handle handle;
+    MeshData::Vertices vertices;
+    MeshData::Indices indices;
+};
+
 Voxelmap::Voxelmap(P<Node> parent, const string& texture, float voxel_size, int texture_tile_count)
 : Voxelmap(parent, texture, voxel_size, texture_tile_count, texture_tile_count)
 {
@@ -19,6 +65,8 @@ Voxelmap::Voxelmap(P<Node> parent, const string& texture, float voxel_size, int
         render_data.texture = texture_manager.get(texture);
     render_data.type = RenderData::Type::Normal;
     render_data.order = -1;
+    //The mesh and collision shape are rebuilt from the fixed update.
+    setFixedUpdateEnabled(true);
 }
 
 void Voxelmap::setVoxel(sp::Vector3i position, int index)
@@ -26,38 +74,45 @@ void Voxelmap::setVoxel(sp::Vector3i position, int index)
     sp2assert(position.x >= 0 && position.y >= 0 && position.z >= 0, "Voxel position needs to be positive");
     sp2assert(index >= -1 && index < int(voxel_data.size()), "Index must be -1 or set in the VoxelData");
     
-    sp::Vector3i old_size = getSize();
-    sp::Vector3i new_size(std::max(old_size.x, position.x + 1), std::max(old_size.y, position.y + 1), std::max(old_size.z, position.z + 1));
-    
-    if (old_size.z < new_size.z)
-    {
-        voxels.resize(new_size.z);
-        for(int z=old_size.z; z<new_size.z; z++)
-        {
-            voxels[z].resize(new_size.y);
-            for(int y=0; y<new_size.y; y++)
-                voxels[z][y].resize(new_size.x);
-        }
-    }
-    if (old_size.y < new_size.y)
+    size = Vector3i(std::max(size.x, position.x + 1), std::max(size.y, position.y + 1), std::max(size.z, position.z + 1));
+    Vector3i chunk_position(position.x / chunk_size, position.y / chunk_size, position.z / chunk_size);
+    if (chunk_position.x >= chunk_count.x || chunk_position.y >= chunk_count.y || chunk_position.z >= chunk_count.z)
     {
-        for(int z=0; z<old_size.z; z++)
-        {
-            voxels[z].resize(new_size.y);
-            for(int y=old_size.y; y<new_size.y; y++)
-                voxels[z][y].resize(new_size.x);
-        }
+        Vector3i new_count(std::max(chunk_count.x, chunk_position.x + 1), std::max(chunk_count.y, chunk_position.y + 1), std::max(chunk_count.z, chunk_position.z + 1));
+        std::vector<std::unique_ptr<Chunk>> new_chunks(new_count.x * new_count.y * new_count.z);
+        for(int z=0; z<chunk_count.z; z++)
+            for(int y=0; y<chunk_count.y; y++)
+                for(int x=0; x<chunk_count.x; x++)
+                    new_chunks[x + (y + z * new_count.y) * new_count.x] = std::move(chunks[x + (y + z * chunk_count.y) * chunk_count.x]);
+        chunks = std::move(new_chunks);
+        chunk_count = new_count;
     }
-    if (old_size.x < new_size.x)
+
+    auto& chunk = chunks[chunk_position.x + (chunk_position.y + chunk_position.z * chunk_count.y) * chunk_count.x];
+    if (!chunk)
     {
-        for(int z=0; z<old_size.z; z++)
-        {
-            for(int y=0; y<old_size.y; y++)
-                voxels[z][y].resize(new_size.x);
-        }
+        if (index < 0)
+            return;
+        chunk = std::unique_ptr<Chunk>(new Chunk());
     }
-    voxels[position.z][position.y][position.x].index = index;
-    dirty = true;
+    Vector3i local = position - chunk_position * chunk_size;
+    Voxel& voxel = chunk->voxels[local.x + (local.y + local.z * chunk_size) * chunk_size];
+    if (voxel.index == index)
+        return;
+    if (voxel.index < 0)
+        chunk->count++;
+    if (index < 0)
+        chunk->count--;
+    voxel.index = index;
+
+    //Faces on the border of a chunk are hidden or shown by the voxels of the neighbouring chunk.
+    markChunkDirty(chunk_position);
+    if (local.x == 0) markChunkDirty(chunk_position - Vector3i(1, 0, 0));
+    if (local.x == chunk_size - 1) markChunkDirty(chunk_position + Vector3i(1, 0, 0));
+    if (local.y == 0) markChunkDirty(chunk_position - Vector3i(0, 1, 0));
+    if (local.y == chunk_size - 1) markChunkDirty(chunk_position + Vector3i(0, 1, 0));
+    if (local.z == 0) markChunkDirty(chunk_position - Vector3i(0, 0, 1));
+    if (local.z == chunk_size - 1) markChunkDirty(chunk_position + Vector3i(0, 0, 1));
 }
 
 void Voxelmap::setVoxelData(int index, const Data& data)
@@ -66,14 +121,16 @@ void Voxelmap::setVoxelData(int index, const Data& data)
     if (int(voxel_data.size()) <= index)
         voxel_data.resize(index + 1);
     voxel_data[index] = data;
-    dirty = true;
+    mesh_settings = nullptr;
+    for(int z=0; z<chunk_count.z; z++)
+        for(int y=0; y<chunk_count.y; y++)
+            for(int x=0; x<chunk_count.x; x++)
+                markChunkDirty(Vector3i(x, y, z));
 }
 
 Vector3i Voxelmap::getSize()
 {
-    if (voxels.size() < 1)
-        return Vector3i(0, 0, 0);
-    return Vector3i(voxels[0][0].size(), voxels[0].size(), voxels.size());
+    return size;
 }
 
 bool Voxelmap::isSolid(sp::Vector3i position)
@@ -89,254 +146,601 @@ int Voxelmap::getVoxel(sp::Vector3i position)
 {
     if (position.x < 0 || position.y < 0 || position.z < 0)
         return -1;
-    sp::Vector3i size = getSize();
     if (position.x >= size.x || position.y >= size.y || position.z >= size.z)
         return -1;
-    Voxel& v = voxels[position.z][position.y][position.x];
-    return v.index;
+    Vector3i chunk_position(position.x / chunk_size, position.y / chunk_size, position.z / chunk_size);
+    Chunk* chunk = chunks[chunk_position.x + (chunk_position.y + chunk_position.z * chunk_count.y) * chunk_count.x].get();
+    if (!chunk)
+        return -1;
+    Vector3i local = position - chunk_position * chunk_size;
+    return chunk->voxels[local.x + (local.y + local.z * chunk_size) * chunk_size].index;
 }
 
 void Voxelmap::onFixedUpdate()
 {
-    if (!dirty)
-        return;
-    dirty = false;
-    updateMesh();
+    if (render_data.shader != chunk_render_data.shader || render_data.texture != chunk_render_data.texture
+        || render_data.type != chunk_render_data.type || render_data.order != chunk_render_data.order
+        || render_data.color.r != chunk_render_data.color.r || render_data.color.g != chunk_render_data.color.g
+        || render_data.color.b != chunk_render_data.color.b || render_data.color.a != chunk_render_data.color.a)
+    {
+        applyRenderData(chunk_render_data);
+        for(auto& chunk : chunks)
+            if (chunk && chunk->node)
+                applyRenderData(chunk->node->render_data);
+    }
+
+    meshDirtyChunks();
+    applyMeshJobs(false);
 }
 
-void Voxelmap::updateMesh()
+void Voxelmap::setBackgroundMeshing(bool enabled)
 {
-    float fu = 1.0 / float(texture_tile_count_x);
-    float fv = 1.0 / float(texture_tile_count_y);
+    background_meshing = enabled;
+}
 
-    float u_offset = 0.0;
-    float v_offset = 0.0;
+void Voxelmap::setMeshUploadBudget(int max_vertices)
+{
+    upload_budget = max_vertices;
+}
 
-    MeshData::Vertices vertices;
-    MeshData::Indices indices;
+void Voxelmap::finishMeshing()
+{
+    meshDirtyChunks();
+    applyMeshJobs(true);
+}
 
-    sp::Vector3i size = getSize();
-    for(int z=0; z<size.z; z++)
+void Voxelmap::meshDirtyChunks()
+{
+    if (dirty_chunks.empty())
+        return;
+    if (!mesh_settings)
     {
-        for(int y=0; y<size.y; y++)
+        auto settings = std::make_shared<MeshSettings>();
+        settings->voxel_data = voxel_data;
+        settings->meshing = meshing;
+        settings->voxel_size = voxel_size;
+        settings->texture_tile_count_x = texture_tile_count_x;
+        settings->texture_tile_count_y = texture_tile_count_y;
+        mesh_settings = settings;
+    }
+    for(Vector3i chunk_position : dirty_chunks)
+    {
+        Chunk* chunk = getChunk(chunk_position);
+        chunk->dirty = false;
+        chunk->generation++;
+
+        auto job = std::make_shared<MeshJob>();
+        job->chunk_position = chunk_position;
+        job->generation = chunk->generation;
+        job->meshing = mesh_settings->meshing;
+        job->snapshot = createSnapshot(chunk_position, *chunk);
+        if (background_meshing)
         {
-            for(int x=0; x<size.x; x++)
+            //The job only uses its own snapshot, so it can outlive the voxelmap.
+            job->handle = threading::JobSystem::submit([job]()
             {
-                Voxel& v = voxels[z][y][x];
-                if (v.index < 0)
-                    continue;
-                Data& d = voxel_data[v.index];
-                Vector3f p0(x * voxel_size, y * voxel_size, z * voxel_size);
-                
-                if (d.up_tile > -1 && !isSolid(sp::Vector3i(x, y, z + 1)))
-                {
-                    int u = d.up_tile % texture_tile_count_x;
-                    int v = d.up_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(0, 0, 1);
-                    vertices.emplace_back(p0 + Vector3f(0, 0, voxel_size - d.offset.z * voxel_size), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, 0, voxel_size - d.offset.z * voxel_size), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(0, voxel_size, voxel_size - d.offset.z * voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, voxel_size, voxel_size - d.offset.z * voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-                if (d.down_tile > -1 && !isSolid(sp::Vector3i(x, y, z - 1)))
-                {
-                    int u = d.down_tile % texture_tile_count_x;
-                    int v = d.down_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(0, 0, -1);
-                    vertices.emplace_back(p0 + Vector3f(0, voxel_size, d.offset.z * voxel_size), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, voxel_size, d.offset.z * voxel_size), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(0, 0, d.offset.z * voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, 0, d.offset.z * voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-                if (d.front_tile > -1 && !isSolid(sp::Vector3i(x, y - 1, z)))
-                {
-                    int u = d.front_tile % texture_tile_count_x;
-                    int v = d.front_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(0, -1, 0);
-                    vertices.emplace_back(p0 + Vector3f(0, d.offset.y * voxel_size, 0), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, d.offset.y * voxel_size, 0), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(0, d.offset.y * voxel_size, voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, d.offset.y * voxel_size, voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-                if (d.back_tile > -1 && !isSolid(sp::Vector3i(x, y + 1, z)))
-                {
-                    int u = d.back_tile % texture_tile_count_x;
-                    int v = d.back_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(0, 1, 0);
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, voxel_size - d.offset.y * voxel_size, 0), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(0, voxel_size - d.offset.y * voxel_size, 0), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size, voxel_size - d.offset.y * voxel_size, voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(0, voxel_size - d.offset.y * voxel_size, voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-                if (d.left_tile > -1 && !isSolid(sp::Vector3i(x - 1, y, z)))
-                {
-                    int u = d.left_tile % texture_tile_count_x;
-                    int v = d.left_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(-1, 0, 0);
-                    vertices.emplace_back(p0 + Vector3f(d.offset.x * voxel_size, voxel_size, 0), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(d.offset.x * voxel_size, 0, 0), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(d.offset.x * voxel_size, voxel_size, voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(d.offset.x * voxel_size, 0, voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-                if (d.right_tile > -1 && !isSolid(sp::Vector3i(x + 1, y, z)))
-                {
-                    int u = d.right_tile % texture_tile_count_x;
-                    int v = d.right_tile / texture_tile_count_x;
-
-                    indices.emplace_back(vertices.size() + 0);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 2);
-                    indices.emplace_back(vertices.size() + 1);
-                    indices.emplace_back(vertices.size() + 3);
-                    
-                    sp::Vector3f normal(1, 0, 0);
-                    vertices.emplace_back(p0 + Vector3f(voxel_size - d.offset.x * voxel_size, 0, 0), normal, Vector2f(u * fu + u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size - d.offset.x * voxel_size, voxel_size, 0), normal, Vector2f((u + 1) * fu - u_offset, (v + 1) * fv - v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size - d.offset.x * voxel_size, 0, voxel_size), normal, Vector2f(u * fu + u_offset, v * fv + v_offset));
-                    vertices.emplace_back(p0 + Vector3f(voxel_size - d.offset.x * voxel_size, voxel_size, voxel_size), normal, Vector2f((u + 1) * fu - u_offset, v * fv + v_offset));
-                }
-            }
+                job->snapshot->buildMesh(job->vertices, job->indices);
+                job->snapshot = nullptr;
+            });
+            mesh_jobs.push_back(job);
+        }
+        else
+        {
+            job->snapshot->buildMesh(job->vertices, job->indices);
+            chunk->applied_generation = job->generation;
+            applyChunkMesh(*job, *chunk);
         }
     }
-
-    if (!render_data.mesh)
-        render_data.mesh = MeshData::create(std::move(vertices), std::move(indices));
-    else
-        render_data.mesh->update(std::move(vertices), std::move(indices));
+    dirty_chunks.clear();
 }
 
-void Voxelmap::trace(const sp::Ray3d& ray, std::function<bool(sp::Vector3i, Face)> callback)
+void Voxelmap::applyMeshJobs(bool wait)
 {
-    sp::Vector3f start = (getGlobalTransform().inverse() * sp::Vector3f(ray.start)) / voxel_size;
-    sp::Vector3f end = (getGlobalTransform().inverse() * sp::Vector3f(ray.end)) / voxel_size;
-
-    float dx = std::abs(end.x - start.x);
-    float dy = std::abs(end.y - start.y);
-    float dz = std::abs(end.z - start.z);
+    int uploaded = 0;
+    size_t remaining = 0;
+    for(auto& job : mesh_jobs)
+    {
+        bool over_budget = upload_budget > 0 && uploaded >= upload_budget;
+        if (!wait && (over_budget || !threading::JobSystem::isDone(job->handle)))
+        {
+            mesh_jobs[remaining++] = job;
+            continue;
+        }
+        threading::JobSystem::wait(job->handle);
+        //Results of a chunk can arrive out of order, older results than the current mesh are dropped.
+        Chunk* chunk = getChunk(job->chunk_position);
+        if (job->generation <= chunk->applied_generation)
+            continue;
+        chunk->applied_generation = job->generation;
+        uploaded += job->vertices.size();
+        applyChunkMesh(*job, *chunk);
+    }
+    mesh_jobs.resize(remaining);
+}
 
-    sp::Vector3i position(std::floor(start.x), std::floor(start.y), std::floor(start.z));
-    float dt_dx = 1.0f / dx;
-    float dt_dy = 1.0f / dy;
-    float dt_dz = 1.0f / dz;
+Voxelmap::Chunk* Voxelmap::getChunk(Vector3i chunk_position)
+{
+    if (chunk_position.x < 0 || chunk_position.y < 0 || chunk_position.z < 0)
+        return nullptr;
+    if (chunk_position.x >= chunk_count.x || chunk_position.y >= chunk_count.y || chunk_position.z >= chunk_count.z)
+        return nullptr;
+    return chunks[chunk_position.x + (chunk_position.y + chunk_position.z * chunk_count.y) * chunk_count.x].get();
+}
 
-    int inc_x = std::signbit(end.x - start.x) ? -1 : 1;
-    int inc_y = std::signbit(end.y - start.y) ? -1 : 1;
-    int inc_z = std::signbit(end.z - start.z) ? -1 : 1;
+void Voxelmap::markChunkDirty(Vector3i chunk_position)
+{
+    //Chunks that were never allocated have no voxels, so no faces to update.
+    Chunk* chunk = getChunk(chunk_position);
+    if (!chunk || chunk->dirty)
+        return;
+    chunk->dirty = true;
+    dirty_chunks.push_back(chunk_position);
+}
 
-    int count = 0;
+void Voxelmap::applyRenderData(RenderData& data)
+{
+    data.shader = render_data.shader;
+    data.texture = render_data.texture;
+    data.type = render_data.type;
+    data.order = render_data.order;
+    data.color = render_data.color;
+}
 
-    float next_x, next_y, next_z;
-    if (dx == 0.0f)
-        next_x = dt_dx;
-    else if (start.x < end.x)
-        next_x = (std::floor(start.x) + 1 - start.x) * dt_dx;
-    else
-        next_x = (start.x - std::floor(start.x)) * dt_dx;
-    count += std::abs(int(end.x) - int(start.x));
-    if (dy == 0.0f)
-        next_y = dt_dy;
-    else if (start.y < end.y)
-        next_y = (std::floor(start.y) + 1 - start.y) * dt_dy;
-    else
-        next_y = (start.y - std::floor(start.y)) * dt_dy;
-    count += std::abs(int(end.y) - int(start.y));
-    if (dz == 0.0f)
-        next_z = dt_dz;
-    else if (start.z < end.z)
-        next_z = (std::floor(start.z) + 1 - start.z) * dt_dz;
-    else
-        next_z = (start.z - std::floor(start.z)) * dt_dz;
-    count += std::abs(int(end.z) - int(start.z));
+void Voxelmap::setMeshing(Meshing new_meshing)
+{
+    if (meshing == new_meshing)
+        return;
+    meshing = new_meshing;
+    mesh_settings = nullptr;
+    if (meshing == Meshing::Greedy && render_data.shader == Shader::get("internal:basic_shaded.shader"))
+        render_data.shader = Shader::get("internal:voxelmap_greedy.shader");
+    if (meshing == Meshing::PerFace && render_data.shader == Shader::get("internal:voxelmap_greedy.shader"))
+        render_data.shader = Shader::get("internal:basic_shaded.shader");
+    for(int z=0; z<chunk_count.z; z++)
+        for(int y=0; y<chunk_count.y; y++)
+            for(int x=0; x<chunk_count.x; x++)
+                markChunkDirty(Vector3i(x, y, z));
+}
 
-    for(; count > 0; count--)
+std::unique_ptr<Voxelmap::ChunkSnapshot> Voxelmap::createSnapshot(Vector3i chunk_position, Chunk& chunk)
+{
+    std::unique_ptr<ChunkSnapshot> snapshot(new ChunkSnapshot());
+    snapshot->settings = mesh_settings;
+    snapshot->count = chunk.count;
+    Vector3i base = chunk_position * chunk_size;
+    int* target = snapshot->voxels;
+    for(int z=-1; z<=chunk_size; z++)
     {
-        if (next_x < next_y && next_x < next_z)
+        for(int y=-1; y<=chunk_size; y++)
         {
-            position.x += inc_x;
-            next_x += dt_dx;
-            if (inc_x > 0)
+            bool inside = z >= 0 && z < chunk_size && y >= 0 && y < chunk_size;
+            *target++ = getVoxel(base + Vector3i(-1, y, z));
+            if (inside)
             {
-                if (!callback(position, Face::Left))
-                    return;
+                const Voxel* source = &chunk.voxels[(y + z * chunk_size) * chunk_size];
+                for(int x=0; x<chunk_size; x++)
+                    *target++ = source[x].index;
             }
             else
             {
-                if (!callback(position, Face::Right))
-                    return;
+                for(int x=0; x<chunk_size; x++)
+                    *target++ = getVoxel(base + Vector3i(x, y, z));
             }
+            *target++ = getVoxel(base + Vector3i(chunk_size, y, z));
+        }
+    }
+    return snapshot;
+}
+
+void Voxelmap::applyChunkMesh(MeshJob& job, Chunk& chunk)
+{
+    if (job.indices.empty())
+    {
+        if (chunk.node)
+            chunk.node->render_data.mesh = nullptr;
+        return;
+    }
+    if (!chunk.node)
+    {
+        Vector3i base = job.chunk_position * chunk_size;
+        chunk.node = new Node(this);
+        chunk.node->setPosition(Vector3d(base.x * voxel_size, base.y * voxel_size, base.z * voxel_size));
+        applyRenderData(chunk.node->render_data);
+    }
+    //Greedy quads repeat their tile, so their uv goes past 1 and needs floats.
+    MeshData::Layout layout = job.meshing == Meshing::Greedy ? MeshData::Layout::PackedNormalTile : MeshData::Layout::PackedNormalUV;
+    RenderData& data = chunk.node->render_data;
+    if (!data.mesh || data.mesh->getLayout() != layout)
+        data.mesh = MeshData::create(std::move(job.vertices), std::move(job.indices), MeshData::Type::Static, layout);
+    else
+        data.mesh->update(std::move(job.vertices), std::move(job.indices));
+}
+
+//Corners of a face of a unit voxel, in the order of Voxelmap::Face. The corners have the uvs (0, 1), (1, 1), (0, 0) and (1, 0) within the tile.
+class VoxelFace
+{
+public:
+    int normal_axis;
+    int normal;
+    //Axes along which the u and v of the tile run.
+    int u_axis;
+    int v_axis;
+    int corners[4][3];
+};
+static const VoxelFace voxel_faces[6] = {
+    {2, 1, 0, 1, {{0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}}},//Up
+    {2, -1, 0, 1, {{0, 1, 0}, {1, 1, 0}, {0, 0, 0}, {1, 0, 0}}},//Down
+    {0, -1, 1, 2, {{0, 1, 0}, {0, 0, 0}, {0, 1, 1}, {0, 0, 1}}},//Left
+    {0, 1, 1, 2, {{1, 0, 0}, {1, 1, 0}, {1, 0, 1}, {1, 1, 1}}},//Right
+    {1, -1, 0, 2, {{0, 0, 0}, {1, 0, 0}, {0, 0, 1}, {1, 0, 1}}},//Front
+    {1, 1, 0, 2, {{1, 1, 0}, {0, 1, 0}, {1, 1, 1}, {0, 1, 1}}},//Back
+};
+static const float voxel_face_uv[4][2] = {{0, 1}, {1, 1}, {0, 0}, {1, 0}};
+
+static int getFaceTile(const Voxelmap::Data& data, int face)
+{
+    switch(Voxelmap::Face(face))
+    {
+    case Voxelmap::Face::Up: return data.up_tile;
+    case Voxelmap::Face::Down: return data.down_tile;
+    case Voxelmap::Face::Left: return data.left_tile;
+    case Voxelmap::Face::Right: return data.right_tile;
+    case Voxelmap::Face::Front: return data.front_tile;
+    case Voxelmap::Face::Back: return data.back_tile;
+    }
+    return -1;
+}
+
+void Voxelmap::ChunkSnapshot::addQuad(MeshData::Vertices& vertices, MeshData::Indices& indices, int face, int tile, const Vector3f& offset, const int origin[3], const int extent[3]) const
+{
+    const VoxelFace& f = voxel_faces[face];
+    const float offsets[3] = {offset.x, offset.y, offset.z};
+    int tile_u = tile % settings->texture_tile_count_x;
+    int tile_v = tile / settings->texture_tile_count_x;
+
+    indices.emplace_back(vertices.size() + 0);
+    indices.emplace_back(vertices.size() + 1);
+    indices.emplace_back(vertices.size() + 2);
+    indices.emplace_back(vertices.size() + 2);
+    indices.emplace_back(vertices.size() + 1);
+    indices.emplace_back(vertices.size() + 3);
+
+    Vector3f normal(f.normal_axis == 0 ? f.normal : 0, f.normal_axis == 1 ? f.normal : 0, f.normal_axis == 2 ? f.normal : 0);
+    for(int n=0; n<4; n++)
+    {
+        float p[3];
+        for(int axis=0; axis<3; axis++)
+        {
+            if (axis == f.normal_axis)
+                p[axis] = float(origin[axis]) + (f.corners[n][axis] ? 1.0f - offsets[axis] : offsets[axis]);
+            else
+                p[axis] = float(origin[axis] + f.corners[n][axis] * extent[axis]);
+        }
+        if (settings->meshing == Meshing::Greedy)
+        {
+            //The uv counts the tile repeats over the quad, the shader wraps it within the tile.
+            Vector2f uv(voxel_face_uv[n][0] * extent[f.u_axis], voxel_face_uv[n][1] * extent[f.v_axis]);
+            vertices.emplace_back(Vector3f(p[0], p[1], p[2]) * settings->voxel_size, normal, uv);
+            MeshData::Vertex& vertex = vertices.back();
+            vertex.tile[0] = uint8_t(tile_u);
+            vertex.tile[1] = uint8_t(tile_v);
+            vertex.tile[2] = uint8_t(settings->texture_tile_count_x);
+            vertex.tile[3] = uint8_t(settings->texture_tile_count_y);
         }
-        else if (next_y < next_z)
+        else
         {
-            position.y += inc_y;
-            next_y += dt_dy;
-            if (inc_y > 0)
+            Vector2f uv((tile_u + voxel_face_uv[n][0]) / float(settings->texture_tile_count_x), (tile_v + voxel_face_uv[n][1]) / float(settings->texture_tile_count_y));
+            vertices.emplace_back(Vector3f(p[0], p[1], p[2]) * settings->voxel_size, normal, uv);
+        }
+    }
+}
+
+void Voxelmap::ChunkSnapshot::buildMesh(MeshData::Vertices& vertices, MeshData::Indices& indices) const
+{
+    if (count < 1)
+        return;
+    //Vertices are relative to the chunk node.
+    if (settings->meshing == Meshing::PerFace)
+    {
+        for(int z=0; z<chunk_size; z++)
+        {
+            for(int y=0; y<chunk_size; y++)
             {
-                if (!callback(position, Face::Front))
-                    return;
+                for(int x=0; x<chunk_size; x++)
+                {
+                    int index = get(x, y, z);
+                    if (index < 0)
+                        continue;
+                    const Data& d = settings->voxel_data[index];
+                    const int origin[3] = {x, y, z};
+                    const int extent[3] = {1, 1, 1};
+                    for(int face=0; face<6; face++)
+                    {
+                        const VoxelFace& f = voxel_faces[face];
+                        int tile = getFaceTile(d, face);
+                        int neighbour[3] = {x, y, z};
+                        neighbour[f.normal_axis] += f.normal;
+                        if (tile > -1 && !isSolid(neighbour[0], neighbour[1], neighbour[2]))
+                            addQuad(vertices, indices, face, tile, d.offset, origin, extent);
+                    }
+                }
             }
-            else
+        }
+    }
+    if (settings->meshing == Meshing::Greedy)
+    {
+        sp2assert(settings->texture_tile_count_x < 256 && settings->texture_tile_count_y < 256, "Greedy voxel meshing supports at most 255x255 texture tiles, the tile is stored as bytes");
+        //Every slice of the chunk along the face normal is turned into a mask of visible faces, which is covered with as large as possible rectangles.
+        class MaskEntry
+        {
+        public:
+            int tile;
+            float offset;
+
+            bool operator==(const MaskEntry& other) const { return tile == other.tile && offset == other.offset; }
+        };
+        MaskEntry mask[chunk_size * chunk_size];
+        for(int face=0; face<6; face++)
+        {
+            const VoxelFace& f = voxel_faces[face];
+            for(int slice=0; slice<chunk_size; slice++)
             {
-                if (!callback(position, Face::Back))
-                    return;
+                for(int v=0; v<chunk_size; v++)
+                {
+                    for(int u=0; u<chunk_size; u++)
+                    {
+                        int p[3];
+                        p[f.normal_axis] = slice;
+                        p[f.u_axis] = u;
+                        p[f.v_axis] = v;
+                        MaskEntry& entry = mask[u + v * chunk_size];
+                        entry.tile = -1;
+                        int index = get(p[0], p[1], p[2]);
+                        if (index < 0)
+                            continue;
+                        const Data& d = settings->voxel_data[index];
+                        int tile = getFaceTile(d, face);
+                        p[f.normal_axis] += f.normal;
+                        if (tile > -1 && !isSolid(p[0], p[1], p[2]))
+                        {
+                            const float offsets[3] = {d.offset.x, d.offset.y, d.offset.z};
+                            entry.tile = tile;
+                            entry.offset = offsets[f.normal_axis];
+                        }
+                    }
+                }
+                for(int v=0; v<chunk_size; v++)
+                {
+                    for(int u=0; u<chunk_size; u++)
+                    {
+                        MaskEntry entry = mask[u + v * chunk_size];
+                        if (entry.tile < 0)
+                            continue;
+                        int width = 1;
+                        while(u + width < chunk_size && mask[u + width + v * chunk_size] == entry)
+                            width++;
+                        int height = 1;
+                        for(; v + height < chunk_size; height++)
+                        {
+                            bool row_matches = true;
+                            for(int n=0; n<width && row_matches; n++)
+                                row_matches = mask[u + n + (v + height) * chunk_size] == entry;
+                            if (!row_matches)
+                                break;
+                        }
+                        for(int h=0; h<height; h++)
+                            for(int n=0; n<width; n++)
+                                mask[u + n + (v + h) * chunk_size].tile = -1;
+
+                        int origin[3];
+                        origin[f.normal_axis] = slice;
+                        origin[f.u_axis] = u;
+                        origin[f.v_axis] = v;
+                        int extent[3];
+                        extent[f.normal_axis] = 1;
+                        extent[f.u_axis] = width;
+                        extent[f.v_axis] = height;
+                        float offsets[3] = {0, 0, 0};
+                        offsets[f.normal_axis] = entry.offset;
+                        addQuad(vertices, indices, face, entry.tile, Vector3f(offsets[0], offsets[1], offsets[2]), origin, extent);
+                    }
+                }
             }
         }
+    }
+}
+
+//Amanatides-Woo traversal of the voxels between start and end, in voxel coordinates.
+//Calls the callback for every voxel that is entered after the start voxel, with the face it is entered through and the fraction of the ray at that point.
+template<typename F> static void walkVoxels(Vector3d start, Vector3d end, F&& callback)
+{
+    static const Voxelmap::Face enter_faces[3][2] = {
+        {Voxelmap::Face::Left, Voxelmap::Face::Right},
+        {Voxelmap::Face::Front, Voxelmap::Face::Back},
+        {Voxelmap::Face::Down, Voxelmap::Face::Up},
+    };
+    const double s[3] = {start.x, start.y, start.z};
+    const double d[3] = {end.x - start.x, end.y - start.y, end.z - start.z};
+    int p[3];
+    int step[3];
+    double t_max[3];
+    double t_delta[3];
+    for(int axis=0; axis<3; axis++)
+    {
+        p[axis] = int(std::floor(s[axis]));
+        if (d[axis] > 0.0)
+        {
+            step[axis] = 1;
+            t_delta[axis] = 1.0 / d[axis];
+            t_max[axis] = (p[axis] + 1 - s[axis]) * t_delta[axis];
+        }
+        else if (d[axis] < 0.0)
+        {
+            step[axis] = -1;
+            t_delta[axis] = -1.0 / d[axis];
+            t_max[axis] = (s[axis] - p[axis]) * t_delta[axis];
+        }
         else
         {
-            position.z += inc_z;
-            next_z += dt_dz;
-            if (inc_z > 0)
-            {
-                if (!callback(position, Face::Down))
-                    return;
-            }
-            else
+            step[axis] = 0;
+            t_delta[axis] = t_max[axis] = std::numeric_limits<double>::infinity();
+        }
+    }
+    while(true)
+    {
+        int axis = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2) : (t_max[1] < t_max[2] ? 1 : 2);
+        double t = t_max[axis];
+        if (t > 1.0)
+            return;
+        p[axis] += step[axis];
+        t_max[axis] += t_delta[axis];
+        if (!callback(Vector3i(p[0], p[1], p[2]), enter_faces[axis][step[axis] > 0 ? 0 : 1], t))
+            return;
+    }
+}
+
+bool Voxelmap::raycast(const Ray3d& ray, RayHit& hit)
+{
+    Matrix4x4f inverse = getGlobalTransform().inverse();
+    Vector3d start = Vector3d(inverse * Vector3f(ray.start)) / double(voxel_size);
+    Vector3d end = Vector3d(inverse * Vector3f(ray.end)) / double(voxel_size);
+    Vector3d direction = end - start;
+    double length = direction.length();
+    if (length <= 0.0)
+        return false;
+
+    //Clip the ray to the map, starting a voxel early so the first voxel inside the map is not skipped as start voxel.
+    double t_start = 0.0;
+    double t_end = 1.0;
+    const double s[3] = {start.x, start.y, start.z};
+    const double d[3] = {direction.x, direction.y, direction.z};
+    const int map_size[3] = {size.x, size.y, size.z};
+    for(int axis=0; axis<3; axis++)
+    {
+        if (d[axis] == 0.0)
+        {
+            if (s[axis] < 0.0 || s[axis] > map_size[axis])
+                return false;
+            continue;
+        }
+        double t0 = (0.0 - s[axis]) / d[axis];
+        double t1 = (map_size[axis] - s[axis]) / d[axis];
+        t_start = std::max(t_start, std::min(t0, t1));
+        t_end = std::min(t_end, std::max(t0, t1));
+    }
+    if (t_start > t_end)
+        return false;
+    if (t_start > 0.0)
+        t_start = std::max(0.0, t_start - 1.0 / length);
+    t_end = std::min(1.0, t_end + 1.0 / length);
+
+    bool found = false;
+    walkVoxels(start + direction * t_start, start + direction * t_end, [&](Vector3i position, Face face, double t)
+    {
+        if (!isSolid(position))
+            return true;
+        found = true;
+        hit.voxel = position;
+        hit.face = face;
+        hit.distance = (t_start + t * (t_end - t_start)) * (ray.end - ray.start).length();
+        return false;
+    });
+    if (!found)
+        return false;
+    Vector3f normal;
+    switch(hit.face)
+    {
+    case Face::Up: normal = Vector3f(0, 0, 1); break;
+    case Face::Down: normal = Vector3f(0, 0, -1); break;
+    case Face::Left: normal = Vector3f(-1, 0, 0); break;
+    case Face::Right: normal = Vector3f(1, 0, 0); break;
+    case Face::Front: normal = Vector3f(0, -1, 0); break;
+    case Face::Back: normal = Vector3f(0, 1, 0); break;
+    }
+    hit.normal = Vector3d(getGlobalTransform().applyDirection(normal));
+    return true;
+}
+
+void Voxelmap::trace(const sp::Ray3d& ray, std::function<bool(sp::Vector3i, Face)> callback)
+{
+    Matrix4x4f inverse = getGlobalTransform().inverse();
+    Vector3d start = Vector3d(inverse * Vector3f(ray.start)) / double(voxel_size);
+    Vector3d end = Vector3d(inverse * Vector3f(ray.end)) / double(voxel_size);
+    walkVoxels(start, end, [&callback](Vector3i position, Face face, double t)
+    {
+        return callback(position, face);
+    });
+}
+
+template<typename F> void Voxelmap::queryRange(Vector3i min, Vector3i max, F&& callback)
+{
+    min = Vector3i(std::max(min.x, 0), std::max(min.y, 0), std::max(min.z, 0));
+    max = Vector3i(std::min(max.x, size.x - 1), std::min(max.y, size.y - 1), std::min(max.z, size.z - 1));
+    if (min.x > max.x || min.y > max.y || min.z > max.z)
+        return;
+    for(int cz=min.z / chunk_size; cz<=max.z / chunk_size; cz++)
+    {
+        for(int cy=min.y / chunk_size; cy<=max.y / chunk_size; cy++)
+        {
+            for(int cx=min.x / chunk_size; cx<=max.x / chunk_size; cx++)
             {
-                if (!callback(position, Face::Up))
-                    return;
+                Chunk* chunk = getChunk(Vector3i(cx, cy, cz));
+                if (!chunk || chunk->count < 1)
+                    continue;
+                Vector3i base(cx * chunk_size, cy * chunk_size, cz * chunk_size);
+                Vector3i from(std::max(min.x, base.x), std::max(min.y, base.y), std::max(min.z, base.z));
+                Vector3i to(std::min(max.x, base.x + chunk_size - 1), std::min(max.y, base.y + chunk_size - 1), std::min(max.z, base.z + chunk_size - 1));
+                for(int z=from.z; z<=to.z; z++)
+                {
+                    for(int y=from.y; y<=to.y; y++)
+                    {
+                        for(int x=from.x; x<=to.x; x++)
+                        {
+                            int index = chunk->voxels[(x - base.x) + ((y - base.y) + (z - base.z) * chunk_size) * chunk_size].index;
+                            if (index < 0 || !voxel_data[index].solid)
+                                continue;
+                            if (!callback(Vector3i(x, y, z)))
+                                return;
+                        }
+                    }
+                }
             }
         }
     }
 }
 
+void Voxelmap::queryBox(Vector3d min, Vector3d max, std::function<bool(Vector3i)> callback)
+{
+    Matrix4x4f inverse = getGlobalTransform().inverse();
+    Vector3d local_min(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+    Vector3d local_max = -local_min;
+    for(int n=0; n<8; n++)
+    {
+        Vector3d corner(n & 1 ? max.x : min.x, n & 2 ? max.y : min.y, n & 4 ? max.z : min.z);
+        Vector3d p = Vector3d(inverse * Vector3f(corner)) / double(voxel_size);
+        local_min = Vector3d(std::min(local_min.x, p.x), std::min(local_min.y, p.y), std::min(local_min.z, p.z));
+        local_max = Vector3d(std::max(local_max.x, p.x), std::max(local_max.y, p.y), std::max(local_max.z, p.z));
+    }
+    //Voxels that only touch the box are not included.
+    Vector3i from(int(std::floor(local_min.x)), int(std::floor(local_min.y)), int(std::floor(local_min.z)));
+    Vector3i to(int(std::ceil(local_max.x)) - 1, int(std::ceil(local_max.y)) - 1, int(std::ceil(local_max.z)) - 1);
+    queryRange(from, to, callback);
+}
+
+void Voxelmap::querySphere(Vector3d center, double radius, std::function<bool(Vector3i)> callback)
+{
+    Vector3d c = Vector3d(getGlobalTransform().inverse() * Vector3f(center)) / double(voxel_size);
+    double r = radius / voxel_size;
+    Vector3i from(int(std::floor(c.x - r)), int(std::floor(c.y - r)), int(std::floor(c.z - r)));
+    Vector3i to(int(std::ceil(c.x + r)) - 1, int(std::ceil(c.y + r)) - 1, int(std::ceil(c.z + r)) - 1);
+    queryRange(from, to, [&](Vector3i position)
+    {
+        //Distance from the center to the closest point of the voxel.
+        Vector3d closest(std::max(double(position.x), std::min(c.x, position.x + 1.0)), std::max(double(position.y), std::min(c.y, position.y + 1.0)), std::max(double(position.z), std::min(c.z, position.z + 1.0)));
+        if ((closest - c).dot(closest - c) >= r * r)
+            return true;
+        return callback(position);
+    });
+}
+
 }//namespace sp
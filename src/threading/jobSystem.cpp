@@ -0,0 +1,262 @@
+#include <sp2/threading/jobSystem.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <chrono>
+
+namespace sp {
+namespace threading {
+
+static constexpr int priority_count = 3;
+
+class JobSystem::Job
+{
+public:
+    std::function<void()> function;
+    Priority priority;
+    std::atomic<int> pending_dependencies{1};
+
+    std::mutex mutex;
+    bool done = false;
+    std::vector<Handle> continuations;
+};
+
+namespace {
+class Worker
+{
+public:
+    std::mutex mutex;
+    //Owner pushes and pops at the back, thieves take from the front.
+    std::deque<JobSystem::Handle> queues[priority_count];
+    std::thread thread;
+};
+}
+
+static std::once_flag start_flag;
+static std::vector<std::unique_ptr<Worker>> workers;
+static std::atomic<int> queued_jobs{0};
+static std::atomic<unsigned int> next_worker{0};
+static std::mutex sleep_mutex;
+static std::condition_variable sleep_condition;
+static std::condition_variable done_condition;
+static bool running = true;
+static thread_local int current_worker = -1;
+
+static bool popJob(int index, JobSystem::Handle& job, int max_priority=priority_count - 1)
+{
+    int count = workers.size();
+    for(int priority=0; priority<=max_priority; priority++)
+    {
+        if (index >= 0)
+        {
+            Worker& worker = *workers[index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (!queue.empty())
+            {
+                job = std::move(queue.back());
+                queue.pop_back();
+                queued_jobs--;
+                return true;
+            }
+        }
+        for(int n=1; n<=count; n++)
+        {
+            int victim = (std::max(index, 0) + n) % count;
+            if (victim == index)
+                continue;
+            Worker& worker = *workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (!queue.empty())
+            {
+                job = std::move(queue.front());
+                queue.pop_front();
+                queued_jobs--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void schedule(const JobSystem::Handle& job);
+
+static void runJob(const JobSystem::Handle& job)
+{
+    job->function();
+    job->function = nullptr;
+
+    std::vector<JobSystem::Handle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->done = true;
+        continuations.swap(job->continuations);
+    }
+    for(auto& continuation : continuations)
+    {
+        if (--continuation->pending_dependencies == 0)
+            schedule(continuation);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    done_condition.notify_all();
+}
+
+static void schedule(const JobSystem::Handle& job)
+{
+    bool inline_job;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        inline_job = workers.empty() || !running;
+    }
+    if (inline_job)
+    {
+        runJob(job);
+        return;
+    }
+
+    int index = current_worker;
+    if (index < 0)
+        index = next_worker++ % workers.size();
+    queued_jobs++;
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[int(job->priority)].push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    sleep_condition.notify_one();
+}
+
+static void workerMain(int index)
+{
+    current_worker = index;
+    while(true)
+    {
+        JobSystem::Handle job;
+        if (popJob(index, job))
+        {
+            runJob(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_condition.wait(lock, []() { return queued_jobs > 0 || !running; });
+        if (!running)
+            return;
+    }
+}
+
+static void stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running = false;
+    }
+    sleep_condition.notify_all();
+    for(auto& worker : workers)
+        worker->thread.join();
+}
+
+static void startWorkers()
+{
+    std::call_once(start_flag, []()
+    {
+#ifndef __EMSCRIPTEN__
+        //emscripten has very limited threading support, so jobs are run directly on submit.
+        int count = std::thread::hardware_concurrency();
+        //Leave one core for the main thread.
+        count = std::max(1, count - 1);
+        for(int n=0; n<count; n++)
+            workers.emplace_back(new Worker());
+        for(int n=0; n<count; n++)
+            workers[n]->thread = std::thread(workerMain, n);
+        atexit(stopWorkers);
+#endif
+    });
+}
+
+JobSystem::Handle JobSystem::submit(std::function<void()> function, Priority priority)
+{
+    return submit(std::move(function), {}, priority);
+}
+
+JobSystem::Handle JobSystem::submit(std::function<void()> function, const std::vector<Handle>& dependencies, Priority priority)
+{
+    startWorkers();
+
+    Handle job = std::make_shared<Job>();
+    job->function = std::move(function);
+    job->priority = priority;
+    job->pending_dependencies = dependencies.size() + 1;
+    for(auto& dependency : dependencies)
+    {
+        if (dependency)
+        {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+            if (!dependency->done)
+            {
+                dependency->continuations.push_back(job);
+                continue;
+            }
+        }
+        job->pending_dependencies--;
+    }
+    if (--job->pending_dependencies == 0)
+        schedule(job);
+    return job;
+}
+
+bool JobSystem::isDone(const Handle& handle)
+{
+    if (!handle)
+        return true;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->done;
+}
+
+void JobSystem::wait(const Handle& handle)
+{
+    //The worker list is only filled once by startWorkers, call_once makes that visible to this thread before it is read below.
+    startWorkers();
+    while(!isDone(handle))
+    {
+        Handle job;
+        //Do not let the main thread pick up background work while waiting, as that could stall it for a long time.
+        //Workers do help with everything, else a worker waiting on low priority jobs could deadlock the pool.
+        int max_priority = current_worker >= 0 ? int(Priority::Low) : int(Priority::Normal);
+        if (!workers.empty() && popJob(current_worker, job, max_priority))
+        {
+            runJob(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        done_condition.wait_for(lock, std::chrono::milliseconds(1), [&handle]() { return isDone(handle); });
+    }
+}
+
+void JobSystem::wait(const std::vector<Handle>& handles)
+{
+    for(auto& handle : handles)
+        wait(handle);
+}
+
+int JobSystem::getWorkerCount()
+{
+    startWorkers();
+    return workers.size();
+}
+
+bool JobSystem::isWorkerThread()
+{
+    return current_worker >= 0;
+}
+
+}//namespace threading
+}//namespace sp
@@ -2,7 +2,7 @@
 
 namespace sp {
 
-PList<Updatable> Updatable::updatables;
+PVector<Updatable> Updatable::updatables;
 
 Updatable::Updatable()
 {
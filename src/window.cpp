@@ -350,7 +350,12 @@ void Window::createRenderWindow()
         SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 0);
     }
 
+#ifdef SP2_NULL_OPENGL
+    //Without OpenGL the window is only used for input, so it can be created on a dummy video driver.
+    int flags = 0;
+#else
     int flags = SDL_WINDOW_OPENGL;
+#endif
     if (fullscreen)
         flags |= SDL_WINDOW_FULLSCREEN;
     else if (window_aspect_ratio == 0.0 && (max_window_size_ratio.x == 0.0 || max_window_size_ratio.y == 0.0))
@@ -372,7 +377,12 @@ void Window::createRenderWindow()
 
     if (!shared_render_context)
     {
+#ifdef SP2_NULL_OPENGL
+        //There is no OpenGL context to create, but the context pointer marks that OpenGL is initialized.
+        shared_render_context = render_window;
+#else
         shared_render_context = SDL_GL_CreateContext(render_window);
+#endif
         initOpenGL();
 
         int major_version, minor_version;
@@ -384,9 +394,11 @@ void Window::createRenderWindow()
         LOG(Info, "OpenGL driver version:", glGetString(GL_VERSION));
     }
 
+#ifndef SP2_NULL_OPENGL
     //Enable VSync.
     if (SDL_GL_SetSwapInterval(-1))
         SDL_GL_SetSwapInterval(1);
+#endif
 }
 
 void Window::render()
@@ -400,7 +412,9 @@ void Window::render()
 
     queue.add([this, window_size]()
     {
+#ifndef SP2_NULL_OPENGL
         SDL_GL_MakeCurrent(render_window, shared_render_context);
+#endif
         glViewport(0, 0, window_size.x, window_size.y);
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -436,7 +450,9 @@ void Window::render()
     {
         queue.add([this, window_size]()
         {
+#ifndef SP2_NULL_OPENGL
             SDL_GL_MakeCurrent(render_window, shared_render_context);
+#endif
             glViewport(0, 0, window_size.x, window_size.y);
         });
 
@@ -459,7 +475,9 @@ void Window::render()
     {
         if (recorder)
             recorder->grabFrame(window_size);
+#ifndef SP2_NULL_OPENGL
         SDL_GL_SwapWindow(render_window);
+#endif
     });
 
     queue.render();
@@ -0,0 +1,105 @@
+#include <sp2/handle.h>
+#include "doctest.h"
+
+#include <chrono>
+#include <vector>
+
+class HandleTestObject : public sp::AutoPointerObject
+{
+public:
+    int value = 0;
+};
+
+class HandleTestSubObject : public HandleTestObject
+{
+};
+
+TEST_CASE("handle")
+{
+    sp::Handle<HandleTestObject> empty;
+    CHECK(!empty);
+    CHECK(empty == nullptr);
+
+    HandleTestObject* obj = new HandleTestObject();
+    sp::Handle<HandleTestObject> a = obj;
+    sp::Handle<HandleTestObject> b = a;
+    CHECK(a == obj);
+    CHECK(b == a);
+    b->value = 5;
+    CHECK(obj->value == 5);
+
+    sp::P<HandleTestObject> p = a;
+    CHECK(p == obj);
+    sp::Handle<HandleTestObject> c = p;
+    CHECK(c == obj);
+
+    a.destroy();
+    CHECK(!a);
+    CHECK(!b);
+    CHECK(!c);
+    CHECK(!p);
+
+    //A new object reusing the slot is not reachable through old handles.
+    HandleTestObject* obj2 = new HandleTestObject();
+    sp::Handle<HandleTestObject> d = obj2;
+    CHECK(d);
+    CHECK(!b);
+    delete obj2;
+
+    sp::Handle<HandleTestObject> sub = new HandleTestSubObject();
+    sp::Handle<HandleTestSubObject> casted = sub;
+    CHECK(casted.get() == sub.get());
+    HandleTestObject* base = new HandleTestObject();
+    sp::Handle<HandleTestSubObject> not_casted = sp::Handle<HandleTestObject>(base);
+    CHECK(!not_casted);
+    delete base;
+    sub.destroy();
+}
+
+TEST_CASE("handle versus pointer copy and deref cost")
+{
+    constexpr int object_count = 1000;
+    constexpr int rounds = 200;
+    std::vector<HandleTestObject*> objects;
+    for(int n=0; n<object_count; n++)
+        objects.push_back(new HandleTestObject());
+
+    std::vector<sp::P<HandleTestObject>> pointers(objects.begin(), objects.end());
+    std::vector<sp::Handle<HandleTestObject>> handles(objects.begin(), objects.end());
+
+    int p_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int r=0; r<rounds; r++)
+    {
+        for(const auto& p : pointers)
+        {
+            sp::P<HandleTestObject> copy = p;
+            if (copy)
+                p_sum += ++copy->value;
+        }
+    }
+    std::chrono::duration<double> p_time = std::chrono::steady_clock::now() - start;
+
+    int h_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for(int r=0; r<rounds; r++)
+    {
+        for(const auto& h : handles)
+        {
+            sp::Handle<HandleTestObject> copy = h;
+            if (auto ptr = copy.get())
+                h_sum += ++ptr->value;
+        }
+    }
+    std::chrono::duration<double> h_time = std::chrono::steady_clock::now() - start;
+
+    MESSAGE("copy+deref of " << object_count * rounds << " references: P<T> " << p_time.count() * 1000.0 << "ms, Handle<T> " << h_time.count() * 1000.0 << "ms");
+    //Every object is incremented once per round, first through the pointers, then through the handles.
+    CHECK(p_sum == object_count * (rounds * (rounds + 1) / 2));
+    CHECK(h_sum == object_count * (rounds * (3 * rounds + 1) / 2));
+
+    for(auto obj : objects)
+        delete obj;
+    for(auto& h : handles)
+        CHECK(!h);
+}
@@ -0,0 +1,154 @@
+#include <sp2/threading/jobSystem.h>
+#include <sp2/threading/queue.h>
+#include <sp2/io/lazyLoader.h>
+#include <sp2/io/internalResourceProvider.h>
+#include "doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using sp::threading::JobSystem;
+
+static void simulatedLoad()
+{
+    volatile unsigned int value = 0;
+    for(int n=0; n<200000; n++)
+        value = value * 31 + n;
+}
+
+TEST_CASE("jobsystem")
+{
+    std::atomic<int> counter{0};
+    std::vector<JobSystem::Handle> handles;
+    for(int n=0; n<1000; n++)
+        handles.push_back(JobSystem::submit([&counter]() { counter++; }));
+    JobSystem::wait(handles);
+    CHECK(counter == 1000);
+
+    for(auto& handle : handles)
+        CHECK(JobSystem::isDone(handle));
+    CHECK(JobSystem::isDone(nullptr));
+}
+
+TEST_CASE("jobsystem dependencies")
+{
+    std::atomic<int> step{0};
+    std::atomic<bool> order_ok{true};
+
+    auto first = JobSystem::submit([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (step++ != 0) order_ok = false;
+    });
+    auto second = JobSystem::submit([&]() {
+        if (step++ != 1) order_ok = false;
+    }, {first});
+    auto third = JobSystem::submit([&]() {
+        if (step++ != 2) order_ok = false;
+    }, {first, second}, JobSystem::Priority::High);
+    JobSystem::wait(third);
+    CHECK(step == 3);
+    CHECK(order_ok);
+
+    //Dependencies that are already finished do not block.
+    auto late = JobSystem::submit([&]() { step++; }, {first, second, third, nullptr});
+    JobSystem::wait(late);
+    CHECK(step == 4);
+}
+
+TEST_CASE("jobsystem nested submit")
+{
+    std::atomic<int> counter{0};
+    auto outer = JobSystem::submit([&counter]() {
+        std::vector<JobSystem::Handle> inner;
+        for(int n=0; n<100; n++)
+            inner.push_back(JobSystem::submit([&counter]() { counter++; }));
+        JobSystem::wait(inner);
+    });
+    JobSystem::wait(outer);
+    CHECK(counter == 100);
+}
+
+TEST_CASE("jobsystem throughput versus single thread queue")
+{
+    constexpr int job_count = 256;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        sp::threading::Queue<std::function<void()>*> queue;
+        std::thread thread([&queue]()
+        {
+            while(auto f = queue.get())
+            {
+                (*f)();
+                delete f;
+            }
+        });
+        for(int n=0; n<job_count; n++)
+            queue.put(new std::function<void()>(simulatedLoad));
+        queue.put(nullptr);
+        thread.join();
+    }
+    std::chrono::duration<double> queue_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::vector<JobSystem::Handle> handles;
+        for(int n=0; n<job_count; n++)
+            handles.push_back(JobSystem::submit(simulatedLoad, JobSystem::Priority::Low));
+        JobSystem::wait(handles);
+    }
+    std::chrono::duration<double> job_time = std::chrono::steady_clock::now() - start;
+
+    MESSAGE("single thread queue: " << queue_time.count() * 1000.0 << "ms, job system with " << JobSystem::getWorkerCount() << " workers: " << job_time.count() * 1000.0 << "ms");
+    CHECK(JobSystem::getWorkerCount() > 0);
+}
+
+//Loader that holds its first load until released, to refresh an item while it is still loading.
+class BlockingLoader : public sp::io::LazyLoader<int*>
+{
+public:
+    void refresh(const sp::string& name) { addToWorkqueue(get(name), name); }
+    bool busy(const sp::string& name) { return isLoading(name); }
+
+    std::atomic<bool> released{false};
+    std::atomic<int> loads{0};
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+protected:
+    virtual int* prepare(const sp::string& name) override { return &value; }
+    virtual void backgroundLoader(int* item, sp::io::ResourceStreamPtr stream) override
+    {
+        int now = ++running;
+        max_running = std::max(int(max_running), now);
+        while(!released)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        loads++;
+        running--;
+    }
+private:
+    int value = 0;
+};
+
+TEST_CASE("lazy loader refresh while loading")
+{
+    //Without workers, loads run inline and would never be released.
+    if (JobSystem::getWorkerCount() < 1)
+        return;
+    std::map<sp::string, sp::string> resources;
+    resources["lazy_loader_test"] = "data";
+    sp::P<sp::io::ResourceProvider> provider = new sp::io::InternalResourceProvider(std::move(resources));
+
+    BlockingLoader loader;
+    loader.get("internal:lazy_loader_test");
+    for(int n=0; n<5; n++)
+        loader.refresh("internal:lazy_loader_test");
+    loader.released = true;
+    for(int n=0; n<5000 && loader.busy("internal:lazy_loader_test"); n++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    //The refreshes collapse into a single load after the running one, never running at the same time.
+    CHECK(!loader.busy("internal:lazy_loader_test"));
+    CHECK(loader.loads == 2);
+    CHECK(loader.max_running == 1);
+    provider.destroy();
+}
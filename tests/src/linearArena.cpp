@@ -0,0 +1,33 @@
+#include <sp2/linearArena.h>
+#include "doctest.h"
+
+#include <memory>
+
+TEST_CASE("linear arena")
+{
+    sp::LinearArena arena(1024);
+    auto counter = std::make_shared<int>(0);
+    for(int frame=0; frame<3; frame++)
+    {
+        for(int n=0; n<100; n++)
+        {
+            double* value = arena.create<double>(n);
+            CHECK(uintptr_t(value) % alignof(double) == 0);
+            arena.allocate(3, 1);
+            arena.create<std::shared_ptr<int>>(counter);
+        }
+        //Larger than a block, which gets a block of its own.
+        char* big = static_cast<char*>(arena.allocate(4096));
+        big[4095] = 1;
+        CHECK(counter.use_count() == 101);
+        arena.reset();
+        CHECK(counter.use_count() == 1);
+    }
+    //After the first frame all blocks are reused.
+    size_t blocks = arena.getBlockCount();
+    size_t heap_allocations = sp::LinearArena::getHeapAllocationCount();
+    arena.create<int>(1);
+    arena.reset();
+    CHECK(arena.getBlockCount() == blocks);
+    CHECK(sp::LinearArena::getHeapAllocationCount() == heap_allocations);
+}
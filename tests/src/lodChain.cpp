@@ -0,0 +1,153 @@
+#include <sp2/graphics/lodChain.h>
+#include <sp2/graphics/scene/basicnoderenderpass.h>
+#include <sp2/scene/scene.h>
+#include <sp2/scene/camera.h>
+#include "doctest.h"
+
+#include <cmath>
+
+//Sphere with separate vertices for every quad, so the simplifier has to weld them.
+static std::shared_ptr<sp::MeshData> createSphere(int rings, int segments)
+{
+    sp::MeshData::Vertices vertices;
+    sp::MeshData::Indices indices;
+    auto point = [&](int ring, int segment)
+    {
+        double a = sp::pi * double(ring) / double(rings);
+        double b = sp::pi * 2.0 * double(segment % segments) / double(segments);
+        //Poles are exactly on the axis, so all their vertices weld together.
+        if (ring == 0 || ring == rings)
+            b = 0.0;
+        sp::Vector3f p(float(std::sin(a) * std::cos(b)), float(std::sin(a) * std::sin(b)), float(std::cos(a)));
+        return sp::MeshData::Vertex(p, p, sp::Vector2f(float(segment) / float(segments), float(ring) / float(rings)));
+    };
+    for(int r=0; r<rings; r++)
+    {
+        for(int s=0; s<segments; s++)
+        {
+            uint32_t base = uint32_t(vertices.size());
+            vertices.push_back(point(r, s));
+            vertices.push_back(point(r, s + 1));
+            vertices.push_back(point(r + 1, s));
+            vertices.push_back(point(r + 1, s + 1));
+            if (r > 0)
+                indices.insert(indices.end(), {base, base + 2, base + 1});
+            if (r < rings - 1)
+                indices.insert(indices.end(), {base + 1, base + 2, base + 3});
+        }
+    }
+    return sp::MeshData::create(std::move(vertices), std::move(indices));
+}
+
+TEST_CASE("mesh simplification")
+{
+    auto sphere = createSphere(32, 64);
+    int triangles = int(sphere->getIndices().size() / 3);
+    CHECK(triangles == 64 * 62);
+
+    auto simple = sp::simplifyMesh(*sphere, triangles / 4);
+    int simple_triangles = int(simple->getIndices().size() / 3);
+    CHECK(simple_triangles <= triangles / 4);
+    CHECK(simple_triangles > triangles / 5);
+    CHECK(simple->getVertices().size() < sphere->getVertices().size() / 2);
+    CHECK(simple->getBoundingSphereRadius() == doctest::Approx(1.0).epsilon(0.05));
+    //Every vertex stays close to the surface.
+    for(const auto& v : simple->getVertices())
+        CHECK(v.position.length() == doctest::Approx(1.0).epsilon(0.1));
+
+    //The open border of a flat grid stays in place.
+    sp::MeshData::Vertices vertices;
+    sp::MeshData::Indices indices;
+    for(int y=0; y<=20; y++)
+        for(int x=0; x<=20; x++)
+            vertices.emplace_back(sp::Vector3f(float(x), float(y), 0.0f));
+    for(uint32_t y=0; y<20; y++)
+    {
+        for(uint32_t x=0; x<20; x++)
+        {
+            uint32_t i = x + y * 21;
+            indices.insert(indices.end(), {i, i + 1, i + 21, i + 21, i + 1, i + 22});
+        }
+    }
+    auto grid = sp::MeshData::create(std::move(vertices), std::move(indices));
+    simple = sp::simplifyMesh(*grid, 100);
+    CHECK(simple->getIndices().size() / 3 <= 100);
+    CHECK(simple->getBoundsMin() == grid->getBoundsMin());
+    CHECK(simple->getBoundsMax() == grid->getBoundsMax());
+    for(const auto& v : simple->getVertices())
+        CHECK(v.position.z == 0.0f);
+}
+
+TEST_CASE("lod chain")
+{
+    auto chain = sp::LodChain::generate(createSphere(32, 64), 4, 0.25f, 0.2f);
+    CHECK(chain->getLevelCount() == 4);
+    for(int n=1; n<chain->getLevelCount(); n++)
+        CHECK(chain->getMesh(n)->getIndices().size() < chain->getMesh(n - 1)->getIndices().size());
+
+    //Levels only switch once the size is 10% past the threshold.
+    CHECK(chain->selectLevel(1.0f, 0) == 0);
+    CHECK(chain->selectLevel(0.19f, 0) == 0);
+    CHECK(chain->selectLevel(0.17f, 0) == 1);
+    CHECK(chain->selectLevel(0.21f, 1) == 1);
+    CHECK(chain->selectLevel(0.23f, 1) == 0);
+    CHECK(chain->selectLevel(0.01f, 0) == 3);
+    CHECK(chain->selectLevel(1.0f, 3) == 0);
+}
+
+TEST_CASE("lod selection in render pass")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("lod_test");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setPerspective(90.0);
+    scene->setDefaultCamera(camera);
+
+    auto chain = sp::LodChain::generate(createSphere(32, 64), 4, 0.25f, 0.2f);
+    std::vector<sp::P<sp::Node>> nodes;
+    for(double distance : {2.0, 20.0, 200.0})
+    {
+        sp::P<sp::Node> node = new sp::Node(scene->getRoot());
+        node->setPosition(sp::Vector3d(0, 0, -distance));
+        node->render_data.type = sp::RenderData::Type::Normal;
+        node->render_data.mesh = chain->getMesh(0);
+        node->render_data.lod = chain;
+        nodes.push_back(node);
+    }
+
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    sp::BasicNodeRenderPass pass;
+    pass.render(queue);
+    CHECK(nodes[0]->render_data.lod_level == 0);
+    CHECK(nodes[1]->render_data.lod_level == 2);
+    CHECK(nodes[2]->render_data.lod_level == 3);
+    int full_triangles = int(chain->getMesh(0)->getIndices().size() / 3);
+    CHECK(pass.getCullingStats().triangles < full_triangles * 3 / 2);
+    CHECK(pass.getCullingStats().triangles == full_triangles + int(chain->getMesh(2)->getIndices().size() / 3) + int(chain->getMesh(3)->getIndices().size() / 3));
+
+    //Moving a bit past the threshold does not switch back, moving well past it does.
+    nodes[1]->setPosition(sp::Vector3d(0, 0, -9.5));
+    pass.render(queue);
+    CHECK(nodes[1]->render_data.lod_level == 2);
+    nodes[1]->setPosition(sp::Vector3d(0, 0, -4));
+    pass.render(queue);
+    CHECK(nodes[1]->render_data.lod_level == 0);
+
+    //Every camera keeps its own level, a near camera does not pull a far camera past its margin.
+    nodes[1]->setPosition(sp::Vector3d(0, 0, -20));
+    pass.render(queue);
+    CHECK(nodes[1]->render_data.lod_level == 2);
+    sp::P<sp::Camera> near_camera = new sp::Camera(scene->getRoot());
+    near_camera->setPerspective(90.0);
+    near_camera->setPosition(sp::Vector3d(0, 0, -16));
+    sp::BasicNodeRenderPass near_pass(near_camera);
+    near_pass.render(queue);
+    CHECK(nodes[1]->render_data.lod_level == 0);
+    nodes[1]->setPosition(sp::Vector3d(0, 0, -9.5));
+    near_camera->setPosition(sp::Vector3d(0, 0, -5.5));
+    pass.render(queue);
+    CHECK(nodes[1]->render_data.lod_level == 2);
+
+    scene.destroy();
+}
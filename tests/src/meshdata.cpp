@@ -0,0 +1,217 @@
+#include <sp2/graphics/meshdata.h>
+#include <sp2/graphics/opengl.h>
+#include <sp2/graphics/nullOpenGL.h>
+#include "doctest.h"
+
+//Grid of separate quads, with vertex_count vertices in total.
+static std::shared_ptr<sp::MeshData> createQuadGrid(int vertex_count)
+{
+    sp::MeshData::Vertices vertices;
+    sp::MeshData::Indices indices;
+    for(int n=0; n<vertex_count; n+=4)
+    {
+        float x = float(n % 1000);
+        float y = float(n / 1000);
+        indices.insert(indices.end(), {uint32_t(n), uint32_t(n + 1), uint32_t(n + 2), uint32_t(n + 2), uint32_t(n + 1), uint32_t(n + 3)});
+        vertices.emplace_back(sp::Vector3f(x, y, 0));
+        vertices.emplace_back(sp::Vector3f(x + 1, y, 0));
+        vertices.emplace_back(sp::Vector3f(x, y + 1, 0));
+        vertices.emplace_back(sp::Vector3f(x + 1, y + 1, 0));
+    }
+    return sp::MeshData::create(std::move(vertices), std::move(indices));
+}
+
+//Render the mesh, and return the index type and total index count of all the draw calls.
+static void renderMesh(sp::MeshData& mesh, int& index_type, int& index_count)
+{
+    sp::NullOpenGL::resetStatistics();
+    sp::NullOpenGL::clearCommands();
+    sp::NullOpenGL::setRecording(true);
+    mesh.render();
+    sp::NullOpenGL::setRecording(false);
+    index_type = 0;
+    index_count = 0;
+    for(const auto& command : sp::NullOpenGL::getCommands())
+    {
+        if (command.category != sp::NullOpenGL::Category::Draw)
+            continue;
+        index_count += int(command.arguments[1]);
+        index_type = int(command.arguments[2]);
+    }
+}
+
+TEST_CASE("mesh index size")
+{
+    sp::NullOpenGL::install();
+    bool element_index_uint = sp::opengl_element_index_uint;
+    int index_type, index_count;
+
+    //Small meshes are uploaded with 16 bit indices, even though they are stored as 32 bit.
+    auto quad = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    renderMesh(*quad, index_type, index_count);
+    CHECK(index_type == GL_UNSIGNED_SHORT);
+    CHECK(index_count == 6);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4 * sizeof(sp::MeshData::Vertex) + 6 * sizeof(uint16_t));
+
+    auto exact = createQuadGrid(0x10000);
+    renderMesh(*exact, index_type, index_count);
+    CHECK(index_type == GL_UNSIGNED_SHORT);
+    CHECK(exact->getDrawCount() == 1);
+
+    sp::opengl_element_index_uint = true;
+    auto large = createQuadGrid(100000);
+    renderMesh(*large, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().draw_calls == 1);
+    CHECK(index_type == GL_UNSIGNED_INT);
+    CHECK(index_count == 150000);
+
+    //Without 32 bit indices the mesh is split into parts of at most 65536 vertices, drawing the same triangles.
+    sp::opengl_element_index_uint = false;
+    large = createQuadGrid(100000);
+    renderMesh(*large, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().draw_calls == 2);
+    CHECK(large->getDrawCount() == 2);
+    CHECK(index_type == GL_UNSIGNED_SHORT);
+    CHECK(index_count == 150000);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes >= 100000 * int(sizeof(sp::MeshData::Vertex)) + 150000 * int(sizeof(uint16_t)));
+
+    //After the upload, only the draws remain.
+    renderMesh(*large, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_uploads == 0);
+    CHECK(sp::NullOpenGL::getStatistics().draw_calls == 2);
+
+    sp::opengl_element_index_uint = element_index_uint;
+}
+
+TEST_CASE("mesh vertex layouts")
+{
+    sp::NullOpenGL::install();
+    sp::MeshData::Vertex vertex(sp::Vector3f(1.5f, -2.25f, 3.0f), sp::Vector3f(0.0f, 0.6f, -0.8f), sp::Vector2f(0.25f, 0.75f));
+    uint8_t buffer[64];
+    for(auto layout : {sp::MeshData::Layout::Full, sp::MeshData::Layout::PackedNormal, sp::MeshData::Layout::PackedNormalUV, sp::MeshData::Layout::PackedNormalTile})
+    {
+        const auto& descriptor = sp::MeshData::VertexLayout::get(layout);
+        descriptor.pack(vertex, buffer);
+        auto result = descriptor.unpack(buffer);
+        CHECK(result.position.x == vertex.position.x);
+        CHECK(result.position.z == vertex.position.z);
+        CHECK(result.normal.y == doctest::Approx(vertex.normal.y).epsilon(0.01));
+        CHECK(result.normal.z == doctest::Approx(vertex.normal.z).epsilon(0.01));
+        CHECK(result.uv.x == doctest::Approx(vertex.uv.x).epsilon(0.0001));
+        CHECK(result.uv.y == doctest::Approx(vertex.uv.y).epsilon(0.0001));
+    }
+    //The flat layouts drop the z position, and the color layout clamps the normal to a 0-1 color.
+    const auto& flat = sp::MeshData::VertexLayout::get(sp::MeshData::Layout::Position2DUVColor);
+    CHECK(flat.stride == 20);
+    flat.pack(vertex, buffer);
+    auto result = flat.unpack(buffer);
+    CHECK(result.position.y == vertex.position.y);
+    CHECK(result.position.z == 0.0f);
+    CHECK(result.normal.x == 0.0f);
+    CHECK(result.normal.y == doctest::Approx(0.6f).epsilon(0.01));
+    CHECK(result.normal.z == 0.0f);
+    CHECK(buffer[19] == 255);
+    CHECK(sp::MeshData::VertexLayout::get(sp::MeshData::Layout::Position).stride == 12);
+
+    //The tile bytes are kept as they are.
+    const auto& tiled = sp::MeshData::VertexLayout::get(sp::MeshData::Layout::PackedNormalTile);
+    sp::MeshData::Vertex tile_vertex = vertex;
+    tile_vertex.tile[0] = 3;
+    tile_vertex.tile[1] = 200;
+    tile_vertex.tile[2] = 16;
+    tile_vertex.tile[3] = 255;
+    tiled.pack(tile_vertex, buffer);
+    result = tiled.unpack(buffer);
+    CHECK(result.tile[1] == 200);
+    CHECK(result.tile[3] == 255);
+    CHECK(result.uv.x == 0.25f);
+
+    //Only the packed vertex data is uploaded.
+    int index_type, index_count;
+    auto quad = sp::MeshData::create(sp::MeshData::Vertices(4, vertex), sp::MeshData::Indices{0, 1, 2, 2, 1, 3}, sp::MeshData::Type::Static, sp::MeshData::Layout::Position2DUV);
+    renderMesh(*quad, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4 * 16 + 6 * sizeof(uint16_t));
+    quad = sp::MeshData::create(sp::MeshData::Vertices(4, vertex), sp::MeshData::Indices{0, 1, 2, 2, 1, 3}, sp::MeshData::Type::Static, sp::MeshData::Layout::PackedNormalUV);
+    renderMesh(*quad, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4 * 20 + 6 * sizeof(uint16_t));
+
+    //Split meshes pack every part.
+    bool element_index_uint = sp::opengl_element_index_uint;
+    sp::opengl_element_index_uint = false;
+    sp::MeshData::Vertices vertices(100000, vertex);
+    sp::MeshData::Indices indices;
+    for(uint32_t n=0; n<100000; n+=4)
+        indices.insert(indices.end(), {n, n + 1, n + 2, n + 2, n + 1, n + 3});
+    auto large = sp::MeshData::create(std::move(vertices), std::move(indices), sp::MeshData::Type::Static, sp::MeshData::Layout::PackedNormal);
+    renderMesh(*large, index_type, index_count);
+    CHECK(index_count == 150000);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 100000 * 24 + 150000 * sizeof(uint16_t));
+    sp::opengl_element_index_uint = element_index_uint;
+}
+
+TEST_CASE("mesh partial updates")
+{
+    sp::NullOpenGL::install();
+    int index_type, index_count;
+    auto mesh = createQuadGrid(4000);
+    sp::MeshData::Vertices vertices = mesh->getVertices();
+    sp::MeshData::Indices indices = mesh->getIndices();
+    mesh = sp::MeshData::create(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices), sp::MeshData::Type::Dynamic);
+    renderMesh(*mesh, index_type, index_count);
+    CHECK(mesh->getUploadStats().full_uploads == 1);
+    CHECK(mesh->getUploadStats().bytes == 4000 * 36 + 6000 * 2);
+
+    //Changing a single quad only uploads its 4 vertices.
+    for(int n=400; n<404; n++)
+        vertices[n].normal = sp::Vector3f(1, 0, 0);
+    int revision = mesh->getRevision();
+    mesh->update(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices));
+    CHECK(mesh->getRevision() != revision);
+    renderMesh(*mesh, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4 * 36);
+    CHECK(mesh->getUploadStats().partial_uploads == 1);
+    CHECK(mesh->getUploadStats().bytes == 4000 * 36 + 6000 * 2 + 4 * 36);
+
+    //Nothing changed, nothing uploaded.
+    mesh->update(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices));
+    renderMesh(*mesh, index_type, index_count);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_uploads == 0);
+
+    //Multiple changes before a render are combined in one range, and the bounds follow the vertices.
+    mesh->updateVertices(10, sp::MeshData::Vertices(2, sp::MeshData::Vertex(sp::Vector3f(0, 0, 50))));
+    mesh->updateVertices(20, sp::MeshData::Vertices(2, sp::MeshData::Vertex(sp::Vector3f(0, 0, -50))));
+    CHECK(mesh->getBoundsMax().z == 50.0f);
+    renderMesh(*mesh, index_type, index_count);
+    CHECK(sp::NullOpenGL::countCommands("glBufferSubData") == 1);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 12 * 36);
+
+    //Rewriting most of the mesh orphans the old buffer, and writes the new data into the new storage.
+    for(auto& v : vertices)
+        v.position.z = 1.0f;
+    mesh->update(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices));
+    renderMesh(*mesh, index_type, index_count);
+    CHECK(mesh->getUploadStats().full_uploads == 2);
+    CHECK(sp::NullOpenGL::countCommands("glBufferData") == 2);
+    CHECK(sp::NullOpenGL::countCommands("glBufferSubData") == 2);
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4000 * 36 + 6000 * 2);
+
+    //Stream meshes rotate over multiple buffers.
+    auto stream = sp::MeshData::create(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices), sp::MeshData::Type::Stream);
+    std::vector<int64_t> vertex_buffers;
+    for(int frame=0; frame<4; frame++)
+    {
+        vertices[0].position.x = float(frame);
+        stream->update(sp::MeshData::Vertices(vertices), sp::MeshData::Indices(indices));
+        renderMesh(*stream, index_type, index_count);
+        for(const auto& command : sp::NullOpenGL::getCommands())
+            if (std::string(command.function) == "glBindBuffer" && command.arguments[0] == GL_ARRAY_BUFFER)
+                vertex_buffers.push_back(command.arguments[1]);
+        CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 4000 * 36 + 6000 * 2);
+    }
+    CHECK(stream->getUploadStats().full_uploads == 4);
+    CHECK(vertex_buffers.size() == 4);
+    CHECK(vertex_buffers[0] != vertex_buffers[1]);
+    CHECK(vertex_buffers[1] != vertex_buffers[2]);
+    CHECK(vertex_buffers[0] != vertex_buffers[2]);
+    CHECK(vertex_buffers[3] == vertex_buffers[0]);
+}
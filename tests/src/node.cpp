@@ -0,0 +1,312 @@
+#include <sp2/scene/scene.h>
+#include <sp2/scene/node.h>
+#include "doctest.h"
+
+#include <chrono>
+
+TEST_CASE("node transforms")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("node_transform_test");
+
+    sp::P<sp::Node> a = new sp::Node(scene->getRoot());
+    sp::P<sp::Node> b = new sp::Node(a);
+    sp::P<sp::Node> c = new sp::Node(b);
+
+    a->setPosition(sp::Vector2d(1, 0));
+    b->setPosition(sp::Vector2d(0, 2));
+    c->setPosition(sp::Vector2d(3, 3));
+    CHECK(c->getGlobalPosition2D() == sp::Vector2d(4, 5));
+
+    //Moving a parent after the child transform was resolved should update the child.
+    a->setPosition(sp::Vector2d(-1, 0));
+    a->setPosition(sp::Vector2d(10, 0));
+    CHECK(c->getGlobalPosition2D() == sp::Vector2d(13, 5));
+    CHECK(b->getGlobalPosition2D() == sp::Vector2d(10, 2));
+
+    //Batched update gives the same result as on demand resolving.
+    b->setPosition(sp::Vector2d(0, -2));
+    scene->getRoot()->updateGlobalTransforms();
+    CHECK(c->getGlobalPosition2D() == sp::Vector2d(13, 1));
+
+    sp::P<sp::Node> d = new sp::Node(scene->getRoot());
+    d->setPosition(sp::Vector2d(0, 100));
+    c->setParent(d);
+    CHECK(c->getGlobalPosition2D() == sp::Vector2d(3, 103));
+
+    //The root has no parent whose render bounds need updating.
+    scene->getRoot()->setPosition(sp::Vector2d(1, 1));
+    scene->getRoot()->setRotation(45.0);
+
+    scene.destroy();
+}
+
+TEST_CASE("node transforms 10k hierarchy")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("node_transform_benchmark");
+
+    //10 x 10 x 100 leaf nodes, with a 3 level deep parent chain above them.
+    std::vector<sp::P<sp::Node>> parents;
+    int node_count = 0;
+    sp::P<sp::Node> top = new sp::Node(scene->getRoot());
+    node_count++;
+    for(int n=0; n<10; n++)
+    {
+        sp::P<sp::Node> level1 = new sp::Node(top);
+        node_count++;
+        parents.push_back(level1);
+        for(int m=0; m<10; m++)
+        {
+            sp::P<sp::Node> level2 = new sp::Node(level1);
+            node_count++;
+            parents.push_back(level2);
+            for(int o=0; o<100; o++)
+            {
+                new sp::Node(level2);
+                node_count++;
+            }
+        }
+    }
+    scene->getRoot()->updateGlobalTransforms();
+
+    //Every parent moves 3 times per tick, for 10 ticks.
+    //Updating transforms directly on every change would recalculate the full subtree on every move.
+    constexpr int ticks = 10;
+    constexpr int moves_per_tick = 3;
+    long eager_multiplies = 0;
+    for(auto& parent : parents)
+        eager_multiplies += (parent->getParent() == top ? 1 + 10 + 10 * 100 : 1 + 100) * moves_per_tick * ticks;
+
+    size_t updates_start = scene->getTransformUpdateCount();
+    auto start = std::chrono::steady_clock::now();
+    for(int tick=0; tick<ticks; tick++)
+    {
+        for(int move=0; move<moves_per_tick; move++)
+            for(auto& parent : parents)
+                parent->setPosition(sp::Vector2d(tick, move));
+        scene->getRoot()->updateGlobalTransforms();
+    }
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    long lazy_multiplies = long(scene->getTransformUpdateCount() - updates_start);
+
+    MESSAGE(node_count << " nodes: " << time.count() * 1000.0 << "ms, " << lazy_multiplies << " transform updates instead of " << eager_multiplies);
+    //Everything below the top node is calculated once per tick.
+    CHECK(lazy_multiplies == long(node_count - 1) * ticks);
+    CHECK(lazy_multiplies < eager_multiplies);
+
+    //Without changes, an update does not calculate anything.
+    updates_start = scene->getTransformUpdateCount();
+    scene->getRoot()->updateGlobalTransforms();
+    CHECK(scene->getTransformUpdateCount() == updates_start);
+    CHECK(parents.back()->getGlobalPosition2D() == sp::Vector2d(2 * (ticks - 1), 2 * (moves_per_tick - 1)));
+
+    scene.destroy();
+}
+
+TEST_CASE("transform store matches matrix math")
+{
+    sp::TransformStore store;
+    int a = store.create(-1);
+    int b = store.create(a);
+    std::vector<int> leafs;
+    for(int n=0; n<7; n++)
+        leafs.push_back(store.create(b));
+
+    store.setTranslation(a, sp::Vector3d(1, 2, 3));
+    store.setRotation(a, sp::Quaterniond::fromAngle(30));
+    store.setTranslation(b, sp::Vector3d(-4, 0.5, 2));
+    store.setRotation(b, sp::Quaterniond::fromAxisAngle(sp::Vector3d(1, 1, 0), 45));
+    for(unsigned int n=0; n<leafs.size(); n++)
+    {
+        store.setTranslation(leafs[n], sp::Vector3d(n, n * 2, -int(n)));
+        store.setRotation(leafs[n], sp::Quaterniond::fromAngle(n * 10));
+    }
+    store.update();
+
+    auto local = [&store](int slot) {
+        return sp::Matrix4x4f::translate(sp::Vector3f(store.getTranslation(slot))) * sp::Matrix4x4f::fromQuaternion(sp::Quaternionf(store.getRotation(slot)));
+    };
+    for(unsigned int n=0; n<leafs.size(); n++)
+    {
+        sp::Matrix4x4f expected = local(a) * local(b) * local(leafs[n]);
+        const sp::Matrix4x4f& result = store.getGlobalTransform(leafs[n]);
+        for(int i=0; i<16; i++)
+            CHECK(result.data[i] == doctest::Approx(expected.data[i]).epsilon(0.0001));
+    }
+
+    //Reparenting updates the hierarchy depth and the global transform.
+    store.setParent(leafs[0], a);
+    store.update();
+    sp::Matrix4x4f expected = local(a) * local(leafs[0]);
+    for(int i=0; i<16; i++)
+        CHECK(store.getGlobalTransform(leafs[0]).data[i] == doctest::Approx(expected.data[i]).epsilon(0.0001));
+
+    //On demand resolving sees changes of parents.
+    store.setTranslation(a, sp::Vector3d(0, 0, 0));
+    CHECK(store.getGlobalTransform(leafs[1]).data[12] == doctest::Approx((local(a) * local(b) * local(leafs[1])).data[12]));
+
+    //Moving b below one of its old leafs puts the whole subtree a level deeper, which the next update handles in order.
+    store.setParent(b, leafs[0]);
+    store.update();
+    expected = local(a) * local(leafs[0]) * local(b) * local(leafs[2]);
+    for(int i=0; i<16; i++)
+        CHECK(store.getGlobalTransform(leafs[2]).data[i] == doctest::Approx(expected.data[i]).epsilon(0.0001));
+
+    //References to transforms stay valid while slots are added.
+    const sp::Matrix4x4f& reference = store.getGlobalTransform(leafs[2]);
+    for(int n=0; n<1000; n++)
+        store.create(a);
+    CHECK(&reference == &store.getGlobalTransform(leafs[2]));
+
+    //After an update nothing is calculated again, so reading transforms from render jobs does not write to the store.
+    store.update();
+    size_t update_count = store.getGlobalUpdateCount();
+    store.getGlobalTransform(leafs[2]);
+    CHECK(store.getGlobalUpdateCount() == update_count);
+
+    //Children of a destroyed slot become the top of their own hierarchy, and the next update picks that up.
+    store.destroy(leafs[0]);
+    store.update();
+    expected = local(b) * local(leafs[2]);
+    for(int i=0; i<16; i++)
+        CHECK(store.getGlobalTransform(leafs[2]).data[i] == doctest::Approx(expected.data[i]).epsilon(0.0001));
+
+    store.destroy(leafs.back());
+    CHECK(store.create(b) == leafs.back());
+}
+
+class UpdateCountNode : public sp::Node
+{
+public:
+    UpdateCountNode(sp::P<sp::Node> parent) : sp::Node(parent) { setUpdateEnabled(true); setFixedUpdateEnabled(true); }
+
+    virtual void onUpdate(float delta) override { update_count++; }
+    virtual void onFixedUpdate() override { fixed_update_count++; }
+
+    int update_count = 0;
+    int fixed_update_count = 0;
+};
+
+class CallsBaseNode : public UpdateCountNode
+{
+public:
+    CallsBaseNode(sp::P<sp::Node> parent) : UpdateCountNode(parent) {}
+
+    virtual void onUpdate(float delta) override { sp::Node::onUpdate(delta); update_count++; }
+};
+
+class SelfDestructNode : public sp::Node
+{
+public:
+    SelfDestructNode(sp::P<sp::Node> parent) : sp::Node(parent) { setFixedUpdateEnabled(true); }
+
+    virtual void onFixedUpdate() override { delete this; }
+};
+
+class NotEnabledNode : public UpdateCountNode
+{
+public:
+    NotEnabledNode(sp::P<sp::Node> parent) : UpdateCountNode(parent) { setUpdateEnabled(false); }
+};
+
+//Moves itself to the end of the tick list, under a new parent, from its own update.
+class ReparentNode : public UpdateCountNode
+{
+public:
+    ReparentNode(sp::P<sp::Node> parent) : UpdateCountNode(parent) {}
+
+    virtual void onUpdate(float delta) override
+    {
+        update_count++;
+        setParent(new sp::Node(getParent()));
+    }
+};
+
+static void fullTreeUpdate(sp::P<sp::Node> node, float delta)
+{
+    node->onUpdate(delta);
+    for(sp::P<sp::Node> child : node->getChildren())
+        fullTreeUpdate(child, delta);
+}
+
+TEST_CASE("node update lists")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("node_update_test");
+
+    sp::P<sp::Node> idle = new sp::Node(scene->getRoot());
+    sp::P<UpdateCountNode> active = new UpdateCountNode(idle);
+    sp::P<SelfDestructNode> self_destruct = new SelfDestructNode(scene->getRoot());
+    sp::P<UpdateCountNode> after = new UpdateCountNode(scene->getRoot());
+
+    scene->fixedUpdate();
+    scene->update(0.1);
+    scene->fixedUpdate();
+    scene->update(0.1);
+    CHECK(!self_destruct);
+    CHECK(active->update_count == 2);
+    CHECK(active->fixed_update_count == 2);
+    CHECK(after->fixed_update_count == 2);
+
+    active.destroy();
+    scene->update(0.1);
+    CHECK(after->update_count == 3);
+
+    //Calling the base implementation from an override keeps the node ticking.
+    sp::P<CallsBaseNode> calls_base = new CallsBaseNode(scene->getRoot());
+    scene->update(0.1);
+    scene->update(0.1);
+    CHECK(calls_base->update_count == 2);
+
+    after->setUpdateEnabled(false);
+    scene->update(0.1);
+    CHECK(after->update_count == 5);
+    after->setUpdateEnabled(true);
+    scene->update(0.1);
+    CHECK(after->update_count == 6);
+
+    //Only the enabled events are called.
+    sp::P<NotEnabledNode> not_enabled = new NotEnabledNode(scene->getRoot());
+    scene->update(0.1);
+    scene->fixedUpdate();
+    CHECK(not_enabled->update_count == 0);
+    CHECK(not_enabled->fixed_update_count == 1);
+
+    //Reparenting during the tick moves the node to the end of the list, it is still ticked once per frame.
+    sp::P<ReparentNode> reparent = new ReparentNode(scene->getRoot());
+    scene->update(0.1);
+    scene->update(0.1);
+    CHECK(reparent->update_count == 2);
+
+    scene.destroy();
+}
+
+TEST_CASE("node update lists 100k idle nodes")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("node_update_benchmark");
+
+    std::vector<sp::P<UpdateCountNode>> active;
+    for(int n=0; n<1000; n++)
+    {
+        sp::P<sp::Node> group = new sp::Node(scene->getRoot());
+        for(int m=0; m<99; m++)
+            new sp::Node(group);
+        active.push_back(new UpdateCountNode(group));
+    }
+
+    constexpr int frames = 20;
+    scene->update(0.0);
+    auto start = std::chrono::steady_clock::now();
+    for(int n=0; n<frames; n++)
+        scene->update(0.0);
+    std::chrono::duration<double> list_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<frames; n++)
+        for(sp::P<sp::Node> child : scene->getRoot()->getChildren())
+            fullTreeUpdate(child, 0.0);
+    std::chrono::duration<double> tree_time = std::chrono::steady_clock::now() - start;
+
+    MESSAGE("100k nodes, 1k active: update lists " << list_time.count() * 1000.0 / frames << "ms per frame, full tree walk " << tree_time.count() * 1000.0 / frames << "ms per frame");
+    CHECK(active.front()->update_count == frames * 2 + 1);
+
+    scene.destroy();
+}
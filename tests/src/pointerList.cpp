@@ -0,0 +1,103 @@
+#include <sp2/pointerList.h>
+#include "doctest.h"
+
+#include <thread>
+#include <vector>
+#include <mutex>
+
+class PListTestObject : public sp::AutoPointerObject
+{
+public:
+    int value = 1;
+};
+
+TEST_CASE("pointer list")
+{
+    sp::PList<PListTestObject> list;
+    sp::P<PListTestObject> a = new PListTestObject();
+    sp::P<PListTestObject> b = new PListTestObject();
+    list.add(a);
+    list.add(b);
+    list.add(a);
+    CHECK(list.size() == 3);
+
+    for(sp::P<PListTestObject> obj : list)
+        obj.destroy();
+    CHECK(list.empty());
+}
+
+TEST_CASE("pointer list multithreaded stress")
+{
+    constexpr int thread_count = 4;
+    constexpr int rounds = 200;
+    constexpr int objects_per_round = 100;
+
+    //Every thread builds lists and deletes objects, and hands part of its lists to the main thread, so entries are freed on a different thread than they are created on.
+    std::mutex handover_mutex;
+    std::vector<sp::PList<PListTestObject>*> handover;
+    std::vector<std::thread> threads;
+    std::vector<int> totals(thread_count, 0);
+    for(int t=0; t<thread_count; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for(int round=0; round<rounds; round++)
+            {
+                std::vector<PListTestObject*> objects;
+                sp::PList<PListTestObject>* list = new sp::PList<PListTestObject>();
+                {
+                    sp::PList<PListTestObject> second_list;
+                    for(int n=0; n<objects_per_round; n++)
+                    {
+                        objects.push_back(new PListTestObject());
+                        list->add(objects.back());
+                        second_list.add(objects.back());
+                    }
+                    for(int n=0; n<objects_per_round; n+=2)
+                        delete objects[n];
+                    for(sp::P<PListTestObject> obj : second_list)
+                        totals[t] += obj->value;
+                }
+
+                if (round % 4 == 0)
+                {
+                    std::lock_guard<std::mutex> lock(handover_mutex);
+                    handover.push_back(list);
+                }
+                else
+                {
+                    delete list;
+                    for(int n=1; n<objects_per_round; n+=2)
+                        delete objects[n];
+                }
+            }
+        });
+    }
+
+    int handed_over = 0;
+    while(true)
+    {
+        std::vector<sp::PList<PListTestObject>*> lists;
+        {
+            std::lock_guard<std::mutex> lock(handover_mutex);
+            lists.swap(handover);
+        }
+        for(auto list : lists)
+        {
+            CHECK(list->size() == objects_per_round / 2);
+            for(sp::P<PListTestObject> obj : *list)
+                obj.destroy();
+            CHECK(list->empty());
+            delete list;
+            handed_over++;
+        }
+        if (handed_over == thread_count * rounds / 4)
+            break;
+        std::this_thread::yield();
+    }
+    for(auto& thread : threads)
+        thread.join();
+
+    for(int t=0; t<thread_count; t++)
+        CHECK(totals[t] == rounds * objects_per_round / 2);
+}
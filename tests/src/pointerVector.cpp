@@ -0,0 +1,220 @@
+#include <sp2/pointerVector.h>
+#include <sp2/pointerList.h>
+#include "doctest.h"
+
+#include <chrono>
+#include <vector>
+#include <string>
+
+class PVectorTestObject : public sp::AutoPointerObject
+{
+public:
+    PVectorTestObject(int value=0) : value(value) {}
+
+    int value;
+};
+
+//Uses the type the iterators return, P<T> for PList<T> and T* for PVector<T>.
+template<class Container> static int sum(const Container& container)
+{
+    int result = 0;
+    for(auto obj : container)
+        result += obj->value;
+    return result;
+}
+
+TEST_CASE("pointer vector")
+{
+    sp::PVector<PVectorTestObject> list;
+    CHECK(list.empty());
+    CHECK(list.begin() == list.end());
+
+    std::vector<sp::P<PVectorTestObject>> objects;
+    for(int n=1; n<=5; n++)
+    {
+        objects.push_back(new PVectorTestObject(n));
+        list.add(objects.back());
+    }
+    CHECK(list.size() == 5);
+    CHECK(sum(list) == 15);
+
+    objects[1].destroy();
+    CHECK(list.size() == 4);
+    CHECK(sum(list) == 13);
+
+    list.remove(objects[0]);
+    CHECK(list.size() == 3);
+    CHECK(sum(list) == 12);
+
+    int reverse_order = 0;
+    for(auto it = list.rbegin(); it != list.rend(); ++it)
+        reverse_order = reverse_order * 10 + (*it)->value;
+    CHECK(reverse_order == 543);
+
+    list.sort([](const sp::P<PVectorTestObject>& a, const sp::P<PVectorTestObject>& b) { return b->value - a->value; });
+    CHECK((*list.begin())->value == 5);
+
+    list.clear();
+    CHECK(list.empty());
+    for(auto& obj : objects)
+        obj.destroy();
+}
+
+TEST_CASE("pointer vector modify while iterating")
+{
+    sp::PVector<PVectorTestObject> list;
+    std::vector<sp::P<PVectorTestObject>> objects;
+    for(int n=1; n<=4; n++)
+    {
+        objects.push_back(new PVectorTestObject(n));
+        list.add(objects.back());
+    }
+
+    //Deleting the current and the next object, and adding a new object, while iterating.
+    std::vector<int> visited;
+    for(sp::P<PVectorTestObject> obj : list)
+    {
+        visited.push_back(obj->value);
+        if (obj->value == 2)
+        {
+            objects[2].destroy();
+            obj.destroy();
+            list.add(new PVectorTestObject(10));
+        }
+    }
+    CHECK(visited == std::vector<int>{1, 2, 4, 10});
+    CHECK(list.size() == 3);
+
+    //Destroying the list itself while iterating is also safe.
+    sp::PVector<PVectorTestObject>* owned = new sp::PVector<PVectorTestObject>();
+    owned->add(objects[0]);
+    owned->add(objects[3]);
+    int count = 0;
+    for(sp::P<PVectorTestObject> obj : *owned)
+    {
+        count++;
+        delete owned;
+    }
+    CHECK(count == 1);
+
+    for(sp::P<PVectorTestObject> obj : list)
+        obj.destroy();
+    CHECK(list.empty());
+}
+
+TEST_CASE("pointer vector objects in multiple vectors")
+{
+    sp::PVector<PVectorTestObject> a;
+    sp::PVector<PVectorTestObject> b;
+    std::vector<sp::P<PVectorTestObject>> objects;
+    for(int n=1; n<=6; n++)
+    {
+        objects.push_back(new PVectorTestObject(n));
+        a.add(objects.back());
+        if (n % 2)
+            b.add(objects.back());
+    }
+    b.add(objects[0]);
+    CHECK(sum(a) == 21);
+    CHECK(sum(b) == 10);
+    CHECK(b.size() == 4);
+
+    //Removing from one vector leaves the other vector alone, and removes all entries of the object.
+    b.remove(objects[0]);
+    CHECK(sum(a) == 21);
+    CHECK(sum(b) == 8);
+    CHECK(b.size() == 2);
+
+    //Sorting and compacting move entries, deleting objects afterwards still finds them.
+    a.sort([](const sp::P<PVectorTestObject>& x, const sp::P<PVectorTestObject>& y) { return y->value - x->value; });
+    CHECK((*a.begin())->value == 6);
+    objects[1].destroy();
+    objects[4].destroy();
+    CHECK(sum(a) == 14);
+    CHECK(sum(b) == 3);
+    CHECK(a.size() == 4);
+    objects[2].destroy();
+    CHECK(sum(a) == 11);
+    CHECK(b.empty());
+
+    //Destroying a vector unlinks its entries from the objects.
+    sp::PVector<PVectorTestObject>* c = new sp::PVector<PVectorTestObject>();
+    c->add(objects[0]);
+    c->add(objects[3]);
+    delete c;
+    a.clear();
+    CHECK(a.empty());
+    for(auto& obj : objects)
+        obj.destroy();
+}
+
+template<class Container> static int count(const Container& container)
+{
+    int result = 0;
+    for(auto it = container.begin(); it != container.end(); ++it)
+        result++;
+    return result;
+}
+
+template<class Container> static void benchmark(const char* name)
+{
+    constexpr int object_count = 10000;
+    std::vector<PVectorTestObject*> objects;
+    for(int n=0; n<object_count; n++)
+        objects.push_back(new PVectorTestObject(1));
+
+    Container list;
+    auto start = std::chrono::steady_clock::now();
+    for(auto obj : objects)
+        list.add(obj);
+    std::chrono::duration<double> insert_time = std::chrono::steady_clock::now() - start;
+
+    int total = 0;
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<100; n++)
+        total += sum(list);
+    std::chrono::duration<double> iterate_time = std::chrono::steady_clock::now() - start;
+    CHECK(total == object_count * 100);
+
+    //Walking the list without taking a reference to every object, which shows the cost of the list itself.
+    total = 0;
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<100; n++)
+        total += count(list);
+    std::chrono::duration<double> walk_time = std::chrono::steady_clock::now() - start;
+    CHECK(total == object_count * 100);
+
+    //Delete every other object while iterating, then keep adding and deleting objects.
+    start = std::chrono::steady_clock::now();
+    int index = 0;
+    for(sp::P<PVectorTestObject> obj : list)
+        if (index++ % 2)
+            obj.destroy();
+    for(int n=0; n<object_count; n++)
+    {
+        PVectorTestObject* obj = new PVectorTestObject(1);
+        list.add(obj);
+        if (n % 4)
+            delete obj;
+    }
+    std::chrono::duration<double> churn_time = std::chrono::steady_clock::now() - start;
+    CHECK(list.size() == object_count / 2 + object_count / 4);
+
+    //After the churn, list entries and objects are no longer allocated in order.
+    total = 0;
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<100; n++)
+        total += sum(list);
+    std::chrono::duration<double> churned_iterate_time = std::chrono::steady_clock::now() - start;
+    CHECK(total == (object_count / 2 + object_count / 4) * 100);
+
+    MESSAGE(std::string(name) << ": insert " << insert_time.count() * 1000.0 << "ms, 100x iterate " << iterate_time.count() * 1000.0 << "ms, 100x walk " << walk_time.count() * 1000.0 << "ms, delete churn " << churn_time.count() * 1000.0 << "ms, 100x iterate after churn " << churned_iterate_time.count() * 1000.0 << "ms");
+    for(sp::P<PVectorTestObject> obj : list)
+        obj.destroy();
+}
+
+TEST_CASE("pointer vector benchmark")
+{
+    benchmark<sp::PList<PVectorTestObject>>("PList");
+    benchmark<sp::PVector<PVectorTestObject>>("PVector");
+}
@@ -0,0 +1,327 @@
+#include <sp2/graphics/scene/basicnoderenderpass.h>
+#include <sp2/graphics/meshdata.h>
+#include <sp2/scene/scene.h>
+#include <sp2/scene/camera.h>
+#include <sp2/graphics/nullOpenGL.h>
+#include <sp2/io/internalResourceProvider.h>
+#include "doctest.h"
+
+#include <chrono>
+#include <algorithm>
+
+//Shaders only allow batching and static merging when they opt in.
+static sp::Shader* getBatchingShader(const sp::string& name)
+{
+    std::map<sp::string, sp::string> resources;
+    resources[name + ".shader"] = "[BATCHING]\n[VERTEX]\nvoid main() {}\n[FRAGMENT]\nvoid main() {}\n";
+    sp::P<sp::io::ResourceProvider> provider = new sp::io::InternalResourceProvider(std::move(resources));
+    sp::Shader* shader = sp::Shader::get("internal:" + name + ".shader");
+    provider.destroy();
+    return shader;
+}
+
+TEST_CASE("frustum")
+{
+    sp::Frustumf frustum(sp::Matrix4x4f::ortho(-10, 10, -10, 10, -10, 10));
+    CHECK(frustum.test(sp::Vector3f(0, 0, 0), 1) == sp::Frustumf::Result::Inside);
+    CHECK(frustum.test(sp::Vector3f(10, 0, 0), 1) == sp::Frustumf::Result::Intersect);
+    CHECK(frustum.test(sp::Vector3f(12, 0, 0), 1) == sp::Frustumf::Result::Outside);
+    CHECK(frustum.test(sp::Vector3f(0, -12, 0), 1) == sp::Frustumf::Result::Outside);
+
+    frustum = sp::Frustumf(sp::Matrix4x4f::perspective(90, 1, 1, 100));
+    CHECK(frustum.test(sp::Vector3f(0, 0, -50), 1) == sp::Frustumf::Result::Inside);
+    CHECK(frustum.test(sp::Vector3f(0, 0, 50), 1) == sp::Frustumf::Result::Outside);
+    CHECK(frustum.test(sp::Vector3f(80, 0, -50), 1) == sp::Frustumf::Result::Outside);
+}
+
+TEST_CASE("render pass culling")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("culling_test");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setOrtographic(10.0);
+    scene->setDefaultCamera(camera);
+
+    auto mesh = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    //A 21x21 grid of quads around the camera, of which 9x9 are in view.
+    for(int x=-10; x<=10; x++)
+    {
+        for(int y=-10; y<=10; y++)
+        {
+            sp::P<sp::Node> node = new sp::Node(scene->getRoot());
+            node->setPosition(sp::Vector2d(x * 2.5, y * 2.5));
+            node->render_data.type = sp::RenderData::Type::Normal;
+            node->render_data.mesh = mesh;
+        }
+    }
+    //A group with 100 children far outside the view, which should be skipped as a whole.
+    sp::P<sp::Node> group = new sp::Node(scene->getRoot());
+    group->setPosition(sp::Vector2d(100, 0));
+    for(int n=0; n<100; n++)
+    {
+        sp::P<sp::Node> node = new sp::Node(group);
+        node->setPosition(sp::Vector2d(0, n));
+        node->render_data.type = sp::RenderData::Type::Normal;
+        node->render_data.mesh = mesh;
+    }
+
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    sp::BasicNodeRenderPass pass;
+    pass.render(queue);
+    CHECK(pass.getCullingStats().visible == 9 * 9);
+    CHECK(pass.getCullingStats().culled == 21 * 21 - 9 * 9);
+    CHECK(pass.getCullingStats().culled_subtrees == 1);
+
+    //Moving the group into view updates the cached bounds.
+    group->setPosition(sp::Vector2d(0, -50));
+    pass.render(queue);
+    CHECK(pass.getCullingStats().visible == 9 * 9 + 21);
+    CHECK(pass.getCullingStats().culled_subtrees == 0);
+
+    //A node in a culled subtree that gets a bigger mesh needs to update the bounds manually.
+    group->setPosition(sp::Vector2d(100, 0));
+    sp::P<sp::Node> big = new sp::Node(group);
+    big->setPosition(sp::Vector2d(-100, 100));
+    pass.render(queue);
+    CHECK(pass.getCullingStats().culled_subtrees == 1);
+    big->render_data.mesh = sp::MeshData::createQuad(sp::Vector2f(300, 300));
+    big->invalidateRenderBounds();
+    pass.render(queue);
+    CHECK(pass.getCullingStats().culled_subtrees == 0);
+    CHECK(pass.getCullingStats().visible == 9 * 9 + 1);
+
+    pass.setCulling(false);
+    pass.render(queue);
+    CHECK(pass.getCullingStats().visible == 21 * 21 + 101);
+
+    scene.destroy();
+}
+
+TEST_CASE("static render batching")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("static_batch_test");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setOrtographic(10.0);
+    scene->setDefaultCamera(camera);
+
+    sp::Shader* shader = getBatchingShader("static_batch_test_shader");
+    auto mesh = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    sp::P<sp::Node> level = new sp::Node(scene->getRoot());
+    std::vector<sp::P<sp::Node>> nodes;
+    for(int x=-10; x<=10; x++)
+    {
+        for(int y=-10; y<=10; y++)
+        {
+            sp::P<sp::Node> node = new sp::Node(level);
+            node->setPosition(sp::Vector2d(x, y));
+            node->render_data.type = sp::RenderData::Type::Normal;
+            node->render_data.shader = shader;
+            node->render_data.mesh = mesh;
+            nodes.push_back(node);
+        }
+    }
+    //A different type and a dynamic mesh, which end up in a separate merged mesh and unmerged.
+    nodes.back()->render_data.type = sp::RenderData::Type::Transparent;
+    nodes[1]->render_data.mesh = sp::MeshData::create(sp::MeshData::Vertices(mesh->getVertices()), sp::MeshData::Indices(mesh->getIndices()), sp::MeshData::Type::Dynamic);
+    level->setRenderStatic(true);
+
+    const sp::Node::StaticRenderData& data = level->getStaticRenderData();
+    CHECK(data.merged.size() == 2);
+    CHECK(data.unmerged.size() == 1);
+    CHECK(data.merged[1].mesh->getVertices().size() == 4);
+    std::shared_ptr<sp::MeshData> merged = data.merged[0].mesh;
+    CHECK(merged->getVertices().size() == 439 * 4);
+    CHECK(merged->getBoundingSphereRadius() > 14.0f);
+
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    sp::BasicNodeRenderPass pass;
+    pass.render(queue);
+    CHECK(pass.getCullingStats().visible == 3);
+
+    //Moving the static node itself does not need the meshes to be merged again.
+    level->setPosition(sp::Vector2d(0.5, 0));
+    pass.render(queue);
+    CHECK(level->getStaticRenderData().merged[0].mesh == merged);
+
+    //But moving, adding or destroying a node inside the subtree does.
+    nodes[100]->setPosition(sp::Vector2d(100, 0));
+    pass.render(queue);
+    CHECK(level->getStaticRenderData().merged[0].mesh != merged);
+    CHECK(level->getStaticRenderData().merged[0].mesh->getBoundsMax().x == doctest::Approx(100.5));
+    nodes[100].destroy();
+    pass.render(queue);
+    CHECK(level->getStaticRenderData().merged[0].mesh->getVertices().size() == 438 * 4);
+
+    level->setRenderStatic(false);
+    pass.render(queue);
+    CHECK(pass.getCullingStats().visible == 440);
+
+    scene.destroy();
+}
+
+TEST_CASE("static render batching benchmark")
+{
+    constexpr int node_count = 20000;
+    constexpr int frames = 20;
+
+    sp::NullOpenGL::install();
+    sp::P<sp::Scene> scene = new sp::Scene("static_batch_benchmark");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setPosition(sp::Vector2d(100, 50));
+    camera->setOrtographic(150.0);
+    scene->setDefaultCamera(camera);
+
+    sp::Shader* shader = getBatchingShader("static_batch_benchmark_shader");
+    auto mesh = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    sp::P<sp::Node> level = new sp::Node(scene->getRoot());
+    for(int n=0; n<node_count; n++)
+    {
+        sp::P<sp::Node> node = new sp::Node(level);
+        node->setPosition(sp::Vector2d(n % 200, n / 200));
+        node->render_data.type = sp::RenderData::Type::Normal;
+        node->render_data.shader = shader;
+        node->render_data.mesh = mesh;
+    }
+
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    sp::BasicNodeRenderPass pass;
+    auto run = [&](double& build_time, double& total_time)
+    {
+        //The first frame merges the static meshes.
+        pass.render(queue);
+        queue.render();
+        sp::NullOpenGL::resetStatistics();
+        std::chrono::duration<double> build(0);
+        auto start = std::chrono::steady_clock::now();
+        for(int n=0; n<frames; n++)
+        {
+            auto build_start = std::chrono::steady_clock::now();
+            pass.render(queue);
+            build += std::chrono::steady_clock::now() - build_start;
+            queue.render();
+        }
+        std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+        build_time = build.count() * 1000.0 / frames;
+        total_time = total.count() * 1000.0 / frames;
+        return sp::NullOpenGL::getStatistics().draw_calls / frames;
+    };
+
+    double build_time[3], total_time[3];
+    queue.setBatching(0, 0);
+    int separate_draws = run(build_time[0], total_time[0]);
+    queue.setBatching(128, 16384);
+    int dynamic_draws = run(build_time[1], total_time[1]);
+    level->setRenderStatic(true);
+    int static_draws = run(build_time[2], total_time[2]);
+
+    MESSAGE(node_count << " quads: separate " << separate_draws << " draws, " << build_time[0] << "ms queue build, " << total_time[0] << "ms per frame; "
+        << "dynamic batching " << dynamic_draws << " draws, " << build_time[1] << "ms queue build, " << total_time[1] << "ms per frame; "
+        << "static " << static_draws << " draws, " << build_time[2] << "ms queue build, " << total_time[2] << "ms per frame");
+    CHECK(separate_draws == node_count);
+    //The 80000 merged vertices need 32 bit indices, or are drawn in two parts.
+    CHECK(level->getStaticRenderData().merged.size() == 1);
+    CHECK(static_draws == level->getStaticRenderData().merged[0].mesh->getDrawCount());
+    CHECK(static_draws < dynamic_draws);
+
+    scene.destroy();
+}
+
+TEST_CASE("threaded render pass")
+{
+    sp::NullOpenGL::install();
+    sp::P<sp::Scene> scene = new sp::Scene("threaded_pass_test");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setOrtographic(20.0);
+    scene->setDefaultCamera(camera);
+
+    std::vector<int> calls;
+    //Adds a function call for some of the nodes, which splits the sorting of the queue.
+    class FunctionPass : public sp::BasicNodeRenderPass
+    {
+    public:
+        std::vector<int>* calls;
+    protected:
+        void addNodeToRenderQueue(sp::RenderQueue& queue, sp::P<sp::Node>& node) override
+        {
+            sp::BasicNodeRenderPass::addNodeToRenderQueue(queue, node);
+            int id = int(node->getPosition2D().x * 1000 + node->getPosition2D().y);
+            if (id % 7 == 0)
+            {
+                std::vector<int>* target = calls;
+                queue.add([target, id]() { target->push_back(id); });
+            }
+        }
+    };
+
+    sp::Shader* shaders[2] = {getBatchingShader("threaded_pass_test_a"), getBatchingShader("threaded_pass_test_b")};
+    auto mesh = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    for(int g=0; g<6; g++)
+    {
+        sp::P<sp::Node> group = new sp::Node(scene->getRoot());
+        //One group is out of view, one is merged into a static mesh.
+        group->setPosition(sp::Vector2d(g == 5 ? 100 : 0, 0));
+        for(int n=0; n<60; n++)
+        {
+            sp::P<sp::Node> node = new sp::Node(group);
+            node->setPosition(sp::Vector2d(g * 3 + n % 3, n / 3 - 10));
+            node->render_data.type = n % 5 == 0 ? sp::RenderData::Type::Transparent : sp::RenderData::Type::Normal;
+            node->render_data.shader = shaders[(n / 4) % 2];
+            node->render_data.mesh = mesh;
+            for(int c=0; c<n % 3; c++)
+                new sp::Node(node);
+        }
+        if (g == 4)
+            group->setRenderStatic(true);
+    }
+
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    FunctionPass pass;
+    pass.calls = &calls;
+    auto run = [&](std::vector<sp::NullOpenGL::Command>& commands, sp::BasicNodeRenderPass::CullingStats& stats)
+    {
+        calls.clear();
+        pass.render(queue);
+        stats = pass.getCullingStats();
+        sp::NullOpenGL::clearCommands();
+        sp::NullOpenGL::setRecording(true);
+        queue.render();
+        sp::NullOpenGL::setRecording(false);
+        commands = sp::NullOpenGL::getCommands();
+        sp::NullOpenGL::clearCommands();
+    };
+    std::vector<sp::NullOpenGL::Command> single, threaded;
+    sp::BasicNodeRenderPass::CullingStats single_stats, threaded_stats;
+    run(single, single_stats);
+    run(single, single_stats);
+    std::vector<int> single_calls = calls;
+    pass.setThreaded(true);
+    run(threaded, threaded_stats);
+
+    CHECK(single_stats.visible > 200);
+    CHECK(single_stats.culled_subtrees == 1);
+    CHECK(threaded_stats.visible == single_stats.visible);
+    CHECK(threaded_stats.culled == single_stats.culled);
+    CHECK(threaded_stats.culled_subtrees == single_stats.culled_subtrees);
+    CHECK(threaded_stats.triangles == single_stats.triangles);
+    CHECK(calls.size() > 20);
+    CHECK(calls == single_calls);
+    CHECK(sp::NullOpenGL::getStatistics().draw_calls > 0);
+    CHECK(threaded.size() == single.size());
+    for(size_t n=0; n<std::min(single.size(), threaded.size()); n++)
+    {
+        CHECK(std::string(threaded[n].function) == std::string(single[n].function));
+        //Batches are streamed into a ring of buffers, so the bound buffer differs between frames.
+        int arguments = std::string(single[n].function) == "glBindBuffer" ? 1 : 4;
+        for(int a=0; a<arguments; a++)
+            CHECK(threaded[n].arguments[a] == single[n].arguments[a]);
+    }
+
+    scene.destroy();
+}
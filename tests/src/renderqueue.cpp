@@ -0,0 +1,260 @@
+#include <sp2/graphics/scene/renderqueue.h>
+#include <sp2/graphics/shader.h>
+#include <sp2/graphics/meshdata.h>
+#include <sp2/graphics/texture.h>
+#include <sp2/graphics/glState.h>
+#include <sp2/graphics/opengl.h>
+#include <sp2/graphics/nullOpenGL.h>
+#include <sp2/io/internalResourceProvider.h>
+#include "doctest.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+TEST_CASE("render queue ordering")
+{
+    //Shaders that do not exist do not touch OpenGL, and Custom items without a mesh only call their function.
+    sp::Shader* shader_a = sp::Shader::get("renderqueue_test_a");
+    sp::Shader* shader_b = sp::Shader::get("renderqueue_test_b");
+    std::vector<int> calls;
+    sp::RenderQueue queue;
+    auto add = [&](int order, sp::Shader* shader, float z, int id)
+    {
+        sp::RenderData data;
+        data.type = sp::RenderData::Type::Custom1;
+        data.order = order;
+        data.shader = shader;
+        queue.add(sp::Matrix4x4f::translate(0, 0, z), data, [&calls, id]() { calls.push_back(id); });
+    };
+
+    //Small lists use the insertion sort, large lists the radix sort, both need to give the same result.
+    for(int count : {10, 1000})
+    {
+        calls.clear();
+        queue.setCamera(sp::Matrix4x4f::identity(), sp::Matrix4x4f::identity());
+        for(int n=0; n<count; n++)
+            add((n * 7) % 5 - 2, n % 2 ? shader_a : shader_b, -float(n % 3), n);
+        queue.add([&calls]() { calls.push_back(-1); });
+        add(-100, shader_a, 0, count);
+        queue.render();
+
+        CHECK(int(calls.size()) == count + 2);
+        if (int(calls.size()) != count + 2)
+            continue;
+        CHECK(calls[count] == -1);
+        CHECK(calls[count + 1] == count);
+        for(int n=1; n<count; n++)
+        {
+            int a = calls[n - 1];
+            int b = calls[n];
+            int order_a = (a * 7) % 5 - 2;
+            int order_b = (b * 7) % 5 - 2;
+            CHECK(order_a <= order_b);
+            if (order_a == order_b)
+            {
+                //Same order groups on shader, and then sorts front to back.
+                sp::Shader* shader_a_ = a % 2 ? shader_a : shader_b;
+                sp::Shader* shader_b_ = b % 2 ? shader_a : shader_b;
+                CHECK(shader_a_->getId() <= shader_b_->getId());
+                if (shader_a_ == shader_b_)
+                    CHECK(a % 3 <= b % 3);
+            }
+        }
+    }
+}
+
+TEST_CASE("render queue front to back")
+{
+    sp::Shader* shader = sp::Shader::get("renderqueue_test_a");
+    std::vector<int> calls;
+    sp::RenderQueue queue;
+    queue.setCamera(sp::Matrix4x4f::identity(), sp::Matrix4x4f::translate(0, 0, -1));
+    //Opaque items only use the top bits of the distance, so these are far enough apart to land in different buckets.
+    for(int n : {2, 0, 3, 1})
+    {
+        sp::RenderData data;
+        data.type = sp::RenderData::Type::Custom1;
+        data.shader = shader;
+        float distance = std::pow(10.0f, float(n));
+        queue.add(sp::Matrix4x4f::translate(0, 0, 1 - distance), data, [&calls, n]() { calls.push_back(n); });
+    }
+    queue.render();
+    CHECK(calls == std::vector<int>{0, 1, 2, 3});
+}
+
+TEST_CASE("render queue draw calls")
+{
+    sp::NullOpenGL::install();
+    std::map<sp::string, sp::string> resources;
+    resources["renderqueue_test.shader"] = "[BATCHING]\n[VERTEX]\nvoid main() {}\n[FRAGMENT]\nvoid main() {}\n";
+    sp::P<sp::io::ResourceProvider> provider = new sp::io::InternalResourceProvider(std::move(resources));
+    sp::Shader* shader = sp::Shader::get("internal:renderqueue_test.shader");
+    provider.destroy();
+
+    auto mesh = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    sp::RenderQueue queue;
+    queue.setBatching(0, 0);
+    auto renderFrame = [&]()
+    {
+        queue.setCamera(sp::Matrix4x4f::identity(), sp::Matrix4x4f::identity());
+        for(int n=0; n<100; n++)
+        {
+            sp::RenderData data;
+            data.type = sp::RenderData::Type::Normal;
+            data.shader = shader;
+            data.mesh = mesh;
+            queue.add(sp::Matrix4x4f::translate(float(n), 0, 0), data);
+        }
+        queue.render();
+    };
+    renderFrame();
+    sp::NullOpenGL::resetStatistics();
+    sp::NullOpenGL::setRecording(true);
+    renderFrame();
+    sp::NullOpenGL::setRecording(false);
+
+    CHECK(sp::NullOpenGL::getStatistics().draw_calls == 100);
+    //Only the object matrix differs between the items, everything else is still set from the previous frame.
+    CHECK(sp::NullOpenGL::getStatistics().uniform_uploads == 100);
+    CHECK(sp::NullOpenGL::countCommands("glUseProgram") == 0);
+    CHECK(sp::NullOpenGL::countCommands("glBlendFunc") == 0);
+    CHECK(sp::GLState::getStatistics().elided > 0);
+    sp::NullOpenGL::clearCommands();
+}
+
+class BatchTestTexture : public sp::Texture
+{
+public:
+    BatchTestTexture() : sp::Texture(Type::Static, "batch_test") {}
+
+    virtual void bind() override {}
+};
+
+TEST_CASE("render queue batching")
+{
+    sp::NullOpenGL::install();
+    sp::Shader* shader = sp::Shader::get("internal:renderqueue_test.shader");
+    BatchTestTexture texture_a, texture_b;
+    sp::Texture* textures[] = {&texture_a, &texture_b};
+    auto quad = sp::MeshData::createQuad(sp::Vector2f(1, 1));
+    auto circle = sp::MeshData::createCircle(1.0, 200);
+
+    sp::RenderQueue queue;
+    auto drawCalls = [&](int count, std::function<void(int, sp::RenderData&)> setup)
+    {
+        sp::NullOpenGL::resetStatistics();
+        queue.setCamera(sp::Matrix4x4f::identity(), sp::Matrix4x4f::identity());
+        for(int n=0; n<count; n++)
+        {
+            sp::RenderData data;
+            data.type = sp::RenderData::Type::Normal;
+            data.shader = shader;
+            data.mesh = quad;
+            setup(n, data);
+            queue.add(sp::Matrix4x4f::translate(float(n), 0, 0), data);
+        }
+        queue.render();
+        return sp::NullOpenGL::getStatistics().draw_calls;
+    };
+
+    CHECK(drawCalls(100, [](int, sp::RenderData&) {}) == 1);
+    //The merged vertices are transformed on the CPU, so the quads are uploaded every frame.
+    CHECK(sp::NullOpenGL::getStatistics().buffer_bytes == 100 * (4 * sizeof(sp::MeshData::Vertex) + 6 * sizeof(uint16_t)));
+    //Items are sorted on texture, so alternating textures still result in one batch per texture.
+    CHECK(drawCalls(100, [&](int n, sp::RenderData& data) { data.texture = textures[n % 2]; }) == 2);
+    CHECK(drawCalls(100, [](int n, sp::RenderData& data) { data.color = sp::Color(1, 1, 1, n < 50 ? 1.0 : 0.5); }) == 2);
+    CHECK(drawCalls(100, [](int n, sp::RenderData& data) { data.type = n % 2 ? sp::RenderData::Type::Normal : sp::RenderData::Type::Additive; }) == 2);
+    //Large meshes are drawn on their own, the sort groups items on mesh so they do not split the batch of quads.
+    CHECK(drawCalls(100, [&](int n, sp::RenderData& data) { if (n == 50) data.mesh = circle; }) == 2);
+    auto dynamic_quad = sp::MeshData::create(sp::MeshData::Vertices(quad->getVertices()), sp::MeshData::Indices(quad->getIndices()), sp::MeshData::Type::Dynamic);
+    CHECK(drawCalls(10, [&](int, sp::RenderData& data) { data.mesh = dynamic_quad; }) == 10);
+    //Shaders without a [BATCHING] line are never batched.
+    sp::Shader* unbatched_shader = sp::Shader::get("renderqueue_test_unbatched");
+    CHECK(drawCalls(10, [&](int, sp::RenderData& data) { data.shader = unbatched_shader; }) == 10);
+
+    //Merged normals would be wrong for non-uniformly scaled items, so those are not batched.
+    CHECK(drawCalls(10, [](int, sp::RenderData& data) { data.scale = sp::Vector3f(1, 2, 1); }) == 10);
+    CHECK(drawCalls(10, [](int, sp::RenderData& data) { data.scale = sp::Vector3f(2, 2, 2); }) == 1);
+
+    //Batches larger than 16 bit indices can address use 32 bit indices when supported.
+    bool element_index_uint = sp::opengl_element_index_uint;
+    sp::opengl_element_index_uint = true;
+    queue.setBatching(16, 100000);
+    CHECK(drawCalls(20000, [](int, sp::RenderData&) {}) == 1);
+    sp::opengl_element_index_uint = element_index_uint;
+
+    queue.setBatching(16, 40);
+    CHECK(drawCalls(100, [](int, sp::RenderData&) {}) == 10);
+    queue.setBatching(0, 0);
+    CHECK(drawCalls(100, [](int, sp::RenderData&) {}) == 100);
+}
+
+TEST_CASE("render queue benchmark")
+{
+    constexpr int item_count = 50000;
+    constexpr int frames = 20;
+
+    std::vector<sp::Shader*> shaders;
+    for(int n=0; n<8; n++)
+        shaders.push_back(sp::Shader::get("renderqueue_benchmark_" + sp::string(n)));
+    std::vector<sp::RenderData> items(item_count);
+    std::vector<sp::Matrix4x4f> transforms;
+    for(int n=0; n<item_count; n++)
+    {
+        items[n].type = sp::RenderData::Type::Custom1;
+        items[n].order = n % 3;
+        items[n].shader = shaders[(n * 13) % shaders.size()];
+        transforms.push_back(sp::Matrix4x4f::translate(float(n % 100), float(n / 100), -float(n % 17)));
+    }
+
+    int calls = 0;
+    //Captures more than fits in the small buffer of std::function, as most callbacks in the engine do.
+    sp::Color color(1, 1, 1);
+    auto function = [&calls, color]() { calls++; };
+    sp::RenderQueue queue;
+    auto renderFrame = [&]()
+    {
+        queue.setCamera(sp::Matrix4x4f::identity(), sp::Matrix4x4f::identity());
+        for(int n=0; n<item_count; n++)
+            queue.add(transforms[n], items[n], function);
+        queue.render();
+    };
+    //The first frame grows the arena and lists to their steady state size.
+    renderFrame();
+    calls = 0;
+    size_t allocations_start = sp::LinearArena::getHeapAllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for(int frame=0; frame<frames; frame++)
+        renderFrame();
+    std::chrono::duration<double> queue_time = std::chrono::steady_clock::now() - start;
+    size_t queue_allocations = sp::LinearArena::getHeapAllocationCount() - allocations_start;
+    CHECK(calls == item_count * frames);
+    CHECK(queue_allocations == 0);
+
+    //The same amount of work sorting the full items with std::sort, as the queue used to do.
+    struct FullItem
+    {
+        sp::Matrix4x4f transform;
+        sp::RenderData data;
+        std::function<void()> function;
+        bool operator<(const FullItem& other) const { return data < other.data; }
+    };
+    std::vector<FullItem> full_items;
+    calls = 0;
+    start = std::chrono::steady_clock::now();
+    for(int frame=0; frame<frames; frame++)
+    {
+        for(int n=0; n<item_count; n++)
+            full_items.push_back({transforms[n], items[n], std::function<void()>(function)});
+        std::sort(full_items.begin(), full_items.end());
+        for(auto& item : full_items)
+            item.function();
+        full_items.clear();
+    }
+    std::chrono::duration<double> full_sort_time = std::chrono::steady_clock::now() - start;
+    CHECK(calls == item_count * frames);
+
+    MESSAGE("RenderQueue " << item_count << " items: " << queue_time.count() * 1000.0 / frames << "ms per frame, std::sort on full items: " << full_sort_time.count() * 1000.0 / frames << "ms per frame");
+}
@@ -0,0 +1,149 @@
+#include <sp2/scene/tilemap.h>
+#include <sp2/scene/scene.h>
+#include <sp2/scene/camera.h>
+#include <sp2/graphics/meshdata.h>
+#include <sp2/graphics/scene/basicnoderenderpass.h>
+#include "doctest.h"
+
+#include <chrono>
+#include <map>
+
+static int countTriangles(sp::P<sp::Tilemap> tilemap)
+{
+    int triangles = 0;
+    for(sp::P<sp::Node> child : tilemap->getChildren())
+        if (child->render_data.mesh)
+            triangles += int(child->render_data.mesh->getIndices().size() / 3);
+    return triangles;
+}
+
+TEST_CASE("tilemap chunks")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("tilemap_chunk_test");
+    sp::P<sp::Tilemap> tilemap = new sp::Tilemap(scene->getRoot(), "", 2.0f, 4);
+    //100x100 tiles around the origin, over 4x4 chunks.
+    for(int y=-50; y<50; y++)
+        for(int x=-50; x<50; x++)
+            tilemap->setTile(sp::Vector2i(x, y), (x + y) & 3);
+    tilemap->onFixedUpdate();
+    CHECK(tilemap->getChildren().size() == 4);
+    CHECK(countTriangles(tilemap) == 100 * 100 * 2);
+
+    //Vertices are relative to the chunk node.
+    for(sp::P<sp::Node> child : tilemap->getChildren())
+    {
+        auto bounds_min = child->render_data.mesh->getBoundsMin();
+        auto bounds_max = child->render_data.mesh->getBoundsMax();
+        sp::Vector2d position = child->getPosition2D();
+        CHECK(bounds_min.x >= 0.0f);
+        CHECK(bounds_min.y >= 0.0f);
+        CHECK(bounds_max.x <= 128.0f);
+        CHECK(bounds_max.y <= 128.0f);
+        CHECK((position.x == -128.0 || position.x == 0.0));
+        CHECK((position.y == -128.0 || position.y == 0.0));
+        if (position.x < 0.0)
+            CHECK(bounds_min.x == 128.0f - 50 * 2);
+        else
+            CHECK(bounds_max.x == 50 * 2);
+    }
+
+    std::map<sp::Node*, int> revisions;
+    for(sp::P<sp::Node> child : tilemap->getChildren())
+        revisions[*child] = child->render_data.mesh->getRevision();
+    auto changedChunks = [&]()
+    {
+        int changed = 0;
+        for(sp::P<sp::Node> child : tilemap->getChildren())
+        {
+            if (child->render_data.mesh && child->render_data.mesh->getRevision() != revisions[*child])
+                changed++;
+            revisions[*child] = child->render_data.mesh ? child->render_data.mesh->getRevision() : 0;
+        }
+        return changed;
+    };
+
+    //A tile edit only remeshes its own chunk.
+    tilemap->setTile(sp::Vector2i(-3, 7), -1);
+    tilemap->onFixedUpdate();
+    CHECK(changedChunks() == 1);
+    CHECK(countTriangles(tilemap) == 100 * 100 * 2 - 2);
+    CHECK(tilemap->getTileIndex(sp::Vector2i(-3, 7)) == -1);
+    tilemap->onFixedUpdate();
+    CHECK(changedChunks() == 0);
+
+    //A tile far away creates a new chunk, which is removed from rendering when its last tile is cleared.
+    tilemap->setTile(sp::Vector2i(1000, 1000), 1);
+    tilemap->onFixedUpdate();
+    CHECK(tilemap->getChildren().size() == 5);
+    CHECK(countTriangles(tilemap) == 100 * 100 * 2);
+    tilemap->setTile(sp::Vector2i(1000, 1000), -1);
+    tilemap->onFixedUpdate();
+    CHECK(countTriangles(tilemap) == 100 * 100 * 2 - 2);
+
+    //Changing the texture layout remeshes every chunk, render settings are copied to the chunk nodes.
+    tilemap->setTilemapSpacingMargin(0.1f, 0.0f);
+    tilemap->render_data.order = 5;
+    tilemap->onFixedUpdate();
+    CHECK(changedChunks() == 4);
+    for(sp::P<sp::Node> child : tilemap->getChildren())
+        CHECK(child->render_data.order == 5);
+
+    scene.destroy();
+}
+
+TEST_CASE("tilemap chunk culling")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("tilemap_culling_test");
+    sp::P<sp::Camera> camera = new sp::Camera(scene->getRoot());
+    camera->setOrtographic(10.0);
+    camera->setPosition(sp::Vector2d(32, 32));
+    scene->setDefaultCamera(camera);
+    sp::P<sp::Tilemap> tilemap = new sp::Tilemap(scene->getRoot(), "", 1.0f, 4);
+    for(int y=0; y<512; y++)
+        for(int x=0; x<512; x++)
+            tilemap->setTile(sp::Vector2i(x, y), 0);
+    tilemap->onFixedUpdate();
+
+    //Only the chunk below the camera is drawn, the other 63 are culled.
+    sp::RenderQueue queue;
+    queue.setTargetAspectSize(1.0);
+    queue.setAspectRatio(1.0);
+    sp::BasicNodeRenderPass pass;
+    pass.render(queue);
+    CHECK(pass.getCullingStats().culled == 63);
+    CHECK(pass.getCullingStats().triangles == 64 * 64 * 2);
+
+    scene.destroy();
+}
+
+TEST_CASE("tilemap edit benchmark")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("tilemap_benchmark");
+    sp::P<sp::Tilemap> tilemap = new sp::Tilemap(scene->getRoot(), "", 1.0f, 16);
+    //A 4096x4096 map with every 4th chunk in both directions filled, a full map takes a few GB in meshes.
+    auto filled = [](int x, int y) { return ((x >> 6) & 3) == 0 && ((y >> 6) & 3) == 0; };
+    for(int y=0; y<4096; y++)
+        for(int x=0; x<4096; x++)
+            if (filled(x, y))
+                tilemap->setTile(sp::Vector2i(x, y), (x * 7 + y * 3) % 256);
+
+    auto start = std::chrono::steady_clock::now();
+    tilemap->onFixedUpdate();
+    auto full_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(tilemap->getChildren().size() == 16 * 16);
+
+    const int edits = 100;
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<edits; n++)
+    {
+        sp::Vector2i position((n * 397) % 4096, (n * 1231) % 4096);
+        position.x &= ~0xc0;
+        position.y &= ~0xc0;
+        tilemap->setTile(position, n % 256);
+        tilemap->onFixedUpdate();
+    }
+    auto edit_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / edits;
+    MESSAGE("4096x4096 map, " << 16 * 16 * 64 * 64 << " tiles in 256 chunks: full mesh " << full_time << "ms, single tile edit " << edit_time << "ms");
+
+    scene.destroy();
+}
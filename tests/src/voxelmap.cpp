@@ -0,0 +1,590 @@
+#include <sp2/scene/voxelmap.h>
+#include <sp2/scene/scene.h>
+#include <sp2/graphics/meshdata.h>
+#include <sp2/threading/jobSystem.h>
+#include <sp2/collision/3d/mesh.h>
+#include "doctest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <cmath>
+#include <tuple>
+#include <string.h>
+
+static int countTriangles(sp::P<sp::Voxelmap> map)
+{
+    int triangles = 0;
+    for(sp::P<sp::Node> child : map->getChildren())
+        if (child->render_data.mesh)
+            triangles += int(child->render_data.mesh->getIndices().size() / 3);
+    return triangles;
+}
+
+TEST_CASE("voxelmap chunks")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_chunk_test");
+    sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 1.0f, 4);
+    map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+    //A solid 32x32x32 cube, split over 2x2x2 chunks.
+    for(int z=0; z<32; z++)
+        for(int y=0; y<32; y++)
+            for(int x=0; x<32; x++)
+                map->setVoxel(sp::Vector3i(x, y, z), 0);
+    map->onFixedUpdate();
+    CHECK(map->getSize() == sp::Vector3i(32, 32, 32));
+    CHECK(map->getChildren().size() == 8);
+    CHECK(countTriangles(map) == 6 * 32 * 32 * 2);
+
+    std::map<sp::Node*, int> revisions;
+    for(sp::P<sp::Node> child : map->getChildren())
+        revisions[*child] = child->render_data.mesh->getRevision();
+    auto changedChunks = [&]()
+    {
+        int changed = 0;
+        for(sp::P<sp::Node> child : map->getChildren())
+        {
+            if (child->render_data.mesh && child->render_data.mesh->getRevision() != revisions[*child])
+                changed++;
+            revisions[*child] = child->render_data.mesh ? child->render_data.mesh->getRevision() : 0;
+        }
+        return changed;
+    };
+
+    //Removing a voxel inside a chunk only remeshes that chunk, and shows the 6 faces around the hole.
+    map->setVoxel(sp::Vector3i(5, 5, 5), -1);
+    map->onFixedUpdate();
+    CHECK(changedChunks() == 1);
+    CHECK(countTriangles(map) == 6 * 32 * 32 * 2 + 6 * 2);
+    CHECK(map->getVoxel(sp::Vector3i(5, 5, 5)) == -1);
+    CHECK(map->isSolid(sp::Vector3i(5, 5, 6)));
+
+    //On the corner where all 8 chunks meet, the hole is visible from 4 chunks.
+    map->setVoxel(sp::Vector3i(5, 5, 5), 0);
+    map->onFixedUpdate();
+    CHECK(changedChunks() == 1);
+    map->setVoxel(sp::Vector3i(16, 16, 16), -1);
+    map->onFixedUpdate();
+    CHECK(changedChunks() == 4);
+    CHECK(countTriangles(map) == 6 * 32 * 32 * 2 + 6 * 2);
+
+    //Setting the same value does not remesh anything.
+    map->setVoxel(sp::Vector3i(0, 0, 0), 0);
+    map->onFixedUpdate();
+    CHECK(changedChunks() == 0);
+
+    //Growing the map keeps the existing voxels.
+    map->setVoxel(sp::Vector3i(40, 0, 0), 0);
+    map->onFixedUpdate();
+    CHECK(map->getSize() == sp::Vector3i(41, 32, 32));
+    CHECK(map->getVoxel(sp::Vector3i(31, 31, 31)) == 0);
+    CHECK(map->getVoxel(sp::Vector3i(16, 16, 16)) == -1);
+    CHECK(map->getVoxel(sp::Vector3i(39, 0, 0)) == -1);
+    CHECK(countTriangles(map) == 6 * 32 * 32 * 2 + 6 * 2 + 6 * 2);
+
+    scene.destroy();
+}
+
+TEST_CASE("voxelmap edit benchmark")
+{
+    constexpr int size = 256;
+    constexpr int height = 64;
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_benchmark");
+    sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 1.0f, 4);
+    map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+    //Rolling terrain, so there are faces on the top and the sides of the hills.
+    for(int y=0; y<size; y++)
+        for(int x=0; x<size; x++)
+            for(int z=0; z<height / 2 + int(std::sin(x * 0.1) * std::cos(y * 0.1) * height / 4); z++)
+                map->setVoxel(sp::Vector3i(x, y, z), 0);
+
+    auto start = std::chrono::steady_clock::now();
+    map->onFixedUpdate();
+    std::chrono::duration<double> full = std::chrono::steady_clock::now() - start;
+
+    constexpr int edits = 100;
+    start = std::chrono::steady_clock::now();
+    for(int n=0; n<edits; n++)
+    {
+        sp::Vector3i position((n * 37) % size, (n * 91) % size, height / 2 - 1);
+        map->setVoxel(position, map->getVoxel(position) < 0 ? 0 : -1);
+        map->onFixedUpdate();
+    }
+    std::chrono::duration<double> edit = std::chrono::steady_clock::now() - start;
+
+    MESSAGE(size << "x" << size << "x" << height << " voxels in " << map->getChildren().size() << " chunks: full mesh " << full.count() * 1000.0 << "ms, single voxel edit " << edit.count() * 1000.0 / edits << "ms");
+    CHECK(edit.count() / edits < full.count() / 20);
+
+    scene.destroy();
+}
+
+//Texture coordinates of a point on one of the quads of the mesh, or false if no quad covers the point with the given normal.
+static bool sampleMesh(sp::MeshData& mesh, bool greedy, int tile_count, sp::Vector3f point, sp::Vector3f normal, sp::Vector2f& result)
+{
+    const auto& vertices = mesh.getVertices();
+    for(size_t n=0; n<vertices.size(); n+=4)
+    {
+        if (vertices[n].normal.normalized().dot(normal) < 0.99f)
+            continue;
+        sp::Vector3f du = vertices[n + 1].position - vertices[n].position;
+        sp::Vector3f dv = vertices[n + 2].position - vertices[n].position;
+        sp::Vector3f d = point - vertices[n].position;
+        if (std::abs(d.dot(normal)) > 0.001f)
+            continue;
+        float a = d.dot(du) / du.dot(du);
+        float b = d.dot(dv) / dv.dot(dv);
+        if (a < 0.0f || a > 1.0f || b < 0.0f || b > 1.0f)
+            continue;
+        sp::Vector2f uv = vertices[n].uv + (vertices[n + 1].uv - vertices[n].uv) * a + (vertices[n + 2].uv - vertices[n].uv) * b;
+        if (greedy)
+        {
+            //Same as the greedy shader: wrap the uv within the tile from the tile attribute.
+            const uint8_t* tile = vertices[n].tile;
+            if (tile[2] != tile_count || tile[3] != tile_count)
+                return false;
+            uv = sp::Vector2f(tile[0] + uv.x - std::floor(uv.x), tile[1] + uv.y - std::floor(uv.y)) / float(tile_count);
+        }
+        result = uv;
+        return true;
+    }
+    return false;
+}
+
+TEST_CASE("voxelmap greedy meshing")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_greedy_test");
+    sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 1.0f, 4);
+    map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+    map->setVoxelData(1, sp::Voxelmap::Data(3, 3, 3));
+    map->setVoxelData(2, sp::Voxelmap::Data(0, 1, 2));
+    sp::Voxelmap::Data slab(5, 6, 7);
+    slab.offset.z = 0.5f;
+    map->setVoxelData(3, slab);
+    //Terrain with a few different blocks and holes, over several chunks.
+    for(int y=0; y<40; y++)
+    {
+        for(int x=0; x<40; x++)
+        {
+            int height = 4 + (x / 8 + y / 5) % 4;
+            for(int z=0; z<height; z++)
+            {
+                if ((x * 7 + y * 13 + z * 3) % 23 == 0)
+                    continue;
+                map->setVoxel(sp::Vector3i(x, y, z), z == height - 1 ? (x % 9 == 0 ? 1 : (y % 11 == 0 ? 3 : 0)) : 2);
+            }
+        }
+    }
+    map->onFixedUpdate();
+
+    std::vector<std::shared_ptr<sp::MeshData>> per_face;
+    int per_face_triangles = 0;
+    for(sp::P<sp::Node> child : map->getChildren())
+    {
+        per_face.push_back(child->render_data.mesh);
+        per_face_triangles += int(child->render_data.mesh->getIndices().size() / 3);
+    }
+    map->setMeshing(sp::Voxelmap::Meshing::Greedy);
+    map->onFixedUpdate();
+    std::vector<std::shared_ptr<sp::MeshData>> greedy;
+    for(sp::P<sp::Node> child : map->getChildren())
+        greedy.push_back(child->render_data.mesh);
+    //The tile is a separate attribute, so the normals are plain unit normals that can be packed.
+    CHECK(greedy[0]->getLayout() == sp::MeshData::Layout::PackedNormalTile);
+    CHECK(greedy[0]->getVertices()[0].normal.length() == doctest::Approx(1.0f));
+    int greedy_triangles = countTriangles(map);
+    MESSAGE("per face " << per_face_triangles << " triangles, greedy " << greedy_triangles << " triangles");
+    CHECK(greedy_triangles * 2 < per_face_triangles);
+
+    //Every face of the per face mesh is covered by a greedy quad, with the same texture coordinates.
+    //And the greedy quads have the same total area, so they do not cover anything else.
+    float per_face_area = 0.0f;
+    float greedy_area = 0.0f;
+    for(auto& mesh : per_face)
+        per_face_area += float(mesh->getVertices().size() / 4);
+    for(auto& mesh : greedy)
+    {
+        const auto& vertices = mesh->getVertices();
+        for(size_t n=0; n<vertices.size(); n+=4)
+            greedy_area += (vertices[n + 1].position - vertices[n].position).length() * (vertices[n + 2].position - vertices[n].position).length();
+    }
+    CHECK(greedy_area == per_face_area);
+    int mismatches = 0;
+    for(size_t m=0; m<per_face.size(); m++)
+    {
+        const auto& vertices = per_face[m]->getVertices();
+        for(size_t n=0; n<vertices.size(); n+=4)
+        {
+            sp::Vector3f normal = vertices[n].normal;
+            for(float a : {0.2f, 0.7f})
+            {
+                for(float b : {0.1f, 0.6f})
+                {
+                    sp::Vector3f point = vertices[n].position + (vertices[n + 1].position - vertices[n].position) * a + (vertices[n + 2].position - vertices[n].position) * b;
+                    sp::Vector2f expected, uv;
+                    sampleMesh(*per_face[m], false, 4, point, normal, expected);
+                    if (!sampleMesh(*greedy[m], true, 4, point, normal, uv) || (uv - expected).length() > 0.0001f)
+                        mismatches++;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    //A floating voxel adds 6 faces in both modes.
+    map->setVoxel(sp::Vector3i(20, 20, 10), 1);
+    map->onFixedUpdate();
+    CHECK(countTriangles(map) == greedy_triangles + 6 * 2);
+    map->setMeshing(sp::Voxelmap::Meshing::PerFace);
+    map->onFixedUpdate();
+    CHECK(countTriangles(map) == per_face_triangles + 6 * 2);
+
+    scene.destroy();
+}
+
+TEST_CASE("voxelmap background meshing")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_background_test");
+    auto createMap = [&]()
+    {
+        sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 0.5f, 4);
+        map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+        map->setVoxelData(1, sp::Voxelmap::Data(3, 3, 3));
+        for(int y=0; y<64; y++)
+            for(int x=0; x<64; x++)
+                for(int z=0; z<8 + (x * y) % 5; z++)
+                    map->setVoxel(sp::Vector3i(x, y, z), (x + z) % 7 == 0 ? 1 : 0);
+        return map;
+    };
+    //Chunk meshes by node position, so maps that created their chunk nodes in a different order can be compared.
+    auto meshes = [](sp::P<sp::Voxelmap> map)
+    {
+        std::map<std::tuple<double, double, double>, std::shared_ptr<sp::MeshData>> result;
+        for(sp::P<sp::Node> child : map->getChildren())
+        {
+            sp::Vector3d p = child->getPosition3D();
+            result[std::make_tuple(p.x, p.y, p.z)] = child->render_data.mesh;
+        }
+        return result;
+    };
+    auto same = [&](sp::P<sp::Voxelmap> a, sp::P<sp::Voxelmap> b)
+    {
+        auto meshes_a = meshes(a);
+        auto meshes_b = meshes(b);
+        if (meshes_a.size() != meshes_b.size())
+            return false;
+        for(auto& it : meshes_a)
+        {
+            auto other = meshes_b[it.first];
+            if (!it.second || !other)
+                return false;
+            const auto& va = it.second->getVertices();
+            const auto& vb = other->getVertices();
+            if (va.size() != vb.size() || memcmp(va.data(), vb.data(), va.size() * sizeof(va[0])) != 0)
+                return false;
+            if (it.second->getIndices() != other->getIndices() || it.second->getLayout() != other->getLayout())
+                return false;
+        }
+        return true;
+    };
+
+    sp::P<sp::Voxelmap> sync_map = createMap();
+    sync_map->onFixedUpdate();
+    sp::P<sp::Voxelmap> async_map = createMap();
+    async_map->setBackgroundMeshing(true);
+    async_map->finishMeshing();
+    CHECK(meshes(sync_map).size() == 16);
+    CHECK(same(sync_map, async_map));
+
+    //Edits while the previous meshes are still being built end up with the same result.
+    for(int n=0; n<20; n++)
+    {
+        for(auto map : {sync_map, async_map})
+        {
+            map->setVoxel(sp::Vector3i((n * 13) % 64, (n * 29) % 64, 7), n % 2 ? -1 : 1);
+            map->onFixedUpdate();
+        }
+    }
+    async_map->finishMeshing();
+    CHECK(same(sync_map, async_map));
+    sync_map->setMeshing(sp::Voxelmap::Meshing::Greedy);
+    sync_map->onFixedUpdate();
+    async_map->setMeshing(sp::Voxelmap::Meshing::Greedy);
+    async_map->finishMeshing();
+    CHECK(same(sync_map, async_map));
+
+    //The upload budget spreads the finished meshes over several updates.
+    async_map->setMeshing(sp::Voxelmap::Meshing::PerFace);
+    async_map->setMeshUploadBudget(1);
+    sync_map->setMeshing(sp::Voxelmap::Meshing::PerFace);
+    sync_map->onFixedUpdate();
+    int updates = 0;
+    int most_changes = 0;
+    auto previous = meshes(async_map);
+    while(!same(sync_map, async_map) && updates < 100000)
+    {
+        async_map->onFixedUpdate();
+        updates++;
+        auto current = meshes(async_map);
+        int changes = 0;
+        for(auto& it : current)
+            if (previous[it.first] != it.second)
+                changes++;
+        most_changes = std::max(most_changes, changes);
+        previous = current;
+    }
+    CHECK(same(sync_map, async_map));
+    CHECK(most_changes == 1);
+
+    scene.destroy();
+}
+
+TEST_CASE("voxelmap raycast and queries")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_query_test");
+    sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 0.5f, 4);
+    map->setPosition(sp::Vector3d(10, -5, 2));
+    map->setRotation(90.0);
+    map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+    sp::Voxelmap::Data ghost(3, 3, 3);
+    ghost.solid = false;
+    map->setVoxelData(1, ghost);
+    for(int z=0; z<40; z++)
+        for(int y=0; y<40; y++)
+            for(int x=0; x<40; x++)
+                if ((x * 31 + y * 17 + z * 7) % 53 == 0 || z < 2)
+                    map->setVoxel(sp::Vector3i(x, y, z), (x + y) % 5 == 0 ? 1 : 0);
+    sp::Matrix4x4f to_local = map->getGlobalTransform().inverse();
+
+    //Reference: the closest solid voxel the ray passes through, by testing the ray against the box of every voxel.
+    auto reference = [&](sp::Ray3d ray, sp::Vector3i& voxel, double& distance)
+    {
+        sp::Vector3d start = sp::Vector3d(to_local * sp::Vector3f(ray.start)) / 0.5;
+        sp::Vector3d end = sp::Vector3d(to_local * sp::Vector3f(ray.end)) / 0.5;
+        sp::Vector3i start_voxel(std::floor(start.x), std::floor(start.y), std::floor(start.z));
+        const double s[3] = {start.x, start.y, start.z};
+        const double d[3] = {end.x - start.x, end.y - start.y, end.z - start.z};
+        double best = 2.0;
+        for(int z=0; z<40; z++)
+        {
+            for(int y=0; y<40; y++)
+            {
+                for(int x=0; x<40; x++)
+                {
+                    if (!map->isSolid(sp::Vector3i(x, y, z)) || sp::Vector3i(x, y, z) == start_voxel)
+                        continue;
+                    const int p[3] = {x, y, z};
+                    double t0 = 0.0, t1 = 1.0;
+                    for(int axis=0; axis<3; axis++)
+                    {
+                        double a = (p[axis] - s[axis]) / d[axis];
+                        double b = (p[axis] + 1 - s[axis]) / d[axis];
+                        t0 = std::max(t0, std::min(a, b));
+                        t1 = std::min(t1, std::max(a, b));
+                    }
+                    if (t0 <= t1 && t0 < best)
+                    {
+                        best = t0;
+                        voxel = sp::Vector3i(x, y, z);
+                    }
+                }
+            }
+        }
+        distance = best * (ray.end - ray.start).length();
+        return best <= 1.0;
+    };
+
+    int hits = 0;
+    int mismatches = 0;
+    for(int n=0; n<300; n++)
+    {
+        //Rays from above and from the sides, starting inside and outside the map, but not on a voxel border.
+        sp::Vector3d start(-9.63 + (n * 7919) % 19, -4.21 + (n * 104729) % 19, 3.13 + (n * 13) % 25);
+        sp::Vector3d end = start + sp::Vector3d(std::sin(n * 0.7) * 20.0, std::cos(n * 1.3) * 20.0, -5.0 - (n % 7) * 3.0);
+        sp::Ray3d ray(start, end);
+        sp::Voxelmap::RayHit hit;
+        sp::Vector3i expected_voxel;
+        double expected_distance;
+        bool expected = reference(ray, expected_voxel, expected_distance);
+        bool found = map->raycast(ray, hit);
+        if (found != expected)
+        {
+            mismatches++;
+            continue;
+        }
+        if (!found)
+            continue;
+        hits++;
+        if (hit.voxel != expected_voxel || std::abs(hit.distance - expected_distance) > 0.0001)
+            mismatches++;
+        //The hit point lies on the reported face, and the normal points back against the ray.
+        sp::Vector3d hit_point = start + (end - start).normalized() * hit.distance;
+        sp::Vector3d local = sp::Vector3d(to_local * sp::Vector3f(hit_point)) / 0.5;
+        sp::Vector3d local_normal = sp::Vector3d(to_local.applyDirection(sp::Vector3f(hit.normal)));
+        sp::Vector3d face_center = sp::Vector3d(hit.voxel.x + 0.5, hit.voxel.y + 0.5, hit.voxel.z + 0.5) + local_normal * 0.5;
+        if (std::abs((local - face_center).dot(local_normal)) > 0.001 || hit.normal.dot(end - start) >= 0.0)
+            mismatches++;
+    }
+    CHECK(hits > 150);
+    CHECK(mismatches == 0);
+
+    //Rays that miss the map entirely, or are too short to reach it.
+    sp::Voxelmap::RayHit hit;
+    CHECK(!map->raycast(sp::Ray3d(sp::Vector3d(100, 100, 100), sp::Vector3d(100, 100, -100)), hit));
+    //Straight down on a column that only has the floor, which is 2 voxels thick on a map placed at z=2.
+    auto onlyFloor = [&](int x)
+    {
+        for(int z=0; z<40; z++)
+            if ((z < 2) != map->isSolid(sp::Vector3i(x, 10, z)))
+                return false;
+        return true;
+    };
+    int column = 0;
+    while(!onlyFloor(column))
+        column++;
+    CHECK(column < 40);
+    sp::Vector3d top = sp::Vector3d(map->getGlobalTransform() * sp::Vector3f((column + 0.5f) * 0.5f, 10.5f * 0.5f, 0.0f));
+    top.z = 30;
+    CHECK(!map->raycast(sp::Ray3d(top, top - sp::Vector3d(0, 0, 10)), hit));
+    CHECK(map->raycast(sp::Ray3d(top, top - sp::Vector3d(0, 0, 50)), hit));
+    CHECK(hit.voxel == sp::Vector3i(column, 10, 1));
+    CHECK(hit.face == sp::Voxelmap::Face::Up);
+    CHECK(hit.normal.z == doctest::Approx(1.0));
+    CHECK(hit.distance == doctest::Approx(30 - 3));
+
+    auto collect = [](std::vector<sp::Vector3i>& result)
+    {
+        return [&result](sp::Vector3i position) { result.push_back(position); return true; };
+    };
+    auto sorted = [](std::vector<sp::Vector3i> v)
+    {
+        std::sort(v.begin(), v.end(), [](const sp::Vector3i& a, const sp::Vector3i& b) { return std::make_tuple(a.x, a.y, a.z) < std::make_tuple(b.x, b.y, b.z); });
+        return v;
+    };
+    std::vector<sp::Vector3i> found, expected;
+    //The map is rotated by 90 degrees, so the box is still a box in voxel coordinates.
+    sp::Vector3d box_min(5.2, -4.3, 2.0), box_max(9.0, 0.9, 4.6);
+    map->queryBox(box_min, box_max, collect(found));
+    sp::Vector3d a = sp::Vector3d(to_local * sp::Vector3f(box_min)) / 0.5;
+    sp::Vector3d b = sp::Vector3d(to_local * sp::Vector3f(box_max)) / 0.5;
+    sp::Vector3d local_min(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+    sp::Vector3d local_max(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+    for(int z=0; z<40; z++)
+        for(int y=0; y<40; y++)
+            for(int x=0; x<40; x++)
+                if (map->isSolid(sp::Vector3i(x, y, z)) && x + 1 > local_min.x && x < local_max.x && y + 1 > local_min.y && y < local_max.y && z + 1 > local_min.z && z < local_max.z)
+                    expected.push_back(sp::Vector3i(x, y, z));
+    CHECK(found.size() > 10);
+    CHECK(sorted(found) == sorted(expected));
+
+    found.clear();
+    expected.clear();
+    sp::Vector3d center(5, 0, 5);
+    map->querySphere(center, 4.0, collect(found));
+    sp::Vector3d local_center = sp::Vector3d(to_local * sp::Vector3f(center)) / 0.5;
+    for(int z=0; z<40; z++)
+    {
+        for(int y=0; y<40; y++)
+        {
+            for(int x=0; x<40; x++)
+            {
+                sp::Vector3d closest(std::max(double(x), std::min(local_center.x, x + 1.0)), std::max(double(y), std::min(local_center.y, y + 1.0)), std::max(double(z), std::min(local_center.z, z + 1.0)));
+                if (map->isSolid(sp::Vector3i(x, y, z)) && (closest - local_center).length() < 8.0)
+                    expected.push_back(sp::Vector3i(x, y, z));
+            }
+        }
+    }
+    CHECK(found.size() > 10);
+    CHECK(sorted(found) == sorted(expected));
+
+    //Returning false stops the query.
+    int count = 0;
+    map->querySphere(center, 4.0, [&count](sp::Vector3i) { count++; return false; });
+    CHECK(count == 1);
+
+    scene.destroy();
+}
+
+TEST_CASE("voxelmap raycast benchmark")
+{
+    sp::P<sp::Scene> scene = new sp::Scene("voxelmap_raycast_benchmark");
+    sp::P<sp::Voxelmap> map = new sp::Voxelmap(scene->getRoot(), "", 1.0f, 4);
+    map->setVoxelData(0, sp::Voxelmap::Data(0, 1, 2));
+    //Rolling terrain of 128x128 voxels, with a few floating blocks.
+    for(int y=0; y<128; y++)
+    {
+        for(int x=0; x<128; x++)
+        {
+            int height = 8 + int(6.0 * std::sin(x * 0.1) * std::cos(y * 0.13));
+            for(int z=0; z<height; z++)
+                map->setVoxel(sp::Vector3i(x, y, z), 0);
+            if ((x * 7 + y * 13) % 97 == 0)
+                map->setVoxel(sp::Vector3i(x, y, 24), 0);
+        }
+    }
+    map->onFixedUpdate();
+
+    //The same surface as a static triangle mesh in the collision backend.
+    std::vector<sp::collision::Mesh3D::Vector3> vertices;
+    std::vector<int> indices;
+    for(sp::P<sp::Node> child : map->getChildren())
+    {
+        if (!child->render_data.mesh)
+            continue;
+        sp::Vector3f offset(child->getPosition3D());
+        int base = int(vertices.size());
+        for(const auto& v : child->render_data.mesh->getVertices())
+            vertices.emplace_back(sp::collision::Mesh3D::Vector3(v.position + offset));
+        for(auto index : child->render_data.mesh->getIndices())
+            indices.push_back(base + int(index));
+    }
+    sp::collision::Mesh3D shape(std::move(vertices), std::move(indices));
+    shape.type = sp::collision::Shape::Type::Static;
+    sp::P<sp::Node> collision_node = new sp::Node(scene->getRoot());
+    collision_node->setCollisionShape(shape);
+
+    std::vector<sp::Ray3d> rays;
+    for(int n=0; n<2000; n++)
+    {
+        sp::Vector3d start(1 + (n * 7919) % 126, 1 + (n * 104729) % 126, 30);
+        rays.emplace_back(start, start + sp::Vector3d(std::sin(n * 0.7) * 40.0, std::cos(n * 1.3) * 40.0, -40.0));
+    }
+
+    std::vector<double> voxel_distances(rays.size(), -1.0);
+    auto voxel_start = std::chrono::steady_clock::now();
+    for(size_t n=0; n<rays.size(); n++)
+    {
+        sp::Voxelmap::RayHit hit;
+        if (map->raycast(rays[n], hit))
+            voxel_distances[n] = hit.distance;
+    }
+    auto voxel_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - voxel_start).count();
+
+    std::vector<double> mesh_distances(rays.size(), -1.0);
+    auto mesh_start = std::chrono::steady_clock::now();
+    for(size_t n=0; n<rays.size(); n++)
+    {
+        //Hits come sorted by distance, so the first one is the closest.
+        scene->queryCollisionAll(rays[n], [&](sp::P<sp::Node>, sp::Vector3d location, sp::Vector3d)
+        {
+            mesh_distances[n] = (location - rays[n].start).length();
+            return false;
+        });
+    }
+    auto mesh_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mesh_start).count();
+
+    int hits = 0;
+    int mismatches = 0;
+    for(size_t n=0; n<rays.size(); n++)
+    {
+        if (voxel_distances[n] >= 0.0)
+            hits++;
+        if ((voxel_distances[n] < 0.0) != (mesh_distances[n] < 0.0) || std::abs(voxel_distances[n] - mesh_distances[n]) > 0.01)
+            mismatches++;
+    }
+    MESSAGE("Voxelmap raycast: " << rays.size() << " rays, " << hits << " hits, voxel walk " << voxel_time << "ms, collision mesh " << mesh_time << "ms");
+    CHECK(hits > int(rays.size()) / 2);
+    //Rays that graze an edge can hit a neighbouring triangle of the mesh, allow a few.
+    CHECK(mismatches < int(rays.size()) / 100);
+
+    scene.destroy();
+}